@@ -0,0 +1,199 @@
+#include "bench.h"
+
+#include "arena.h"
+#include "budget.h"
+#include "mesh.h"
+#include "rng.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+    // malloc and free, counted, standing in for linearAlloc and linearFree
+    int allocations = 0, releases = 0;
+    void* countedAllocate(size_t bytes)
+    {
+        allocations++;
+        return malloc(bytes);
+    }
+    void countedRelease(void* memory)
+    {
+        releases++;
+        free(memory);
+    }
+    const Allocator counted = {&countedAllocate, &countedRelease};
+
+    // one that has nothing to give
+    void* noAllocate(size_t)
+    {
+        return nullptr;
+    }
+    void noRelease(void*)
+    {
+    }
+
+    // the geometry of a window, as LevelWide::init takes it
+    size_t geometryBytes(int width, int height)
+    {
+        return size_t(Mesh::window(width, height, 0.0f, 0.0f).quads()) * Mesh::QUAD_VERTICES * sizeof(Vertex);
+    }
+
+    bool aligned(const void* memory)
+    {
+        return reinterpret_cast<uintptr_t>(memory) % Arena::ALIGNMENT == 0;
+    }
+
+    // levels of the sizes the menu allows, the way they're played one after another
+    std::vector<size_t> randomLevels(int count, uint64_t seed)
+    {
+        Rng rng(seed);
+        std::vector<size_t> levels;
+        for(int level = 0; level < count; level++)
+            levels.push_back(rng.below(8) == 0 ? Budget::endless().linear : geometryBytes(10 + rng.below(990), 10 + rng.below(990)));
+        return levels;
+    }
+}
+
+int Bench::arena_suite()
+{
+    int failures = 0;
+
+    header("arena: one block for every level");
+    {
+        // what LevelWide does: the biggest reserved once, then each level takes its geometry and gives it back
+        allocations = releases = 0;
+        const std::vector<size_t> levels = randomLevels(1000, 23);
+        size_t biggest = 0;
+        bool all_taken = true, same_start = true;
+        {
+            Arena arena(counted);
+            if(!arena.reserve(Budget::geometry()))
+                all_taken = false;
+            void* first = nullptr;
+            for(const size_t bytes : levels)
+            {
+                biggest = bytes > biggest ? bytes : biggest;
+                Vertex* vertices = arena.reserve(bytes) ? static_cast<Vertex*>(arena.take(bytes)) : nullptr;
+                if(!vertices || !aligned(vertices))
+                {
+                    all_taken = false;
+                    break;
+                }
+                // all of it can be written
+                memset(static_cast<void*>(vertices), 0xAB, bytes);
+                first = first ? first : vertices;
+                same_start = same_start && vertices == first;
+                arena.reset();
+            }
+            if(arena.highWater() < biggest || arena.highWater() > biggest + Arena::ALIGNMENT || arena.used() != 0)
+            {
+                printf("FAIL: the high water mark is %zu bytes, the biggest level took %zu\n", arena.highWater(), biggest);
+                failures++;
+            }
+            if(arena.reservations() != 1)
+            {
+                printf("FAIL: the arena went back to the allocator %d times\n", arena.reservations());
+                failures++;
+            }
+        }
+        if(!all_taken || !same_start)
+        {
+            printf("FAIL: a level didn't get its geometry from the start of the block, aligned to %zu\n", Arena::ALIGNMENT);
+            failures++;
+        }
+        if(allocations != 1 || releases != 1)
+        {
+            printf("FAIL: %zu levels made %d allocations and %d releases, instead of one each\n", levels.size(), allocations, releases);
+            failures++;
+        }
+
+        // without reserving first it grows to the biggest level seen, and no further
+        allocations = releases = 0;
+        {
+            Arena arena(counted);
+            size_t grown = 0;
+            int growths = 0;
+            for(const size_t bytes : levels)
+            {
+                if(bytes > grown)
+                {
+                    grown = bytes;
+                    growths++;
+                }
+                if(!arena.reserve(bytes) || !arena.take(bytes))
+                {
+                    all_taken = false;
+                    break;
+                }
+            }
+            if(!all_taken || arena.reservations() != growths || allocations != growths || releases != growths - 1)
+            {
+                printf("FAIL: growing from nothing took %d allocations, the levels got bigger %d times\n", allocations, growths);
+                failures++;
+            }
+        }
+
+        // buffers taken one after another don't overlap, and what doesn't fit isn't given
+        {
+            Arena arena(Arena::heap);
+            arena.reserve(1000);
+            char* a = static_cast<char*>(arena.take(100));
+            char* b = static_cast<char*>(arena.take(1));
+            char* c = static_cast<char*>(arena.take(arena.capacity()));
+            if(!a || !b || c || !aligned(a) || !aligned(b) || b < a + 100 || arena.highWater() < size_t(b + 1 - a))
+            {
+                printf("FAIL: buffers taken from the arena overlap, or one too big was given\n");
+                failures++;
+            }
+            arena.release();
+            if(arena.take(1) || arena.capacity() != 0)
+            {
+                printf("FAIL: a released arena still gives buffers\n");
+                failures++;
+            }
+        }
+
+        // an allocator with nothing to give leaves an empty arena
+        {
+            Arena arena({&noAllocate, &noRelease});
+            if(arena.reserve(1) || arena.take(1) || arena.reservations() != 0)
+            {
+                printf("FAIL: an arena without memory gave some\n");
+                failures++;
+            }
+        }
+    }
+    printf("%s\n", failures ? "failed" : "ok");
+
+    header("arena: geometry of 1000 levels one after another, us per level");
+    {
+        const std::vector<size_t> levels = randomLevels(1000, 24);
+        volatile uintptr_t sink = 0;
+        const double allocated_us = time_us([&]() {
+            for(const size_t bytes : levels)
+            {
+                void* vertices = malloc(bytes);
+                sink = reinterpret_cast<uintptr_t>(vertices);
+                free(vertices);
+            }
+        });
+        Arena arena(Arena::heap);
+        arena.reserve(Budget::geometry());
+        const double arena_us = time_us([&]() {
+            for(const size_t bytes : levels)
+            {
+                arena.reserve(bytes);
+                sink = reinterpret_cast<uintptr_t>(arena.take(bytes));
+                arena.reset();
+            }
+        });
+        (void)sink;
+        printf("%-28s %10.3f\n", "allocated for each", allocated_us / levels.size());
+        printf("%-28s %10.3f\n", "taken from the arena", arena_us / levels.size());
+        printf("%-28s %10zu\n", "bytes reserved", arena.capacity());
+    }
+
+    return failures;
+}
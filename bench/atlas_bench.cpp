@@ -0,0 +1,122 @@
+#include "bench.h"
+
+#include "atlas.h"
+#include "rng.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    // overlay over base one channel at a time in floats, alpha in the low byte
+    uint32_t overFloat(uint32_t base, uint32_t overlay)
+    {
+        const float alpha = (overlay & 0xFF) / 255.0f;
+        uint32_t out = 0;
+        for(int shift = 0; shift < 32; shift += 8)
+        {
+            const float top = shift ? ((overlay >> shift) & 0xFF) / 255.0f : 1.0f;
+            const float bottom = ((base >> shift) & 0xFF) / 255.0f;
+            out |= uint32_t(lrintf((top * alpha + bottom * (1.0f - alpha)) * 255.0f)) << shift;
+        }
+        return out;
+    }
+
+    bool closeEnough(uint32_t a, uint32_t b)
+    {
+        for(int shift = 0; shift < 32; shift += 8)
+        {
+            if(abs(int((a >> shift) & 0xFF) - int((b >> shift) & 0xFF)) > 1)
+                return false;
+        }
+        return true;
+    }
+}
+
+int Bench::atlas_suite()
+{
+    int failures = 0;
+
+    header("atlas: texel addressing matches the 3DS tiling");
+    {
+        // Z-order inside an 8x8 tile, x in the lowest bit, then tiles in rows
+        const struct {
+            int x, y, width, offset;
+        } known[] = {
+            {1, 0, 8, 1}, {0, 1, 8, 2}, {1, 1, 8, 3}, {2, 0, 8, 4}, {0, 2, 8, 8},
+            {7, 7, 8, 63}, {8, 0, 16, 64}, {0, 8, 16, 128}, {9, 9, 16, 192 + 3},
+        };
+        int bad = 0;
+        for(const auto& k : known)
+            bad += Atlas::texelOffset(k.x, k.y, k.width) != k.offset;
+        // and no two texels of a texture share an offset
+        std::vector<int> seen(128 * 64, 0);
+        for(int y = 0; y < 64; y++)
+            for(int x = 0; x < 128; x++)
+                seen[Atlas::texelOffset(x, y, 128)]++;
+        for(const int count : seen)
+            bad += count != 1;
+        if(bad)
+        {
+            printf("FAIL: %d texel offset(s) wrong\n", bad);
+            failures++;
+        }
+        printf("%s\n", bad ? "failed" : "ok");
+    }
+
+    header("atlas: composed tiles blend the overlay over the base");
+    {
+        Rng rng(1);
+        int bad = 0;
+        for(int i = 0; i < 100000; i++)
+        {
+            const uint32_t base = rng.next();
+            // fully transparent and fully opaque texels are the common case in sprites
+            uint32_t overlay = rng.next();
+            if(i % 4 == 0)
+                overlay &= ~0xFFu;
+            else if(i % 4 == 1)
+                overlay |= 0xFF;
+            bad += !closeEnough(Atlas::over(base, overlay), overFloat(base, overlay));
+        }
+
+        // a 128x64 sheet with sprites at texel (x, y) in the image, composed into a 64x64 texture
+        constexpr int sheet_w = 128, sheet_h = 64, size = 32;
+        std::vector<uint32_t> image(sheet_w * sheet_h), sheet(sheet_w * sheet_h);
+        for(int y = 0; y < sheet_h; y++)
+        {
+            for(int x = 0; x < sheet_w; x++)
+            {
+                image[x + y * sheet_w] = rng.next();
+                sheet[Atlas::texelOffset(x, y, sheet_w)] = image[x + y * sheet_w];
+            }
+        }
+        std::vector<uint32_t> tiles(64 * 64);
+        const int base_x = 32, base_y = 0, overlay_x = 96, overlay_y = 32, dst_x = 32, dst_y = 32;
+        Atlas::compose(sheet.data(), sheet_w, base_x, base_y, overlay_x, overlay_y, tiles.data(), 64, dst_x, dst_y, size);
+        for(int y = 0; y < size; y++)
+        {
+            for(int x = 0; x < size; x++)
+            {
+                const uint32_t expected = overFloat(image[(base_x + x) + (base_y + y) * sheet_w], image[(overlay_x + x) + (overlay_y + y) * sheet_w]);
+                bad += !closeEnough(tiles[Atlas::texelOffset(dst_x + x, dst_y + y, 64)], expected);
+            }
+        }
+
+        if(bad)
+        {
+            printf("FAIL: %d texel(s) blended wrong\n", bad);
+            failures++;
+        }
+        printf("%s\n", bad ? "failed" : "ok");
+
+        // the 12 floor tiles, once per spritesheet load
+        const double compose = time_us([&]() {
+            for(int tile = 0; tile < 12; tile++)
+                Atlas::compose(sheet.data(), sheet_w, base_x, base_y, overlay_x, overlay_y, tiles.data(), 64, dst_x, dst_y, size);
+        });
+        printf("composing the 12 floor tiles: %.1f us\n", compose);
+    }
+
+    return failures;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+
+struct Play;
+struct Vertex;
+
+namespace Bench {
+    using Clock = std::chrono::steady_clock;
+
+    // Runs func repeatedly for at least min_ms milliseconds (and at least once),
+    // returns the average time of one call in microseconds
+    template<typename Func>
+    double time_us(Func&& func, double min_ms = 50.0)
+    {
+        int runs = 0;
+        const auto start = Clock::now();
+        auto now = start;
+        do {
+            func();
+            runs++;
+            now = Clock::now();
+        } while(std::chrono::duration<double, std::milli>(now - start).count() < min_ms);
+        return std::chrono::duration<double, std::micro>(now - start).count() / runs;
+    }
+
+    // Same as above, but setup() runs before each call and is excluded from the timing
+    // (gives up after spending 10 times min_ms in total, when setup() is the expensive part)
+    template<typename Setup, typename Func>
+    double time_us(Setup&& setup, Func&& func, double min_ms = 50.0)
+    {
+        int runs = 0;
+        Clock::duration spent{};
+        const auto begin = Clock::now();
+        do {
+            setup();
+            const auto start = Clock::now();
+            func();
+            spent += Clock::now() - start;
+            runs++;
+        } while(std::chrono::duration<double, std::milli>(spent).count() < min_ms &&
+                std::chrono::duration<double, std::milli>(Clock::now() - begin).count() < min_ms * 10.0);
+        return std::chrono::duration<double, std::micro>(spent).count() / runs;
+    }
+
+    // Sizes and densities covered by every board benchmark, from the menu's limits
+    constexpr short sizes[] = {10, 25, 50, 75, 99};
+    constexpr int densities[] = {10, 20, 30, 40};
+
+    void header(const char* title);
+    // what follows the name of the suite on the command line, nullptr if nothing does
+    extern const char* argument;
+
+    // The settings the menu has, then what it does to a level before it's started (see Play::setUpLevel)
+    void setUpLevel(Play& play, short w, short h, int percent, bool endless, bool no_guess, uint64_t seed);
+    // What MineSweeper does to start it, the geometry going into vertices instead of linear memory
+    void startLevel(Play& play, std::vector<Vertex>& vertices);
+    // The first reveal of a started level the way the player makes it: looking down from where they start, then R,
+    // until the job placing the bombs is done, which the next frame picks up. Where it was is in first_reveal
+    void firstReveal(Play& play);
+
+    // Each suite returns the number of failed checks
+    int board_suite();
+    int flood_suite();
+    int neighbours_suite();
+    int mesh_suite();
+    int culling_suite();
+    int atlas_suite();
+    int budget_suite();
+    int endless_suite();
+    int solver_suite();
+    int worker_suite();
+    int save_suite();
+    int replay_suite();
+    int raster_suite();
+    int profile_suite();
+    int camera_suite();
+    int arena_suite();
+};
@@ -0,0 +1,370 @@
+#include "bench.h"
+
+#include "board.h"
+#include "reference.h"
+#include "rng.h"
+
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    Coord center(const Board& board)
+    {
+        return {short(board.width / 2), short(board.height / 2)};
+    }
+
+    // Same seed, same board; right bomb count; nothing in the safe zone; right neighbour counts
+    int check_generation(short w, short h, int bombs, Coord safe, uint64_t seed)
+    {
+        Board a, b;
+        a.reset(w, h, bombs);
+        b.reset(w, h, bombs);
+        a.generateBombs(safe, seed);
+        b.generateBombs(safe, seed);
+
+        int failures = 0;
+        if(a.mine_bits != b.mine_bits || a.counts != b.counts)
+        {
+            printf("FAIL: %dx%d seed %016llx is not deterministic\n", w, h, (unsigned long long)seed);
+            failures++;
+        }
+
+        int count = 0;
+        for(int y = 0; y < h; y++)
+        {
+            for(int x = 0; x < w; x++)
+            {
+                if(!a.isMine(x + y * w))
+                {
+                    int around = 0;
+                    for(int ny = y - 1; ny <= y + 1; ny++)
+                        for(int nx = x - 1; nx <= x + 1; nx++)
+                            around += nx >= 0 && ny >= 0 && nx < w && ny < h && a.isMine(nx + ny * w);
+                    if(around != a.count(x + y * w))
+                    {
+                        printf("FAIL: %dx%d seed %016llx counts %d bombs around (%d, %d) instead of %d\n", w, h, (unsigned long long)seed, a.count(x + y * w), x, y, around);
+                        failures++;
+                    }
+                    continue;
+                }
+
+                count++;
+                if(abs(x - safe.x) <= 1 && abs(y - safe.y) <= 1)
+                {
+                    printf("FAIL: %dx%d seed %016llx has a bomb at (%d, %d), next to the first click\n", w, h, (unsigned long long)seed, x, y);
+                    failures++;
+                }
+            }
+        }
+        if(count != bombs)
+        {
+            printf("FAIL: %dx%d seed %016llx has %d bombs instead of %d\n", w, h, (unsigned long long)seed, count, bombs);
+            failures++;
+        }
+        return failures;
+    }
+
+    // whether a chord on point would open a bomb: one of the hidden squares around it has one, without a flag
+    bool chordHitsBomb(const Board& board, Coord point)
+    {
+        for(int y = point.y - 1; y <= point.y + 1; y++)
+        {
+            for(int x = point.x - 1; x <= point.x + 1; x++)
+            {
+                const int idx = x + y * board.width;
+                if(x >= 0 && y >= 0 && x < board.width && y < board.height && board.isMine(idx) && !board.isOpen(idx) && !board.isFlagged(idx))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    // A chord on the character board the way a player used to do it: every hidden square around a number with as many flags,
+    // revealed one after the other
+    Board::Outcome referenceChord(Reference::CharBoard& board, Coord point)
+    {
+        const char number = board.visible[point.x + point.y * board.width];
+        if(number < '1' || number > '8')
+            return Board::Outcome::Playing;
+        int flags = 0;
+        for(int y = point.y - 1; y <= point.y + 1; y++)
+            for(int x = point.x - 1; x <= point.x + 1; x++)
+                flags += x >= 0 && y >= 0 && x < board.width && y < board.height && board.visible[x + y * board.width] == 'f';
+        if(flags != number - '0')
+            return Board::Outcome::Playing;
+
+        Board::Outcome outcome = Reference::checkWin(board) ? Board::Outcome::Won : Board::Outcome::Playing;
+        for(int y = point.y - 1; y <= point.y + 1; y++)
+        {
+            for(int x = point.x - 1; x <= point.x + 1; x++)
+            {
+                if(x < 0 || y < 0 || x >= board.width || y >= board.height || board.visible[x + y * board.width] != '.')
+                    continue;
+                const Board::Outcome revealed = Reference::reveal(board, {short(x), short(y)});
+                if(outcome != Board::Outcome::Lost)
+                    outcome = revealed;
+            }
+        }
+        return outcome;
+    }
+
+    // Plays the same random reveals and flags on a board and on the old character board,
+    // and after every one compares the squares, and the counters with full scans
+    int check_counters(uint64_t seed)
+    {
+        Rng rng(seed);
+        const short w = short(10 + rng.below(90));
+        const short h = short(10 + rng.below(90));
+        const int bombs = int(10 + rng.below(31)) * w * h / 100;
+        Board board;
+        board.reset(w, h, bombs);
+        board.generateBombs({short(rng.below(w)), short(rng.below(h))}, seed);
+        Reference::CharBoard reference(board);
+
+        for(int action = 0; action < 4096; action++)
+        {
+            const Coord point = {short(rng.below(w)), short(rng.below(h))};
+            const int pos = point.x + point.y * w;
+            Board::Outcome outcome = Board::Outcome::Playing;
+            if(rng.below(4) == 0)
+            {
+                board.placeFlag(point);
+                Reference::placeFlag(reference, point);
+            }
+            // chords, most of the time after flagging the bombs around like a player would
+            else if(board.isOpen(pos))
+            {
+                if(rng.below(8) != 0)
+                {
+                    for(int y = point.y - 1; y <= point.y + 1; y++)
+                    {
+                        for(int x = point.x - 1; x <= point.x + 1; x++)
+                        {
+                            const Coord around = {short(x), short(y)};
+                            if(x >= 0 && y >= 0 && x < w && y < h && board.isMine(x + y * w) && !board.isFlagged(x + y * w))
+                            {
+                                board.placeFlag(around);
+                                Reference::placeFlag(reference, around);
+                            }
+                        }
+                    }
+                }
+                if(!chordHitsBomb(board, point) || rng.below(64) == 0)
+                {
+                    outcome = board.chord(point);
+                    if(referenceChord(reference, point) != outcome)
+                    {
+                        printf("FAIL: %dx%d seed %016llx action %d: a chord ends differently from revealing around one at a time\n",
+                               w, h, (unsigned long long)seed, action);
+                        return 1;
+                    }
+                }
+            }
+            // like the game: no revealing flags, and mostly avoid bombs so that games get far
+            else if(!board.isFlagged(pos) && (!board.isMine(pos) || rng.below(64) == 0))
+            {
+                outcome = board.reveal(point);
+                Reference::reveal(reference, point);
+            }
+
+            if(Reference::visibleOf(board) != reference.visible)
+            {
+                printf("FAIL: %dx%d seed %016llx action %d: the squares differ from the character board\n", w, h, (unsigned long long)seed, action);
+                return 1;
+            }
+
+            // on a loss every bomb is shown, flagged or not, and the flag count doesn't matter anymore
+            const int flags = outcome == Board::Outcome::Lost ? board.flags_count : board.countFlags();
+            const bool scanned_win = Reference::checkWin(reference);
+            if(board.checkWin() != scanned_win || board.scanWin() != scanned_win ||
+               (outcome == Board::Outcome::Won) != (scanned_win && outcome != Board::Outcome::Lost) || flags != board.flags_count)
+            {
+                printf("FAIL: %dx%d seed %016llx action %d: counters say %s with %d flags, a scan says %s with %d flags\n",
+                       w, h, (unsigned long long)seed, action,
+                       board.checkWin() ? "won" : "not won", board.flags_count,
+                       scanned_win ? "won" : "not won", flags);
+                return 1;
+            }
+            if(outcome != Board::Outcome::Playing)
+                break;
+        }
+        return 0;
+    }
+}
+
+int Bench::board_suite()
+{
+    int failures = 0;
+
+    header("board: generation checks");
+    uint64_t seed = 0;
+    for(const short sz : sizes)
+    {
+        for(const int percent : densities)
+        {
+            const int bombs = percent * sz * sz / 100;
+            // corners, edges and middle, to go through every shape of safe zone
+            const Coord safes[] = {
+                {0, 0}, {short(sz - 1), short(sz - 1)}, {0, short(sz / 2)}, {short(sz / 2), 0}, {short(sz / 2), short(sz / 3)},
+            };
+            for(const Coord safe : safes)
+            {
+                failures += check_generation(sz, sz, bombs, safe, seed++);
+            }
+        }
+    }
+    printf("%s\n", failures ? "failed" : "ok");
+
+    header("board: win and flag counters against a full scan, random games with chords");
+    int counter_failures = 0;
+    for(uint64_t game = 0; game < 500; game++)
+    {
+        counter_failures += check_counters(game);
+    }
+    printf("%s\n", counter_failures ? "failed" : "ok");
+    failures += counter_failures;
+
+    header("board: memory per board");
+    for(const short sz : sizes)
+    {
+        Board board;
+        board.reset(sz, sz, 0);
+        const size_t chars = 3 * sz * sz; // internal, visible and around
+        const size_t planes = (board.mine_bits.size() + board.open_bits.size() + board.flag_bits.size()) * sizeof(Board::Word) + board.counts.size();
+        printf("%3dx%-3d %8zu bytes as characters, %8zu bytes as planes\n", sz, sz, chars, planes);
+    }
+
+    header("board: generation, first click, win check, flag toggle (us per call)");
+    printf("%7s %5s %12s %12s %12s %12s %12s %12s %12s\n", "size", "bombs", "gen (rand)", "generate", "first click", "win (chars)", "win (words)", "win counter", "flag toggle");
+
+    srand(0);
+    for(const short sz : sizes)
+    {
+        for(const int percent : densities)
+        {
+            Board board;
+            const int bombs = percent * sz * sz / 100;
+
+            Reference::CharBoard old(sz, sz, bombs);
+            const double reference = time_us([&]() {
+                Reference::generateBombs(old, {short(sz / 2), short(sz / 2)});
+            });
+
+            const double generate = time_us([&]() {
+                board.reset(sz, sz, bombs);
+                board.generateBombs(center(board), seed++);
+            });
+
+            const double first_click = time_us([&]() {
+                board.reset(sz, sz, bombs);
+                board.generateBombs(center(board), seed++);
+            }, [&]() {
+                board.reveal(center(board));
+            });
+
+            // worst case: every safe square is revealed, so the scans have to go through the whole board
+            Reference::CharBoard solved_chars(board);
+            solved_chars.visible = solved_chars.internal;
+            const double win_chars = time_us([&]() {
+                volatile bool won = Reference::checkWin(solved_chars);
+                (void)won;
+            });
+            Board solved = board;
+            for(size_t w = 0; w < solved.open_bits.size(); w++)
+                solved.open_bits[w] = ~solved.mine_bits[w];
+            solved.hidden_safe = 0;
+            const double win_words = time_us([&]() {
+                volatile bool won = solved.scanWin();
+                (void)won;
+            });
+            const double win_counter = time_us([&]() {
+                volatile bool won = solved.checkWin();
+                (void)won;
+            });
+
+            // flag and unflag a hidden corner, so the board is left unchanged
+            Coord corner = {0, 0};
+            for(int i = 0; i < sz * sz; i++)
+            {
+                if(!board.isOpen(i))
+                {
+                    corner = {short(i % sz), short(i / sz)};
+                    break;
+                }
+            }
+            const double flag_toggle = time_us([&]() {
+                board.placeFlag(corner);
+                board.placeFlag(corner);
+            }) / 2.0;
+
+            printf("%3dx%-3d %5d %12.3f %12.3f %12.3f %12.3f %12.3f %12.4f %12.4f\n", sz, sz, bombs, reference, generate, first_click, win_chars, win_words, win_counter, flag_toggle);
+        }
+    }
+
+    header("board: clearing a board with every bomb flagged, by chords or one square at a time (us per board)");
+    printf("%7s %5s %10s %12s %10s %12s\n", "size", "bombs", "chords", "by chords", "reveals", "one by one");
+    for(const short sz : sizes)
+    {
+        const int bombs = 20 * sz * sz / 100;
+        Board start;
+        start.reset(sz, sz, bombs);
+        start.generateBombs(center(start), seed++);
+        start.reveal(center(start));
+        for(int i = 0; i < sz * sz; i++)
+        {
+            if(start.isMine(i))
+                start.placeFlag({short(i % sz), short(i / sz)});
+        }
+
+        // sweeps over the open numbers until chords open nothing more, keeping the ones that did:
+        // what's left is cut off by bombs, for both ways
+        Board board = start;
+        std::vector<Coord> chords, reveals;
+        for(bool opened = true; opened;)
+        {
+            opened = false;
+            for(int i = 0; i < sz * sz; i++)
+            {
+                if(!board.isOpen(i) || board.count(i) == 0)
+                    continue;
+                const Coord point = {short(i % sz), short(i / sz)};
+                board.chord(point);
+                if(!board.revealed.empty())
+                {
+                    chords.push_back(point);
+                    opened = true;
+                }
+            }
+        }
+        const Board chorded = board;
+        board = start;
+        for(int i = 0; i < sz * sz; i++)
+        {
+            if(chorded.isOpen(i) && !board.isOpen(i))
+            {
+                reveals.push_back({short(i % sz), short(i / sz)});
+                board.reveal(reveals.back());
+            }
+        }
+        if(board.open_bits != chorded.open_bits)
+        {
+            printf("FAIL: %dx%d: chords and reveals one by one don't open the same squares\n", sz, sz);
+            failures++;
+        }
+
+        const double by_chords = time_us([&]() {
+            board = start;
+        }, [&]() {
+            for(const Coord point : chords)
+                board.chord(point);
+        });
+        const double one_by_one = time_us([&]() {
+            board = start;
+        }, [&]() {
+            for(const Coord point : reveals)
+                board.reveal(point);
+        });
+        printf("%3dx%-3d %5d %10zu %12.2f %10zu %12.2f\n", sz, sz, bombs, chords.size(), by_chords, reveals.size(), one_by_one);
+    }
+    return failures;
+}
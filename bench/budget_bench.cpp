@@ -0,0 +1,118 @@
+#include "bench.h"
+
+#include "board.h"
+#include "budget.h"
+#include "culling.h"
+#include "endless.h"
+#include "mesh.h"
+#include "reference.h"
+#include "solver.h"
+
+#include <vector>
+
+namespace {
+    template<typename T>
+    size_t bytes(const std::vector<T>& vector)
+    {
+        return vector.capacity() * sizeof(T);
+    }
+}
+
+int Bench::budget_suite()
+{
+    int failures = 0;
+
+    // what the game holds on to once a level is generated, as the budget counts it
+    header("budget: levels cost what the budget says");
+    const short level_sizes[][2] = {{10, 10}, {99, 99}, {10, 1000}, {Mesh::WINDOW_SIZE, Mesh::WINDOW_SIZE}, {500, 333}, {1000, 1000}};
+    for(const auto& size : level_sizes)
+    {
+        const short w = size[0], h = size[1];
+        Board board;
+        board.reset(w, h, 20 * w * h / 100);
+        board.generateBombs({short(w / 2), short(h / 2)}, 1);
+        const Mesh::Layout window = Mesh::window(w, h, w / 2.0f, h / 2.0f);
+        std::vector<Mesh::Chunk> chunks;
+        Mesh::chunks(window, chunks);
+        std::vector<Culling::Range> ranges;
+        ranges.reserve(chunks.size());
+        std::vector<int> dirty_squares;
+        dirty_squares.reserve(window.width * window.height);
+        Mesh::Floor floor;
+        floor.reset(window);
+
+        const size_t heap = bytes(board.mine_bits) + bytes(board.open_bits) + bytes(board.flag_bits) + bytes(board.counts) +
+                            bytes(board.revealed) + bytes(board.flood_stack) + bytes(board.count_scratch) +
+                            floor.memory() + bytes(ranges) + bytes(dirty_squares);
+        const size_t linear = size_t(window.quads()) * Mesh::QUAD_VERTICES * sizeof(Vertex);
+        const Budget::Level level = Budget::level(w, h);
+        if(level.heap < heap || level.linear != linear)
+        {
+            printf("FAIL: %dx%d takes %zu bytes of heap and %zu of linear memory, the budget says %zu and %zu\n", w, h, heap, linear, level.heap, level.linear);
+            failures++;
+        }
+
+        Solver solver;
+        solver.solve(board, {short(w / 2), short(h / 2)});
+        const size_t solver_heap = heap + bytes(solver.state) + bytes(solver.hidden_masks) + bytes(solver.bombs_left) +
+                                   bytes(solver.work) + bytes(solver.pairs) + bytes(solver.in_work) + bytes(solver.in_pairs) + bytes(solver.flood_stack);
+        const Budget::Level no_guess = Budget::level(w, h, true);
+        if(no_guess.heap < solver_heap)
+        {
+            printf("FAIL: %dx%d without guessing takes %zu bytes of heap, the budget says %zu\n", w, h, solver_heap, no_guess.heap);
+            failures++;
+        }
+    }
+    {
+        Endless board;
+        board.reset(20, 1, Mesh::WINDOW_SIZE);
+        const Mesh::Layout window = Mesh::window(Mesh::WINDOW_SIZE * 4, Mesh::WINDOW_SIZE * 4, Mesh::WINDOW_SIZE * 2.0f, Mesh::WINDOW_SIZE * 2.0f);
+        board.materialize(window.x0, window.y0, window.x0 + window.width, window.y0 + window.height);
+        Mesh::Floor floor;
+        floor.reset(window);
+        const size_t heap = bytes(board.pool) + bytes(board.free_chunks) + bytes(board.grid) + bytes(board.revealed) + bytes(board.flood_stack) +
+                            floor.memory() + floor.groups[0].size() * sizeof(Culling::Range) + window.width * window.height * sizeof(int);
+        const Budget::Level level = Budget::endless();
+        if(level.heap < heap)
+        {
+            printf("FAIL: an endless level takes %zu bytes of heap, the budget says %zu\n", heap, level.heap);
+            failures++;
+        }
+    }
+    printf("%s\n", failures ? "failed" : "ok");
+
+    header("budget: memory per level (KiB)");
+    printf("%9s %12s %12s %16s\n", "size", "heap", "linear", "whole board");
+    for(const auto& size : level_sizes)
+    {
+        const Budget::Level level = Budget::level(size[0], size[1]);
+        // the geometry of every square at once, as the 6 vertex layout had it
+        const double whole = double(Reference::floatLevelSize(size[0], size[1])) * sizeof(Reference::FloatVertex);
+        printf("%4dx%-4d %12.1f %12.1f %16.1f\n", size[0], size[1], level.heap / 1024.0, level.linear / 1024.0, whole / 1024.0);
+    }
+    const Budget::Level endless = Budget::endless();
+    printf("%9s %12.1f %12.1f %16s\n", "endless", endless.heap / 1024.0, endless.linear / 1024.0, "-");
+
+    header("budget: huge boards, 1000x1000 (us per call)");
+    printf("%5s %12s %12s\n", "bombs", "generate", "first click");
+    uint64_t seed = 0;
+    for(const int percent : densities)
+    {
+        Board board;
+        const int bombs = percent * 1000 * 1000 / 100;
+        const Coord centre = {500, 500};
+        const double generate = time_us([&]() {
+            board.reset(1000, 1000, bombs);
+            board.generateBombs(centre, seed++);
+        });
+        const double first_click = time_us([&]() {
+            board.reset(1000, 1000, bombs);
+            board.generateBombs(centre, seed++);
+        }, [&]() {
+            board.reveal(centre);
+        });
+        printf("%4d%% %12.1f %12.1f\n", percent, generate, first_click);
+    }
+
+    return failures;
+}
@@ -0,0 +1,148 @@
+#include "bench.h"
+
+#include "camera.h"
+#include "culling.h"
+#include "raster.h"
+#include "rng.h"
+
+#include <cmath>
+
+namespace {
+    constexpr double DEGREES_TO_RADIANS = 3.14159265358979323846 / 180.0;
+
+    // what ThreeD::draw did before Camera::modelView, through libm
+    Raster::Matrix libmModelView(float angleX, float angleY)
+    {
+        Raster::Matrix m = Raster::identity();
+        const float angle = float((angleX - 90) * DEGREES_TO_RADIANS);
+        const float dir[3] = {cosf(angle), 0.0f, sinf(angle)};
+        Raster::rotateY(m, angle);
+        Raster::rotate(m, dir, float(-angleY * DEGREES_TO_RADIANS));
+        return m;
+    }
+
+    // angles the way Play gets them: angleX goes round any number of times, angleY stays within a quarter turn up or down
+    float randomAngleX(Rng& rng)
+    {
+        return float(rng.below(2000000)) / 100.0f - 10000.0f;
+    }
+    float randomAngleY(Rng& rng)
+    {
+        return float(rng.below(18001)) / 100.0f - 90.0f;
+    }
+}
+
+int Bench::camera_suite()
+{
+    int failures = 0;
+
+    header("camera: trig tables against libm");
+    {
+        // every hundredth of a degree over a few turns both ways, then far away
+        double worst_sine = 0.0, worst_cosine = 0.0;
+        for(int hundredth = -108000; hundredth <= 108000; hundredth++)
+        {
+            const float degrees = hundredth / 100.0f;
+            worst_sine = fmax(worst_sine, fabs(Camera::sine(degrees) - sin(degrees * DEGREES_TO_RADIANS)));
+            worst_cosine = fmax(worst_cosine, fabs(Camera::cosine(degrees) - cos(degrees * DEGREES_TO_RADIANS)));
+        }
+        Rng rng(20);
+        for(int test = 0; test < 100000; test++)
+        {
+            const float degrees = randomAngleX(rng);
+            worst_sine = fmax(worst_sine, fabs(Camera::sine(degrees) - sin(degrees * DEGREES_TO_RADIANS)));
+            worst_cosine = fmax(worst_cosine, fabs(Camera::cosine(degrees) - cos(degrees * DEGREES_TO_RADIANS)));
+        }
+        printf("%-28s %12.2e\n%-28s %12.2e\n", "worst sine error", worst_sine, "worst cosine error", worst_cosine);
+        if(worst_sine > 1e-5 || worst_cosine > 1e-5)
+        {
+            printf("FAIL: the tables are further than 1e-5 from libm\n");
+            failures++;
+        }
+
+        // the modelView made straight from the basis is the one citro3d's rotations made
+        double worst_matrix = 0.0;
+        for(int test = 0; test < 100000; test++)
+        {
+            const float angleX = randomAngleX(rng), angleY = randomAngleY(rng);
+            const Raster::Matrix expected = libmModelView(angleX, angleY);
+            float rows[4][4];
+            Camera::modelView(Camera::basis(angleX, angleY), rows);
+            for(int row = 0; row < 4; row++)
+                for(int col = 0; col < 4; col++)
+                    worst_matrix = fmax(worst_matrix, fabs(rows[row][col] - expected.r[row][col]));
+        }
+        printf("%-28s %12.2e\n", "worst modelView error", worst_matrix);
+        if(worst_matrix > 5e-5)
+        {
+            printf("FAIL: the modelView of the basis is further than 5e-5 from the rotations of citro3d\n");
+            failures++;
+        }
+    }
+    printf("%s\n", failures ? "failed" : "ok");
+
+    header("camera: a frame's trig, ns");
+    {
+        constexpr int CALLS = 1000;
+        float angles[CALLS][2];
+        Rng rng(21);
+        for(auto& angle : angles)
+        {
+            angle[0] = randomAngleX(rng);
+            angle[1] = randomAngleY(rng);
+        }
+        const Mesh::Layout layout = Mesh::window(99, 99, 0.0f, 0.0f);
+        volatile float sink = 0.0f;
+
+        const double libm_us = time_us([&]() {
+            float sum = 0.0f;
+            for(const auto& angle : angles)
+            {
+                const float x = float(angle[0] * DEGREES_TO_RADIANS), y = float(angle[1] * DEGREES_TO_RADIANS);
+                sum += cosf(x) + sinf(x) + cosf(y) + sinf(y);
+            }
+            sink = sum;
+        });
+        const double basis_us = time_us([&]() {
+            float sum = 0.0f;
+            for(const auto& angle : angles)
+            {
+                const Camera::Basis basis = Camera::basis(angle[0], angle[1]);
+                sum += basis.cos_x + basis.sin_x + basis.cos_y + basis.sin_y;
+            }
+            sink = sum;
+        });
+        const double rotations_us = time_us([&]() {
+            float sum = 0.0f;
+            for(const auto& angle : angles)
+                sum += libmModelView(angle[0], angle[1]).r[0][0];
+            sink = sum;
+        });
+        const double model_view_us = time_us([&]() {
+            float sum = 0.0f;
+            for(const auto& angle : angles)
+            {
+                float rows[4][4];
+                Camera::modelView(Camera::basis(angle[0], angle[1]), rows);
+                sum += rows[0][0];
+            }
+            sink = sum;
+        });
+        const double view_us = time_us([&]() {
+            float sum = 0.0f;
+            for(const auto& angle : angles)
+                sum += Culling::makeView(layout, 0.0f, 0.0f, Camera::basis(angle[0], angle[1]), 0.0f).sides[0][0];
+            sink = sum;
+        });
+        (void)sink;
+
+        // time_us gives microseconds for CALLS calls: the same number is nanoseconds for one
+        printf("%-36s %10.1f\n", "sinf and cosf of both angles", libm_us);
+        printf("%-36s %10.1f\n", "Camera::basis", basis_us);
+        printf("%-36s %10.1f\n", "modelView through the rotations", rotations_us);
+        printf("%-36s %10.1f\n", "Camera::modelView of a new basis", model_view_us);
+        printf("%-36s %10.1f\n", "Culling::makeView of a new basis", view_us);
+    }
+
+    return failures;
+}
@@ -0,0 +1,289 @@
+#include "bench.h"
+
+#include "culling.h"
+#include "mesh.h"
+#include "rng.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+    constexpr float DEGREES_TO_RADIANS = 3.14159265f / 180.0f;
+
+    // A camera pose as MineSweeper keeps it
+    struct Pose {
+        const char* name;
+        float posX, posZ, angleX, angleY;
+    };
+
+    // Whether a point of the level (around the centre of the board) is on screen, from the camera's own axes
+    // rather than from the planes Culling builds out of them
+    bool onScreen(const Pose& pose, const float point[3])
+    {
+        const float yaw = pose.angleX * DEGREES_TO_RADIANS;
+        const float pitch = pose.angleY * DEGREES_TO_RADIANS;
+        const float eye[3] = {-pose.posX, 0.0f, -pose.posZ};
+        const float p[3] = {point[0] - eye[0], point[1] - eye[1], point[2] - eye[2]};
+        if(p[0] * p[0] + p[2] * p[2] > Culling::FOG_END * Culling::FOG_END)
+            return false;
+
+        const float forward[3] = {-cosf(yaw) * cosf(pitch), sinf(pitch), -sinf(yaw) * cosf(pitch)};
+        const float right[3] = {sinf(yaw), 0.0f, -cosf(yaw)};
+        const float up[3] = {
+            right[1] * forward[2] - right[2] * forward[1],
+            right[2] * forward[0] - right[0] * forward[2],
+            right[0] * forward[1] - right[1] * forward[0],
+        };
+        const float depth = p[0] * forward[0] + p[1] * forward[1] + p[2] * forward[2];
+        const float across = p[0] * right[0] + p[1] * right[1] + p[2] * right[2];
+        const float along = p[0] * up[0] + p[1] * up[1] + p[2] * up[2];
+        const float tan_y = tanf(Culling::FOV_Y_DEGREES / 2.0f * DEGREES_TO_RADIANS);
+        return depth > 0.0f && fabsf(across) <= depth * tan_y * Culling::ASPECT_RATIO && fabsf(along) <= depth * tan_y;
+    }
+
+    // (x, y) is a square of the board in the window
+    int chunkOf(const Mesh::Layout& layout, int x, int y)
+    {
+        return ((x - layout.x0) / Mesh::CHUNK_SIZE) + ((y - layout.y0) / Mesh::CHUNK_SIZE) * layout.chunks_x;
+    }
+
+    // Whether any corner of square (x, y) of the board is on screen, where the floor is drawn and as low as the shader drops it
+    bool squareOnScreen(const Mesh::Layout& layout, const Pose& pose, int x, int y)
+    {
+        for(int corner = 0; corner < 4; corner++)
+        {
+            for(const float floor_y : {Culling::FLOOR_HIGH, Culling::FLOOR_LOW})
+            {
+                const float point[3] = {layout.board_width / -2.0f + x + corner % 2, floor_y, layout.board_height / -2.0f + y + corner / 2};
+                if(onScreen(pose, point))
+                    return true;
+            }
+        }
+        return false;
+    }
+}
+
+int Bench::culling_suite()
+{
+    int failures = 0;
+
+    header("culling: chunks cover the floor exactly once");
+    for(const short w : {10, 16, 17, 50, 99})
+    {
+        for(const short h : {10, 16, 33, 99})
+        {
+            const Mesh::Layout layout(w, h);
+            std::vector<Mesh::Chunk> chunks;
+            Mesh::chunks(layout, chunks);
+            std::vector<int> owner(layout.quads(), -1);
+            bool ok = true;
+            for(size_t c = 0; c < chunks.size(); c++)
+            {
+                for(int quad = chunks[c].first; quad < chunks[c].first + chunks[c].count; quad++)
+                {
+                    ok = ok && quad >= layout.floorStart() && quad < layout.cursor() && owner[quad] == -1;
+                    owner[quad] = int(c);
+                }
+            }
+            // and every square's quad belongs to the chunk whose bounds hold it
+            for(int square = 0; ok && square < w * h; square++)
+            {
+                const int x = square % w, y = square / w;
+                const int chunk = chunkOf(layout, x, y);
+                const float sx = w / -2.0f + x + 0.5f, sz = h / -2.0f + y + 0.5f;
+                ok = owner[layout.floorQuad(square)] == chunk &&
+                     sx > chunks[chunk].min_x && sx < chunks[chunk].max_x && sz > chunks[chunk].min_z && sz < chunks[chunk].max_z;
+            }
+            for(int quad = layout.floorStart(); ok && quad < layout.cursor(); quad++)
+                ok = owner[quad] != -1;
+            if(!ok)
+            {
+                printf("FAIL: %dx%d chunks don't cover the floor exactly once\n", w, h);
+                failures++;
+            }
+        }
+    }
+    printf("%s\n", failures ? "failed" : "ok");
+
+    header("culling: no square on screen is in a skipped chunk");
+    int culling_failures = 0;
+    Rng rng(1);
+    for(int test = 0; test < 300; test++)
+    {
+        const short w = short(10 + rng.below(90));
+        const short h = short(10 + rng.below(90));
+        const Mesh::Layout layout(w, h);
+        // anywhere advance() lets the player go
+        const Pose pose = {
+            "random",
+            (float(rng.below(1000)) / 1000.0f - 0.5f) * (w - 1),
+            (float(rng.below(1000)) / 1000.0f - 0.5f) * (h - 1),
+            float(rng.below(360)),
+            float(rng.below(181)) - 90.0f,
+        };
+        const float iod = test % 2 ? float(rng.below(100)) / 300.0f : 0.0f;
+
+        std::vector<Mesh::Chunk> chunks;
+        Mesh::chunks(layout, chunks);
+        const Culling::View view = Culling::makeView(layout, pose.posX, pose.posZ, Camera::basis(pose.angleX, pose.angleY), iod);
+
+        for(int square = 0; square < w * h; square++)
+        {
+            const int x = square % w, y = square / w;
+            const int chunk = chunkOf(layout, x, y);
+            if(Culling::visible(view, chunks[chunk]))
+                continue;
+
+            if(squareOnScreen(layout, pose, x, y))
+            {
+                printf("FAIL: %dx%d at (%.2f, %.2f) angles (%.0f, %.0f) skips chunk %d but square (%d, %d) is on screen\n",
+                    w, h, pose.posX, pose.posZ, pose.angleX, pose.angleY, chunk, x, y);
+                culling_failures++;
+                break;
+            }
+        }
+    }
+    printf("%s\n", culling_failures ? "failed" : "ok");
+    failures += culling_failures;
+
+    // the player walks up to WINDOW_REACH from the edges of a window before it moves
+    header("culling: no square on screen is outside the window or in a skipped chunk, huge boards");
+    int window_failures = 0;
+    for(int test = 0; test < 300; test++)
+    {
+        const short w = short(Mesh::WINDOW_SIZE + rng.below(1000 - Mesh::WINDOW_SIZE + 1));
+        const short h = short(Mesh::WINDOW_SIZE + rng.below(1000 - Mesh::WINDOW_SIZE + 1));
+        const Pose pose = {
+            "random",
+            (float(rng.below(1000)) / 1000.0f - 0.5f) * (w - 1),
+            (float(rng.below(1000)) / 1000.0f - 0.5f) * (h - 1),
+            float(rng.below(360)),
+            float(rng.below(181)) - 90.0f,
+        };
+        const float iod = test % 2 ? float(rng.below(100)) / 300.0f : 0.0f;
+        // where the player stands on the board (see MineSweeper::get_board_x), and the window it was made for somewhere nearby
+        const float board_x = w / 2.0f - pose.posX, board_y = h / 2.0f - pose.posZ;
+        Mesh::Layout layout = Mesh::window(w, h, board_x, board_y);
+        for(int tries = 0; tries < 100; tries++)
+        {
+            const float spread = Mesh::WINDOW_SIZE / 2.0f - Culling::WINDOW_REACH;
+            const Mesh::Layout moved = Mesh::window(w, h,
+                board_x + (float(rng.below(1000)) / 500.0f - 1.0f) * spread,
+                board_y + (float(rng.below(1000)) / 500.0f - 1.0f) * spread);
+            if(Mesh::covers(moved, board_x, board_y, Culling::WINDOW_REACH))
+            {
+                layout = moved;
+                break;
+            }
+        }
+
+        std::vector<Mesh::Chunk> chunks;
+        Mesh::chunks(layout, chunks);
+        const Culling::View view = Culling::makeView(layout, pose.posX, pose.posZ, Camera::basis(pose.angleX, pose.angleY), iod);
+
+        // past the fog, nothing's on screen
+        const int reach = int(Culling::FOG_END) + 2;
+        for(int y = std::max(0, int(board_y) - reach); y < std::min(int(h), int(board_y) + reach); y++)
+        {
+            for(int x = std::max(0, int(board_x) - reach); x < std::min(int(w), int(board_x) + reach); x++)
+            {
+                const bool in_window = layout.contains(x + y * w);
+                if(in_window && Culling::visible(view, chunks[chunkOf(layout, x, y)]))
+                    continue;
+                if(squareOnScreen(layout, pose, x, y))
+                {
+                    printf("FAIL: %dx%d at (%.2f, %.2f) angles (%.0f, %.0f) window at (%d, %d) misses square (%d, %d) on screen%s\n",
+                        w, h, pose.posX, pose.posZ, pose.angleX, pose.angleY, layout.x0, layout.y0, x, y, in_window ? ", its chunk is skipped" : "");
+                    window_failures++;
+                    y = h;
+                    break;
+                }
+            }
+        }
+    }
+    printf("%s\n", window_failures ? "failed" : "ok");
+    failures += window_failures;
+
+    header("culling: chunks wholly past LOD_DISTANCE left out, every other visible one kept");
+    int far_failures = 0;
+    for(int test = 0; test < 300; test++)
+    {
+        const Mesh::Layout layout = Mesh::window(1000, 1000, float(rng.below(1000)), float(rng.below(1000)));
+        const float posX = (float(rng.below(1000)) / 1000.0f - 0.5f) * layout.width - layout.centreX();
+        const float posZ = (float(rng.below(1000)) / 1000.0f - 0.5f) * layout.height - layout.centreZ();
+        const Culling::View view = Culling::makeView(layout, posX, posZ, Camera::basis(float(rng.below(360)), float(rng.below(181)) - 90.0f),
+                                                     test % 2 ? 1.0f / 3.0f : 0.0f);
+        std::vector<Mesh::Chunk> chunks;
+        Mesh::chunks(layout, chunks);
+
+        bool ok = true;
+        std::vector<int> kept(layout.quads(), 0);
+        for(const Mesh::Chunk& chunk : chunks)
+        {
+            // the point of the chunk closest to the eye, clamped into it; either eye may be up to the margin closer
+            const float x = std::min(std::max(view.eye[0], chunk.min_x), chunk.max_x);
+            const float z = std::min(std::max(view.eye[2], chunk.min_z), chunk.max_z);
+            const float closest = sqrtf((x - view.eye[0]) * (x - view.eye[0]) + (z - view.eye[2]) * (z - view.eye[2]));
+            if(closest < Culling::LOD_DISTANCE + view.margin - 0.01f)
+                ok = ok && !Culling::far(view, chunk);
+            if(closest > Culling::LOD_DISTANCE + view.margin * 1.5f)
+                ok = ok && Culling::far(view, chunk);
+            if(Culling::visible(view, chunk) && !Culling::far(view, chunk))
+                for(int quad = chunk.first; quad < chunk.first + chunk.count; quad++)
+                    kept[quad]++;
+        }
+        std::vector<Culling::Range> ranges;
+        Culling::visibleRanges(view, chunks, ranges);
+        for(const Culling::Range& range : ranges)
+            for(int quad = range.first; quad < range.first + range.count; quad++)
+                kept[quad]--;
+        ok = ok && std::all_of(kept.begin(), kept.end(), [](int count) { return count == 0; });
+        if(!ok)
+        {
+            printf("FAIL: window at (%d, %d) seen from (%.2f, %.2f) leaves out the wrong chunks\n", layout.x0, layout.y0, posX, posZ);
+            far_failures++;
+        }
+    }
+    printf("%s\n", far_failures ? "failed" : "ok");
+    failures += far_failures;
+
+    header("culling: floor submitted per eye, 99x99 board");
+    const Mesh::Layout layout(99, 99);
+    std::vector<Mesh::Chunk> chunks;
+    Mesh::chunks(layout, chunks);
+    const int floor_vertices = (layout.cursor() - layout.floorStart()) * Mesh::QUAD_VERTICES;
+    const Pose poses[] = {
+        {"center, level", 0.0f, 0.0f, 0.0f, 0.0f},
+        {"center, looking down", 0.0f, 0.0f, 0.0f, -45.0f},
+        {"center, at the feet", 0.0f, 0.0f, 0.0f, -90.0f},
+        {"center, at the sky", 0.0f, 0.0f, 0.0f, 90.0f},
+        {"corner, facing in", 48.5f, 48.5f, 225.0f, -20.0f},
+        {"corner, facing out", 48.5f, 48.5f, 45.0f, -20.0f},
+        {"edge, along the wall", 48.5f, 0.0f, 90.0f, -20.0f},
+    };
+    printf("%-22s %8s %10s %9s %7s\n", "pose", "chunks", "vertices", "of floor", "draws");
+    std::vector<Culling::Range> ranges;
+    for(const Pose& pose : poses)
+    {
+        const Culling::View view = Culling::makeView(layout, pose.posX, pose.posZ, Camera::basis(pose.angleX, pose.angleY), 0.0f);
+        Culling::visibleRanges(view, chunks, ranges);
+        int drawn_chunks = 0;
+        for(const Mesh::Chunk& chunk : chunks)
+            drawn_chunks += Culling::visible(view, chunk) && !Culling::far(view, chunk);
+        int quads = 0;
+        for(const Culling::Range& range : ranges)
+            quads += range.count;
+        const int vertices = quads * Mesh::QUAD_VERTICES;
+        printf("%-22s %3d / %-3zu %10d %8.1f%% %7zu\n", pose.name, drawn_chunks, chunks.size(), vertices,
+            100.0 * vertices / floor_vertices, ranges.size());
+    }
+
+    const double cull = time_us([&]() {
+        const Culling::View view = Culling::makeView(layout, 10.0f, -5.0f, Camera::basis(30.0f, -30.0f), 0.1f);
+        Culling::visibleRanges(view, chunks, ranges);
+    });
+    printf("cost of culling one eye: %.3f us\n", cull);
+
+    return failures;
+}
@@ -0,0 +1,202 @@
+#include "bench.h"
+
+#include "endless.h"
+#include "mesh.h"
+#include "rng.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    constexpr int C = Endless::CHUNK_SIZE;
+
+    bool mineAt(const Endless& board, int x, int y)
+    {
+        Endless::Word plane[C];
+        Endless::mines(board.seed, board.threshold, x >> Endless::CHUNK_SHIFT, y >> Endless::CHUNK_SHIFT, plane);
+        return Endless::getBit(plane, x, y);
+    }
+
+    // Every square of [x0, x1) x [y0, y1), in memory, against the bombs made again one at a time:
+    // right bombs, right counts, nothing around the spawn
+    int check_squares(const Endless& board, int x0, int y0, int x1, int y1)
+    {
+        for(int y = y0; y < y1; y++)
+        {
+            for(int x = x0; x < x1; x++)
+            {
+                const bool mine = mineAt(board, x, y);
+                if(board.isMine(x, y) != mine || (mine && abs(x - Endless::SPAWN_X) <= 1 && abs(y - Endless::SPAWN_Y) <= 1))
+                {
+                    printf("FAIL: seed %016llx square (%d, %d) %s a bomb\n", (unsigned long long)board.seed, x, y, board.isMine(x, y) ? "has" : "doesn't have");
+                    return 1;
+                }
+
+                int around = 0;
+                for(int ny = y - 1; ny <= y + 1; ny++)
+                    for(int nx = x - 1; nx <= x + 1; nx++)
+                        around += mineAt(board, nx, ny);
+                if(around != board.count(x, y))
+                {
+                    printf("FAIL: seed %016llx counts %d bombs around (%d, %d) instead of %d\n", (unsigned long long)board.seed, board.count(x, y), x, y, around);
+                    return 1;
+                }
+            }
+        }
+        return 0;
+    }
+
+    // A player walks around revealing, with only the chunks under a window around them in memory.
+    // Once the whole area walked is back in memory, it has to be the same as a board that had all of it from the start
+    // and got the same reveals: openings cut short at the edge of memory carried on when it moved
+    int check_walk(uint64_t seed)
+    {
+        Rng rng(seed);
+        const int percent = int(10 + rng.below(11));
+        // a small window, so that plenty of openings get to its edges
+        constexpr int reach = 320, window = 2 * C;
+        Endless walker, whole;
+        walker.reset(percent, seed, 2 * reach);
+        whole.reset(percent, seed, 2 * reach);
+        whole.materialize(-reach, -reach, reach, reach);
+
+        int x = 0, y = 0;
+        for(int step = 0; step < 200; step++)
+        {
+            // only ever as far as the whole board goes
+            x = std::max(-reach + window / 2, std::min(reach - window / 2, x + int(rng.below(81)) - 40));
+            y = std::max(-reach + window / 2, std::min(reach - window / 2, y + int(rng.below(81)) - 40));
+            walker.materialize(x - window / 2, y - window / 2, x + window / 2, y + window / 2);
+            for(int click = 0; click < 4; click++)
+            {
+                const Endless::Square point = {x - 20 + int(rng.below(41)), y - 20 + int(rng.below(41))};
+                if(walker.isMine(point.x, point.y))
+                    continue;
+                if(!walker.isOpen(point.x, point.y))
+                {
+                    walker.reveal(point);
+                    whole.reveal(point);
+                    continue;
+                }
+
+                // a chord once the bombs around are flagged, on both boards, where the walker has all of them in memory
+                bool resident = true;
+                for(int ny = point.y - 1; ny <= point.y + 1; ny++)
+                    for(int nx = point.x - 1; nx <= point.x + 1; nx++)
+                        resident = resident && walker.resident(nx, ny);
+                if(!resident)
+                    continue;
+                for(int ny = point.y - 1; ny <= point.y + 1; ny++)
+                {
+                    for(int nx = point.x - 1; nx <= point.x + 1; nx++)
+                    {
+                        if(walker.isMine(nx, ny) && !walker.isFlagged(nx, ny))
+                        {
+                            walker.placeFlag({nx, ny});
+                            whole.placeFlag({nx, ny});
+                        }
+                    }
+                }
+                walker.chord(point);
+                whole.chord(point);
+            }
+        }
+        walker.materialize(-reach, -reach, reach, reach);
+
+        int opened = 0;
+        for(int sy = -reach; sy < reach; sy++)
+        {
+            for(int sx = -reach; sx < reach; sx++)
+            {
+                if(walker.isOpen(sx, sy) != whole.isOpen(sx, sy))
+                {
+                    printf("FAIL: seed %016llx square (%d, %d) is %s after walking, %s on the whole board\n", (unsigned long long)seed, sx, sy,
+                        walker.isOpen(sx, sy) ? "open" : "hidden", whole.isOpen(sx, sy) ? "open" : "hidden");
+                    return 1;
+                }
+                opened += walker.isOpen(sx, sy);
+            }
+        }
+        if(opened != walker.opened || opened != whole.opened)
+        {
+            printf("FAIL: seed %016llx has %d squares open, the counters say %d walking and %d on the whole board\n", (unsigned long long)seed, opened, walker.opened, whole.opened);
+            return 1;
+        }
+        return 0;
+    }
+}
+
+int Bench::endless_suite()
+{
+    int failures = 0;
+
+    header("endless: bombs and counts only depend on the seed, wherever the board went");
+    for(uint64_t seed = 0; seed < 20; seed++)
+    {
+        Endless board;
+        board.reset(densities[seed % 4], seed, Mesh::WINDOW_SIZE);
+        // around the spawn, far away, then across the spawn from another side
+        board.materialize(-40, -40, 40, 40);
+        failures += check_squares(board, -40, -40, 40, 40);
+        board.materialize(100000 - 100, -5000 - 100, 100000 + 100, -5000 + 100);
+        failures += check_squares(board, 100000 - 100, -5000 - 100, 100000 + 100, -5000 + 100);
+        board.materialize(-150, -10, 50, 190);
+        failures += check_squares(board, -150, -10, 50, 190);
+    }
+    printf("%s\n", failures ? "failed" : "ok");
+
+    header("endless: openings carry on past the chunks in memory, random walks with chords");
+    int walk_failures = 0;
+    for(uint64_t seed = 0; seed < 20; seed++)
+    {
+        walk_failures += check_walk(seed);
+    }
+    printf("%s\n", walk_failures ? "failed" : "ok");
+    failures += walk_failures;
+
+    header("endless: memory in chunks");
+    {
+        const int side = Endless::chunksFor(Mesh::WINDOW_SIZE);
+        const size_t chunks = size_t(side) * side * sizeof(Endless::Chunk);
+        printf("%d x %d chunks under a %dx%d window: %.1f KiB, %zu bytes kept per chunk played on and left behind\n",
+            side, side, Mesh::WINDOW_SIZE, Mesh::WINDOW_SIZE, chunks / 1024.0, sizeof(Endless::Played));
+    }
+
+    header("endless: making chunks (us per call)");
+    printf("%5s %12s %12s %12s %12s\n", "bombs", "one chunk", "window", "window step", "first click");
+    for(const int percent : densities)
+    {
+        uint64_t seed = 0;
+        Endless::Word plane[C];
+        const double chunk = time_us([&]() {
+            Endless::mines(seed++, Endless::thresholdOf(percent), 0, 0, plane);
+        });
+
+        Endless board;
+        constexpr int half = Mesh::WINDOW_SIZE / 2;
+        const double window = time_us([&]() {
+            board.reset(percent, seed++, Mesh::WINDOW_SIZE);
+        }, [&]() {
+            board.materialize(-half, -half, half, half);
+        });
+
+        // the window moves by a chunk as the player walks along, which brings in a row of chunks
+        int x = 0;
+        board.reset(percent, seed++, Mesh::WINDOW_SIZE);
+        board.materialize(-half, -half, half, half);
+        const double step = time_us([&]() {
+            x += C;
+            board.materialize(x - half, -half, x + half, half);
+        });
+
+        const double first_click = time_us([&]() {
+            board.reset(percent, seed++, Mesh::WINDOW_SIZE);
+            board.materialize(-half, -half, half, half);
+        }, [&]() {
+            board.reveal({Endless::SPAWN_X, Endless::SPAWN_Y});
+        });
+        printf("%4d%% %12.2f %12.1f %12.1f %12.1f\n", percent, chunk, window, step, first_click);
+    }
+
+    return failures;
+}
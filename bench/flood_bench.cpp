@@ -0,0 +1,144 @@
+#include "bench.h"
+
+#include "board.h"
+#include "reference.h"
+#include "rng.h"
+
+#include <vector>
+
+namespace {
+    // Finds a square in the biggest 8-connected blank area, the worst case for a single click
+    Coord largest_blank_area(const Board& board, int& area_size)
+    {
+        const int w = board.width, h = board.height;
+        std::vector<int> label(w * h, -1);
+        std::vector<int> stack;
+        area_size = 0;
+        Coord best = {0, 0};
+        for(int start = 0; start < w * h; start++)
+        {
+            if(board.isMine(start) || board.count(start) != 0 || label[start] != -1)
+                continue;
+
+            int size = 0;
+            label[start] = start;
+            stack.push_back(start);
+            while(!stack.empty())
+            {
+                const int pos = stack.back();
+                stack.pop_back();
+                size++;
+                const int x = pos % w, y = pos / w;
+                for(int ny = y - 1; ny <= y + 1; ny++)
+                {
+                    for(int nx = x - 1; nx <= x + 1; nx++)
+                    {
+                        if(nx < 0 || ny < 0 || nx >= w || ny >= h)
+                            continue;
+                        const int idx = nx + ny * w;
+                        if(!board.isMine(idx) && board.count(idx) == 0 && label[idx] == -1)
+                        {
+                            label[idx] = start;
+                            stack.push_back(idx);
+                        }
+                    }
+                }
+            }
+            if(size > area_size)
+            {
+                area_size = size;
+                best = {short(start % w), short(start / w)};
+            }
+        }
+        return best;
+    }
+}
+
+int Bench::flood_suite()
+{
+    int failures = 0;
+
+    header("flood: same squares opened as the recursive version");
+    Rng rng(1);
+    for(int game = 0; game < 200; game++)
+    {
+        const short w = short(10 + rng.below(90));
+        const short h = short(10 + rng.below(90));
+        const int bombs = int(10 + rng.below(31)) * w * h / 100;
+        Board board;
+        board.reset(w, h, bombs);
+        board.generateBombs({short(rng.below(w)), short(rng.below(h))}, game);
+        Reference::CharBoard reference(board);
+
+        // keep clicking random squares until someone loses or wins
+        for(int click = 0; click < 64; click++)
+        {
+            const Coord point = {short(rng.below(w)), short(rng.below(h))};
+            const Board::Outcome got = board.reveal(point);
+            const Board::Outcome expected = Reference::reveal(reference, point);
+            if(got != expected || Reference::visibleOf(board) != reference.visible)
+            {
+                printf("FAIL: %dx%d seed %d differs from the recursive flood fill at click %d (%d, %d)\n", w, h, game, click, point.x, point.y);
+                failures++;
+                break;
+            }
+            if(got != Board::Outcome::Playing)
+                break;
+        }
+    }
+    printf("%s\n", failures ? "failed" : "ok");
+
+    header("flood: click in the largest blank area (us per click)");
+    printf("%7s %5s %8s %12s %12s\n", "size", "bombs", "opened", "recursive", "iterative");
+    for(const short sz : sizes)
+    {
+        for(const int percent : {10, 20})
+        {
+            const int bombs = percent * sz * sz / 100;
+            // keep the seed whose board has the biggest blank area out of a few
+            Board board;
+            Coord click = {0, 0};
+            int best_area = -1;
+            uint64_t best_seed = 0;
+            for(uint64_t seed = 0; seed < 16; seed++)
+            {
+                board.reset(sz, sz, bombs);
+                board.generateBombs({0, 0}, seed);
+                int area = 0;
+                const Coord point = largest_blank_area(board, area);
+                if(area > best_area)
+                {
+                    best_area = area;
+                    best_seed = seed;
+                    click = point;
+                }
+            }
+            board.reset(sz, sz, bombs);
+            board.generateBombs({0, 0}, best_seed);
+            const Board fresh = board;
+            // put the squares back without giving up the capacity reserved by reset()
+            const auto restore = [&]() {
+                board.open_bits = fresh.open_bits;
+                board.flag_bits = fresh.flag_bits;
+                board.flags_count = fresh.flags_count;
+                board.hidden_safe = fresh.hidden_safe;
+            };
+
+            // both include the win check, like a click in game
+            const Reference::CharBoard fresh_chars(board);
+            Reference::CharBoard chars = fresh_chars;
+            const double recursive = time_us([&]() {
+                chars.visible = fresh_chars.visible;
+                chars.around = fresh_chars.around;
+            }, [&]() {
+                Reference::reveal(chars, click);
+            });
+            const double iterative = time_us(restore, [&]() {
+                board.reveal(click);
+            });
+
+            printf("%3dx%-3d %5d %8zu %12.3f %12.3f\n", sz, sz, bombs, board.revealed.size(), recursive, iterative);
+        }
+    }
+    return failures;
+}
@@ -0,0 +1,81 @@
+#include "bench.h"
+
+#include "play.h"
+
+#include <cstring>
+
+const char* Bench::argument = nullptr;
+
+void Bench::header(const char* title)
+{
+    printf("\n== %s ==\n", title);
+}
+
+void Bench::setUpLevel(Play& play, short w, short h, int percent, bool endless, bool no_guess, uint64_t seed)
+{
+    play.seed = seed;
+    play.width = w;
+    play.height = h;
+    play.bombpercent = short(percent);
+    play.no_guess = no_guess;
+    play.endless = endless;
+    play.setUpLevel();
+}
+
+void Bench::firstReveal(Play& play)
+{
+    for(int frame = 0; frame < 200 && !play.looking_at_floor; frame++)
+        play.update({0, Keys::DDOWN, 0, 0, true});
+    play.update({Keys::R, Keys::R, 0, 0, true});
+    play.worker.wait();
+}
+
+void Bench::startLevel(Play& play, std::vector<Vertex>& vertices)
+{
+    const Mesh::Layout window = Mesh::window(play.width, play.height, play.get_board_x(), play.get_board_y());
+    vertices.assign(size_t(window.quads()) * Mesh::QUAD_VERTICES, Vertex());
+    play.prepare(vertices.data(), window);
+    play.worker.wait();
+    play.finishPreparing();
+}
+
+int main(int argc, char** argv)
+{
+    struct {
+        const char* name;
+        int (*run)();
+    } suites[] = {
+        {"board", &Bench::board_suite},
+        {"flood", &Bench::flood_suite},
+        {"neighbours", &Bench::neighbours_suite},
+        {"mesh", &Bench::mesh_suite},
+        {"culling", &Bench::culling_suite},
+        {"atlas", &Bench::atlas_suite},
+        {"budget", &Bench::budget_suite},
+        {"endless", &Bench::endless_suite},
+        {"solver", &Bench::solver_suite},
+        {"worker", &Bench::worker_suite},
+        {"save", &Bench::save_suite},
+        {"replay", &Bench::replay_suite},
+        {"raster", &Bench::raster_suite},
+        {"profile", &Bench::profile_suite},
+        {"camera", &Bench::camera_suite},
+        {"arena", &Bench::arena_suite},
+    };
+
+    if(argc > 2)
+        Bench::argument = argv[2];
+
+    int failures = 0;
+    for(const auto& suite : suites)
+    {
+        if(argc > 1 && strcmp(argv[1], suite.name) != 0)
+            continue;
+
+        failures += suite.run();
+    }
+
+    if(failures)
+        printf("\n%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
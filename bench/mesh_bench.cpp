@@ -0,0 +1,553 @@
+#include "bench.h"
+
+#include "mesh.h"
+#include "play.h"
+#include "reference.h"
+#include "rng.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+    // A vertex as the shader gets it: {x, y, z, u, v} in the fixed point of Vertex, then the normal
+    using DrawnVertex = std::array<int, 8>;
+    // rotated so that its smallest vertex comes first, which keeps the winding
+    using Triangle = std::array<DrawnVertex, 3>;
+
+    struct Normal {
+        int x, y, z;
+    };
+
+    Triangle canonical(Triangle triangle)
+    {
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        return triangle;
+    }
+
+    DrawnVertex drawn(const Vertex& v, Normal n)
+    {
+        return {v.position[0], v.position[1], v.position[2], v.texcoord[0], v.texcoord[1], n.x, n.y, n.z};
+    }
+
+    DrawnVertex drawn(const Reference::FloatVertex& v)
+    {
+        const Vertex packed(v.position[0], v.position[1], v.position[2], v.texcoord[0], v.texcoord[1]);
+        return drawn(packed, {int(v.norm[0]), int(v.norm[1]), int(v.norm[2])});
+    }
+
+    // What ThreeD::draw submits when looking at the floor: the same ranges, normals and batches
+    std::vector<Triangle> indexedTriangles(const std::vector<Vertex>& vertices, const Mesh::Layout& layout, const std::vector<uint16_t>& indices)
+    {
+        const struct {
+            int first, count;
+            Normal normal;
+        } ranges[] = {
+            {layout.topWalls(), layout.width, {0, 0, +1}},
+            {layout.bottomWalls(), layout.width, {0, 0, -1}},
+            {layout.leftWalls(), layout.height, {+1, 0, 0}},
+            {layout.rightWalls(), layout.height, {-1, 0, 0}},
+            {layout.floorStart(), layout.cursor() - layout.floorStart() + 1, {0, 1, 0}},
+            {layout.crosshair(), 1, {0, 0, 1}},
+        };
+
+        std::vector<Triangle> triangles;
+        for(const auto& range : ranges)
+        {
+            for(int first = range.first, count = range.count; count > 0; )
+            {
+                const int batch = std::min(count, Mesh::BATCH_QUADS);
+                const Vertex* base = &vertices[first * Mesh::QUAD_VERTICES];
+                for(int i = 0; i < batch * Mesh::QUAD_INDICES; i += 3)
+                {
+                    triangles.push_back(canonical({
+                        drawn(base[indices[i + 0]], range.normal),
+                        drawn(base[indices[i + 1]], range.normal),
+                        drawn(base[indices[i + 2]], range.normal),
+                    }));
+                }
+                first += batch;
+                count -= batch;
+            }
+        }
+        return triangles;
+    }
+
+    // all but the vertices in [skip_first, skip_end)
+    std::vector<Triangle> floatTriangles(const std::vector<Reference::FloatVertex>& vertices, size_t skip_first, size_t skip_end)
+    {
+        std::vector<Triangle> triangles;
+        for(size_t i = 0; i < vertices.size(); i += 3)
+        {
+            if(i >= skip_first && i < skip_end)
+                continue;
+            triangles.push_back(canonical({drawn(vertices[i + 0]), drawn(vertices[i + 1]), drawn(vertices[i + 2])}));
+        }
+        return triangles;
+    }
+
+    // a different spot of a 16x16 sprite sheet for every tile, so that no two corners share texture coordinates
+    Mesh::QuadUVs tileUVs(int tile)
+    {
+        const float left = float(tile % 16) / 16.0f;
+        const float top = 1.0f - float(tile / 16) / 16.0f;
+        const float right = left + 1.0f / 16.0f;
+        const float bottom = top - 1.0f / 16.0f;
+        // corners in the order of subtex_uv_funcs: bottom right, bottom left, top right, top left
+        return {{right, left, right, left}, {bottom, bottom, top, top}};
+    }
+
+    // The floor tiles the way Play has them: hidden and open squares repeating
+    constexpr int FLOOR_TILES = Play::FLOOR_TILES;
+    struct FloorTiles {
+        Mesh::QuadTemplate tiles[FLOOR_TILES];
+        int groups[FLOOR_TILES];
+
+        FloorTiles() : groups{}
+        {
+            for(int tile = 0; tile < FLOOR_TILES; tile++)
+                tiles[tile] = Mesh::floorTemplate(Mesh::floorTileUVs(tile, FLOOR_TILES));
+            for(int repeating = 0; repeating < Mesh::REPEATING; repeating++)
+                groups[Play::FLOOR_REPEATING[repeating]] = 1 + repeating;
+        }
+    };
+
+    bool sameQuad(const Vertex* quad, const Mesh::QuadTemplate& tile, int16_t x, int16_t z)
+    {
+        for(int corner = 0; corner < Mesh::QUAD_VERTICES; corner++)
+        {
+            const Vertex& v = quad[corner];
+            const Vertex& t = tile.corners[corner];
+            if(v.position[0] != t.position[0] + x || v.position[1] != t.position[1] || v.position[2] != t.position[2] + z ||
+               v.texcoord[0] != t.texcoord[0] || v.texcoord[1] != t.texcoord[1])
+                return false;
+        }
+        return true;
+    }
+
+    // The tile every square of the window is drawn with, going by the quads of floor: -1 where it has none,
+    // -2 where it has more than one or a quad isn't one of the tiles or patches, or strays out of its chunk
+    std::vector<int> drawnTiles(const Mesh::Floor& floor, const std::vector<Vertex>& vertices, const Mesh::Layout& window, const FloorTiles& tiles)
+    {
+        std::vector<int> drawn(window.width * window.height, -1);
+        const int16_t left = Vertex::quantize(window.width / -2.0f, Vertex::POSITION_SCALE);
+        const int16_t top = Vertex::quantize(window.height / -2.0f, Vertex::POSITION_SCALE);
+        constexpr int STEP = int(Vertex::POSITION_SCALE);
+        for(int group = 0; group < Mesh::FLOOR_GROUPS; group++)
+        {
+            for(size_t chunk = 0; chunk < floor.groups[group].size(); chunk++)
+            {
+                const Mesh::Chunk& range = floor.groups[group][chunk];
+                const int chunk_x = int(chunk) % window.chunks_x, chunk_y = int(chunk) / window.chunks_x;
+                for(int quad = range.first; quad < range.first + range.count; quad++)
+                {
+                    const Vertex* corners = &vertices[quad * Mesh::QUAD_VERTICES];
+                    const int x = (corners[0].position[0] - left) / STEP, y = (corners[0].position[2] - top) / STEP;
+                    const int w = (corners[1].position[0] - corners[0].position[0]) / STEP;
+                    const int h = (corners[2].position[2] - corners[0].position[2]) / STEP;
+                    const int16_t dx = int16_t(left + x * STEP), dz = int16_t(top + y * STEP);
+                    int tile = -2;
+                    if(group == 0)
+                    {
+                        for(int t = 0; t < FLOOR_TILES; t++)
+                            tile = tiles.groups[t] == 0 && sameQuad(corners, tiles.tiles[t], dx, dz) ? t : tile;
+                    }
+                    else if(w >= 1 && h >= 1 && w <= Mesh::MERGE_SIZE && h <= Mesh::MERGE_SIZE &&
+                            sameQuad(corners, Mesh::patchTemplate(w, h), dx, dz))
+                        tile = Play::FLOOR_REPEATING[group - 1];
+                    const bool in_chunk = w >= 1 && h >= 1 && x >= chunk_x * Mesh::CHUNK_SIZE && y >= chunk_y * Mesh::CHUNK_SIZE &&
+                                          x + w <= chunk_x * Mesh::CHUNK_SIZE + window.chunkWidth(chunk_x) &&
+                                          y + h <= chunk_y * Mesh::CHUNK_SIZE + window.chunkHeight(chunk_y);
+                    if(!in_chunk)
+                    {
+                        drawn[0] = -2;
+                        continue;
+                    }
+                    for(int sy = y; sy < y + h; sy++)
+                        for(int sx = x; sx < x + w; sx++)
+                            drawn[sx + sy * window.width] = drawn[sx + sy * window.width] == -1 ? tile : -2;
+                }
+            }
+        }
+        return drawn;
+    }
+
+    // the quads of a range, sorted
+    std::vector<std::string> quadsOf(const std::vector<Vertex>& vertices, const Mesh::Chunk& range)
+    {
+        std::vector<std::string> quads;
+        for(int quad = range.first; quad < range.first + range.count; quad++)
+            quads.emplace_back(reinterpret_cast<const char*>(&vertices[quad * Mesh::QUAD_VERTICES]), Mesh::QUAD_VERTICES * sizeof(Vertex));
+        std::sort(quads.begin(), quads.end());
+        return quads;
+    }
+
+    // the quads of vertices that aren't the ones of before
+    int quadsWritten(const std::vector<Vertex>& before, const std::vector<Vertex>& vertices)
+    {
+        int written = 0;
+        for(size_t quad = 0; quad < vertices.size() / Mesh::QUAD_VERTICES; quad++)
+            written += memcmp(&before[quad * Mesh::QUAD_VERTICES], &vertices[quad * Mesh::QUAD_VERTICES], Mesh::QUAD_VERTICES * sizeof(Vertex)) != 0;
+        return written;
+    }
+
+    // A level as the benchmarks play it, with its floor meshed: its quads fresh, after the first reveal, and once every safe square is open
+    struct FloorQuads {
+        int squares, fresh, first, cleared;
+    };
+    FloorQuads playedFloor(short w, short h, int percent)
+    {
+        Play play;
+        std::vector<Vertex> vertices;
+        Bench::setUpLevel(play, w, h, percent, false, false, uint64_t(w) * 100 + percent);
+        Bench::startLevel(play, vertices);
+        FloorQuads quads;
+        quads.squares = play.window.width * play.window.height;
+        quads.fresh = play.floor_mesh.quads();
+
+        const Coord centre = {short(w / 2), short(h / 2)};
+        play.generateBombs(centre);
+        play.revealAt(centre);
+        play.updateFloor();
+        quads.first = play.floor_mesh.quads();
+
+        for(short y = 0; y < h; y++)
+        {
+            for(short x = 0; x < w; x++)
+            {
+                if(!play.board.isMine(x + y * w) && !play.board.isOpen(x + y * w))
+                    play.revealAt({x, y});
+            }
+        }
+        play.updateFloor();
+        quads.cleared = play.floor_mesh.quads();
+        return quads;
+    }
+}
+
+int Bench::mesh_suite()
+{
+    int failures = 0;
+
+    std::vector<uint16_t> indices(Mesh::BATCH_QUADS * Mesh::QUAD_INDICES);
+    Mesh::fillIndices(indices.data(), Mesh::BATCH_QUADS);
+
+    // the floor is a single layer drawn with composed tiles, where the 6 vertex layout had a second one on top
+    header("mesh: indexed quads draw the same triangles as the 6 vertex layout, top floor layer aside");
+    const short level_sizes[][2] = {{10, 10}, {25, 25}, {99, 99}, {10, 99}, {99, 10}, {17, 63}};
+    Rng rng(1);
+    for(const auto& size : level_sizes)
+    {
+        const short w = size[0], h = size[1];
+        const Mesh::Layout layout(w, h);
+        std::vector<Vertex> vertices(layout.quads() * Mesh::QUAD_VERTICES);
+        std::vector<Reference::FloatVertex> float_vertices(Reference::floatLevelSize(w, h));
+
+        Mesh::walls(vertices.data(), layout, tileUVs(20));
+        Reference::floatWalls(float_vertices.data(), w, h, tileUVs(20));
+        for(int square = 0; square < w * h; square++)
+        {
+            const Mesh::QuadUVs uvs = tileUVs(int(rng.below(12)));
+            Mesh::floorTile(vertices.data(), layout, square, Mesh::floorTemplate(uvs));
+            Reference::floatFloorTile(float_vertices.data(), w, h, 0, square, uvs);
+        }
+        const short cursor_x = short(rng.below(w)), cursor_y = short(rng.below(h));
+        Mesh::cursor(vertices.data(), layout, cursor_x, cursor_y, tileUVs(15));
+        Reference::floatCursor(float_vertices.data(), w, h, cursor_x, cursor_y, tileUVs(15));
+        Mesh::crosshair(vertices.data(), layout, tileUVs(16));
+        Reference::floatCrosshair(float_vertices.data(), w, h, tileUVs(16));
+
+        std::vector<Triangle> got = indexedTriangles(vertices, layout, indices);
+        const size_t top_layer = (w * 2 + h * 2 + w * h) * 6;
+        std::vector<Triangle> expected = floatTriangles(float_vertices, top_layer, top_layer + w * h * 6);
+        std::sort(got.begin(), got.end());
+        std::sort(expected.begin(), expected.end());
+        if(got != expected)
+        {
+            printf("FAIL: %dx%d indexed level differs from the 6 vertex one (%zu triangles, expected %zu)\n", w, h, got.size(), expected.size());
+            failures++;
+        }
+    }
+    printf("%s\n", failures ? "failed" : "ok");
+
+    // vertices of a window are around its own centre, which the shader adds back
+    header("mesh: a window has the floor, cursor and walls of the whole board, moved by its centre");
+    int window_failures = 0;
+    for(int test = 0; test < 50; test++)
+    {
+        // small enough for the whole board to fit in a Vertex too
+        const short w = short(10 + rng.below(390)), h = short(10 + rng.below(390));
+        const Mesh::Layout board(w, h);
+        const Mesh::Layout window = Mesh::window(w, h, float(rng.below(w * 4)) / 4.0f, float(rng.below(h * 4)) / 4.0f);
+        std::vector<Vertex> board_vertices(board.quads() * Mesh::QUAD_VERTICES), window_vertices(window.quads() * Mesh::QUAD_VERTICES);
+        const int dx = int(window.centreX() * Vertex::POSITION_SCALE), dz = int(window.centreZ() * Vertex::POSITION_SCALE);
+        const auto same = [&](int board_quad, int window_quad) {
+            for(int vert = 0; vert < Mesh::QUAD_VERTICES; vert++)
+            {
+                const Vertex& a = board_vertices[board_quad * Mesh::QUAD_VERTICES + vert];
+                const Vertex& b = window_vertices[window_quad * Mesh::QUAD_VERTICES + vert];
+                if(a.position[0] != b.position[0] + dx || a.position[1] != b.position[1] || a.position[2] != b.position[2] + dz ||
+                   a.texcoord[0] != b.texcoord[0] || a.texcoord[1] != b.texcoord[1])
+                    return false;
+            }
+            return true;
+        };
+
+        bool ok = window.width == std::min<int>(w, Mesh::WINDOW_SIZE) && window.height == std::min<int>(h, Mesh::WINDOW_SIZE) &&
+                  window.x0 >= 0 && window.y0 >= 0 && window.x0 + window.width <= w && window.y0 + window.height <= h;
+        for(int y = window.y0; ok && y < window.y0 + window.height; y++)
+        {
+            for(int x = window.x0; ok && x < window.x0 + window.width; x++)
+            {
+                const Mesh::QuadTemplate tile = Mesh::floorTemplate(tileUVs(int(rng.below(12))));
+                Mesh::floorTile(board_vertices.data(), board, x + y * w, tile);
+                Mesh::floorTile(window_vertices.data(), window, x + y * w, tile);
+                ok = window.contains(x + y * w) && same(board.floorQuad(x + y * w), window.floorQuad(x + y * w));
+            }
+        }
+        const short cursor_x = short(window.x0 + rng.below(window.width)), cursor_y = short(window.y0 + rng.below(window.height));
+        Mesh::cursor(board_vertices.data(), board, cursor_x, cursor_y, tileUVs(15));
+        Mesh::cursor(window_vertices.data(), window, cursor_x, cursor_y, tileUVs(15));
+        ok = ok && same(board.cursor(), window.cursor());
+
+        Mesh::walls(board_vertices.data(), board, tileUVs(20));
+        Mesh::walls(window_vertices.data(), window, tileUVs(20));
+        for(int i = 0; ok && i < window.width; i++)
+        {
+            ok = (!window.hasTopWalls() || same(board.topWalls() + window.x0 + i, window.topWalls() + i)) &&
+                 (!window.hasBottomWalls() || same(board.bottomWalls() + window.x0 + i, window.bottomWalls() + i));
+        }
+        for(int i = 0; ok && i < window.height; i++)
+        {
+            ok = (!window.hasLeftWalls() || same(board.leftWalls() + window.y0 + i, window.leftWalls() + i)) &&
+                 (!window.hasRightWalls() || same(board.rightWalls() + window.y0 + i, window.rightWalls() + i));
+        }
+        if(!ok)
+        {
+            printf("FAIL: %dx%d window at (%d, %d) differs from the whole board\n", w, h, window.x0, window.y0);
+            window_failures++;
+        }
+    }
+    printf("%s\n", window_failures ? "failed" : "ok");
+    failures += window_failures;
+
+    header("mesh: level vertex memory (KiB), one shared index buffer");
+    printf("%7s %12s %12s %12s %12s\n", "size", "6 x float", "6 x packed", "now", "indices");
+    for(const short sz : sizes)
+    {
+        const Mesh::Layout layout(sz, sz);
+        printf("%3dx%-3d %12.1f %12.1f %12.1f %12.1f\n", sz, sz,
+            Reference::floatLevelSize(sz, sz) * sizeof(Reference::FloatVertex) / 1024.0,
+            Reference::floatLevelSize(sz, sz) * sizeof(Vertex) / 1024.0,
+            layout.quads() * Mesh::QUAD_VERTICES * sizeof(Vertex) / 1024.0,
+            indices.size() * sizeof(uint16_t) / 1024.0);
+    }
+
+    // copying a template has to give the very vertices that making every corner again did, whatever the window
+    header("mesh: floor tiles copied from templates are the ones made corner by corner");
+    int template_failures = 0;
+    for(int test = 0; test < 50; test++)
+    {
+        const short w = short(10 + rng.below(990)), h = short(10 + rng.below(990));
+        const Mesh::Layout window = Mesh::window(w, h, float(rng.below(w * 4)) / 4.0f, float(rng.below(h * 4)) / 4.0f);
+        std::vector<Vertex> copied(window.quads() * Mesh::QUAD_VERTICES), made(window.quads() * Mesh::QUAD_VERTICES);
+        for(int y = window.y0; y < window.y0 + window.height; y++)
+        {
+            for(int x = window.x0; x < window.x0 + window.width; x++)
+            {
+                const int tile = int(rng.below(12));
+                Mesh::floorTile(copied.data(), window, x + y * w, Mesh::floorTemplate(Mesh::floorTileUVs(tile, 12)));
+                Reference::floorTile(made.data(), window, x + y * w, Mesh::floorTileUVs(tile, 12));
+            }
+        }
+        if(memcmp(copied.data(), made.data(), copied.size() * sizeof(Vertex)) != 0)
+        {
+            printf("FAIL: %dx%d window at (%d, %d) has floor tiles that differ from the ones made corner by corner\n", w, h, window.x0, window.y0);
+            template_failures++;
+        }
+    }
+    printf("%s\n", template_failures ? "failed" : "ok");
+    failures += template_failures;
+
+    // every square drawn once, with its own tile, however the tiles change and however often the floor is meshed again
+    header("mesh: the merged floor draws every square with its tile, meshed again or from scratch");
+    int merge_failures = 0;
+    const FloorTiles floor_tiles;
+    for(int test = 0; test < 40; test++)
+    {
+        const short w = short(10 + rng.below(300)), h = short(10 + rng.below(300));
+        const Mesh::Layout window = Mesh::window(w, h, float(rng.below(w)), float(rng.below(h)));
+        std::vector<int> tiles(window.width * window.height, Play::FLOOR_HIDDEN);
+        std::vector<Vertex> vertices(window.quads() * Mesh::QUAD_VERTICES), fresh_vertices(vertices.size());
+        const auto square_of = [&](int x, int y) { return window.x0 + x + (window.y0 + y) * w; };
+
+        Mesh::Floor floor;
+        floor.reset(window);
+        for(int round = 0; round < 4; round++)
+        {
+            // openings as rectangles, and tiles of every kind scattered around
+            for(int opening = 0; opening < 6; opening++)
+            {
+                const int x0 = int(rng.below(window.width)), y0 = int(rng.below(window.height));
+                const int x1 = std::min(window.width, x0 + 1 + int(rng.below(40))), y1 = std::min(window.height, y0 + 1 + int(rng.below(40)));
+                for(int y = y0; y < y1; y++)
+                    for(int x = x0; x < x1; x++)
+                        tiles[x + y * window.width] = Play::FLOOR_OPEN;
+            }
+            for(int scattered = int(rng.below(window.width * window.height / 4)); scattered > 0; scattered--)
+                tiles[rng.below(window.width * window.height)] = int(rng.below(FLOOR_TILES));
+            for(int y = 0; y < window.height; y++)
+                for(int x = 0; x < window.width; x++)
+                    floor.set(square_of(x, y), tiles[x + y * window.width]);
+            floor.update(vertices.data(), floor_tiles.tiles, floor_tiles.groups);
+        }
+
+        Mesh::Floor fresh;
+        fresh.reset(window);
+        for(int y = 0; y < window.height; y++)
+            for(int x = 0; x < window.width; x++)
+                fresh.set(square_of(x, y), tiles[x + y * window.width]);
+        fresh.update(fresh_vertices.data(), floor_tiles.tiles, floor_tiles.groups);
+
+        // the squares on their own in whatever order their quads were patched in
+        bool same = true;
+        for(int group = 0; group < Mesh::FLOOR_GROUPS; group++)
+        {
+            for(size_t chunk = 0; chunk < floor.groups[group].size(); chunk++)
+            {
+                const Mesh::Chunk& a = floor.groups[group][chunk];
+                const Mesh::Chunk& b = fresh.groups[group][chunk];
+                same = same && a.first == b.first && a.count == b.count &&
+                       (group == 0 ? quadsOf(vertices, a) == quadsOf(fresh_vertices, b) :
+                        memcmp(&vertices[a.first * Mesh::QUAD_VERTICES], &fresh_vertices[b.first * Mesh::QUAD_VERTICES],
+                               a.count * Mesh::QUAD_VERTICES * sizeof(Vertex)) == 0);
+            }
+        }
+        if(drawnTiles(floor, vertices, window, floor_tiles) != tiles || !same)
+        {
+            printf("FAIL: %dx%d window at (%d, %d) draws squares with the wrong tiles, or differs meshed again from scratch\n", w, h, window.x0, window.y0);
+            merge_failures++;
+        }
+
+        // a square changing writes its own quad, the one moving into it, and the patches of its chunk
+        const int x = int(rng.below(window.width)), y = int(rng.below(window.height));
+        tiles[x + y * window.width] = tiles[x + y * window.width] == Play::FLOOR_FLAGGED ? Play::FLOOR_OPEN : Play::FLOOR_FLAGGED;
+        floor.set(square_of(x, y), tiles[x + y * window.width]);
+        const std::vector<Vertex> before = vertices;
+        floor.update(vertices.data(), floor_tiles.tiles, floor_tiles.groups);
+        const int chunk = x / Mesh::CHUNK_SIZE + y / Mesh::CHUNK_SIZE * window.chunks_x;
+        int patches = 0;
+        for(int group = 1; group < Mesh::FLOOR_GROUPS; group++)
+            patches += floor.groups[group][chunk].count;
+        const int written = quadsWritten(before, vertices);
+        if(written > 1 + patches)
+        {
+            printf("FAIL: %dx%d window at (%d, %d) wrote %d quads for one square, its chunk has %d patches\n", w, h, window.x0, window.y0, written, patches);
+            merge_failures++;
+        }
+    }
+    printf("%s\n", merge_failures ? "failed" : "ok");
+    failures += merge_failures;
+
+    header("mesh: floor quads of a level, one a square and merged");
+    printf("%9s %8s %10s %10s %10s\n", "level", "squares", "fresh", "1st reveal", "cleared");
+    for(const short sz : sizes)
+    {
+        for(const int percent : densities)
+        {
+            const FloorQuads quads = playedFloor(sz, sz, percent);
+            printf("%3dx%-3d%2d%% %8d %10d %10d %10d\n", sz, sz, percent, quads.squares, quads.fresh, quads.first, quads.cleared);
+        }
+    }
+    {
+        const FloorQuads quads = playedFloor(1000, 1000, 20);
+        printf("%9s %8d %10d %10d %10d\n", "1000x1000", quads.squares, quads.fresh, quads.first, quads.cleared);
+    }
+
+    header("mesh: writing the whole floor (us per level)");
+    printf("%7s %12s %12s %12s\n", "size", "2 layers", "by corner", "template");
+    for(const short sz : sizes)
+    {
+        const Mesh::Layout layout(sz, sz);
+        std::vector<Vertex> vertices(layout.quads() * Mesh::QUAD_VERTICES);
+        std::vector<Reference::FloatVertex> float_vertices(Reference::floatLevelSize(sz, sz));
+        const Mesh::QuadUVs uvs = tileUVs(3);
+        const Mesh::QuadTemplate tile = Mesh::floorTemplate(uvs);
+
+        const double two_layers = time_us([&]() {
+            for(int layer = 0; layer < 2; layer++)
+                for(int square = 0; square < sz * sz; square++)
+                    Reference::floatFloorTile(float_vertices.data(), sz, sz, layer, square, uvs);
+        });
+        const double by_corner = time_us([&]() {
+            for(int square = 0; square < sz * sz; square++)
+                Reference::floorTile(vertices.data(), layout, square, uvs);
+        });
+        const double from_template = time_us([&]() {
+            for(int square = 0; square < sz * sz; square++)
+                Mesh::floorTile(vertices.data(), layout, square, tile);
+        });
+        printf("%3dx%-3d %12.1f %12.1f %12.1f\n", sz, sz, two_layers, by_corner, from_template);
+    }
+
+    // a square changing means patching its chunk, the bytes it writes against the ones of its whole chunk
+    header("mesh: meshing the merged floor (us), and vertex bytes a flag writes");
+    printf("%7s %12s %12s %12s %12s %12s\n", "size", "one a square", "merged", "one changed", "flag bytes", "chunk bytes");
+    for(const short sz : sizes)
+    {
+        const Mesh::Layout layout(sz, sz);
+        std::vector<Vertex> vertices(layout.quads() * Mesh::QUAD_VERTICES);
+        std::vector<int> tiles(sz * sz);
+        for(int& tile : tiles)
+            tile = rng.below(4) == 0 ? int(rng.below(FLOOR_TILES)) : Play::FLOOR_OPEN;
+        Mesh::Floor floor;
+
+        const double one_a_square = time_us([&]() {
+            for(int square = 0; square < sz * sz; square++)
+                Mesh::floorTile(vertices.data(), layout, square, floor_tiles.tiles[tiles[square]]);
+        });
+        const double merged = time_us([&]() {
+            floor.reset(layout);
+            for(int square = 0; square < sz * sz; square++)
+                floor.set(square, tiles[square]);
+            floor.update(vertices.data(), floor_tiles.tiles, floor_tiles.groups);
+        });
+        int square = 0;
+        const double one_changed = time_us([&]() {
+            square = (square + 7919) % (sz * sz);
+            tiles[square] = tiles[square] == Play::FLOOR_OPEN ? Play::FLOOR_FLAGGED : Play::FLOOR_OPEN;
+            floor.set(square, tiles[square]);
+            floor.update(vertices.data(), floor_tiles.tiles, floor_tiles.groups);
+        });
+
+        // flags going on and off hidden squares, a few hundred of them
+        for(int& tile : tiles)
+            tile = tile == Play::FLOOR_OPEN && rng.below(2) == 0 ? Play::FLOOR_HIDDEN : tile;
+        for(int at = 0; at < sz * sz; at++)
+            floor.set(at, tiles[at]);
+        floor.update(vertices.data(), floor_tiles.tiles, floor_tiles.groups);
+        long flag_bytes = 0, chunk_bytes = 0;
+        int flags = 0;
+        for(int toggle = 0; toggle < 400; toggle++)
+        {
+            square = (square + 7919) % (sz * sz);
+            if(tiles[square] != Play::FLOOR_HIDDEN && tiles[square] != Play::FLOOR_FLAGGED)
+                continue;
+            tiles[square] = tiles[square] == Play::FLOOR_HIDDEN ? Play::FLOOR_FLAGGED : Play::FLOOR_HIDDEN;
+            floor.set(square, tiles[square]);
+            const std::vector<Vertex> before = vertices;
+            floor.update(vertices.data(), floor_tiles.tiles, floor_tiles.groups);
+            const int chunk = square % sz / Mesh::CHUNK_SIZE + square / sz / Mesh::CHUNK_SIZE * layout.chunks_x;
+            for(int group = 0; group < Mesh::FLOOR_GROUPS; group++)
+                chunk_bytes += floor.groups[group][chunk].count * Mesh::QUAD_VERTICES * sizeof(Vertex);
+            flag_bytes += quadsWritten(before, vertices) * Mesh::QUAD_VERTICES * sizeof(Vertex);
+            flags++;
+        }
+        printf("%3dx%-3d %12.1f %12.1f %12.2f %12.0f %12.0f\n", sz, sz, one_a_square, merged, one_changed,
+               double(flag_bytes) / flags, double(chunk_bytes) / flags);
+    }
+
+    return failures;
+}
@@ -0,0 +1,80 @@
+#include "bench.h"
+
+#include "board.h"
+#include "neighbours.h"
+#include "reference.h"
+
+namespace {
+    // a generated board, with the counts worked out one bomb at a time
+    Board make_board(short w, short h, int percent, uint64_t seed)
+    {
+        Board board;
+        board.reset(w, h, percent * w * h / 100);
+        board.generateBombs({short(w / 2), short(h / 2)}, seed);
+        Reference::countPerBomb(board);
+        return board;
+    }
+
+    int check(short w, short h, int percent, uint64_t seed)
+    {
+        const Board board = make_board(w, h, percent, seed);
+        std::vector<uint8_t> scratch;
+        int failures = 0;
+        for(const auto kernel : {Neighbours::Kernel::Scalar, Neighbours::Kernel::Vector})
+        {
+            std::vector<uint8_t> counts(board.counts.size(), 0xFF);
+            Neighbours::count(board.mine_bits.data(), w, h, counts.data(), scratch, kernel);
+            if(counts != board.counts)
+            {
+                printf("FAIL: %dx%d seed %d, the %s kernel disagrees with the per-bomb counts\n", w, h, int(seed),
+                       kernel == Neighbours::Kernel::Scalar ? "scalar" : "vector");
+                failures++;
+            }
+        }
+        return failures;
+    }
+}
+
+int Bench::neighbours_suite()
+{
+    int failures = 0;
+
+    header("neighbours: kernels against per-bomb counts");
+    uint64_t seed = 0;
+    // every size the menu allows, then a few more
+    for(short w = 10; w <= 99; w++)
+    {
+        for(short h = 10; h <= 99; h++)
+        {
+            failures += check(w, h, 10 + (w + h) % 31, seed++);
+        }
+    }
+    for(const short sz : {128, 255, 256, 257, 512, 1000})
+    {
+        failures += check(sz, sz, 20, seed++);
+        failures += check(sz, 11, 20, seed++);
+        failures += check(13, sz, 20, seed++);
+    }
+    printf("%s\n", failures ? "failed" : "ok");
+
+    header("neighbours: counting a whole board (us per board)");
+    printf("%9s %5s %12s %12s %12s\n", "size", "bombs", "per bomb", "scalar", "vector");
+    for(const short sz : {10, 25, 50, 75, 99, 128, 256, 512, 1000})
+    {
+        for(const int percent : {10, 40})
+        {
+            Board board = make_board(sz, sz, percent, seed++);
+            const double per_bomb = time_us([&]() {
+                Reference::countPerBomb(board);
+            });
+            const double scalar = time_us([&]() {
+                Neighbours::count(board.mine_bits.data(), sz, sz, board.counts.data(), board.count_scratch, Neighbours::Kernel::Scalar);
+            });
+            const double vector = time_us([&]() {
+                Neighbours::count(board.mine_bits.data(), sz, sz, board.counts.data(), board.count_scratch, Neighbours::Kernel::Vector);
+            });
+            printf("%4dx%-4d %6d %12.3f %12.3f %12.3f\n", sz, sz, board.bombs, per_bomb, scalar, vector);
+        }
+    }
+    return failures;
+}
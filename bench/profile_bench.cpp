@@ -0,0 +1,122 @@
+#include "bench.h"
+
+#include "profile.h"
+
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    // the host counts in nanoseconds
+    constexpr Profile::Ticks TICKS_PER_US = 1000;
+
+    bool near(double a, double b)
+    {
+        return fabs(a - b) < 0.01;
+    }
+}
+
+int Bench::profile_suite()
+{
+    int failures = 0;
+
+    header("profile: summaries and the ring of frames");
+    {
+        // 1 to 100 us of update, and the cursor twice in every other frame
+        Profile::reset();
+        for(int frame = 1; frame <= 100; frame++)
+        {
+            Profile::add(Profile::Update, frame * TICKS_PER_US);
+            if(frame % 2 == 0)
+            {
+                Profile::add(Profile::Cursor, 3 * TICKS_PER_US);
+                Profile::add(Profile::Cursor, 3 * TICKS_PER_US);
+            }
+            Profile::endFrame();
+        }
+        const Profile::Summary update = Profile::summarize(Profile::Update);
+        const Profile::Summary cursor = Profile::summarize(Profile::Cursor);
+        const Profile::Summary gui = Profile::summarize(Profile::Gui);
+        if(Profile::frames() != 100 || !near(update.min, 1.0) || !near(update.avg, 50.5) || !near(update.p99, 99.0) ||
+           !near(cursor.min, 0.0) || !near(cursor.avg, 3.0) || !near(cursor.p99, 6.0) || !near(gui.avg, 0.0))
+        {
+            printf("FAIL: the summaries of 100 known frames are wrong: update %.2f %.2f %.2f, cursor %.2f %.2f %.2f\n",
+                   update.min, update.avg, update.p99, cursor.min, cursor.avg, cursor.p99);
+            failures++;
+        }
+
+        // going round: only the last FRAMES are kept, oldest first
+        for(int frame = 101; frame <= Profile::FRAMES + 110; frame++)
+        {
+            Profile::add(Profile::Input, frame * TICKS_PER_US);
+            Profile::endFrame();
+        }
+        std::vector<uint8_t> csv;
+        Profile::writeCsv(csv);
+        const std::string text(csv.begin(), csv.end());
+        std::vector<std::string> lines;
+        size_t start = 0;
+        for(size_t end; (end = text.find('\n', start)) != std::string::npos; start = end + 1)
+            lines.push_back(text.substr(start, end - start));
+        const std::string oldest = std::to_string(111) + ".0,";
+        if(Profile::frames() != Profile::FRAMES || lines.size() != size_t(Profile::FRAMES + 1) ||
+           lines[0] != "input,update,floor,cursor,generation,left eye,right eye,gui" || lines[1].compare(0, oldest.size(), oldest) != 0 ||
+           !near(Profile::summarize(Profile::Input).min, 111.0))
+        {
+            printf("FAIL: the ring doesn't keep the last %d frames in order\n", Profile::FRAMES);
+            failures++;
+        }
+
+        // the worker adds to the same frame as the main loop
+        Profile::reset();
+        constexpr int ADDS = 100000;
+        std::thread worker([]() {
+            for(int i = 0; i < ADDS; i++)
+                Profile::add(Profile::Generation, 1);
+        });
+        for(int i = 0; i < ADDS; i++)
+            Profile::add(Profile::Generation, 1);
+        worker.join();
+        Profile::endFrame();
+        if(!near(Profile::summarize(Profile::Generation).avg, 2.0 * ADDS / TICKS_PER_US))
+        {
+            printf("FAIL: adds from two threads at once were lost\n");
+            failures++;
+        }
+
+        // and a phase too long for 32 bits stays as long as they go
+        Profile::reset();
+        Profile::add(Profile::Update, Profile::Ticks(1) << 40);
+        Profile::add(Profile::Update, 1);
+        Profile::endFrame();
+        if(!near(Profile::summarize(Profile::Update).avg, double(UINT32_MAX) / TICKS_PER_US))
+        {
+            printf("FAIL: a phase longer than 32 bits wrapped around\n");
+            failures++;
+        }
+    }
+    printf("%s\n", failures ? "failed" : "ok");
+
+    header("profile: what timing costs, ns");
+    {
+        Profile::reset();
+        const double scope_us = time_us([]() {
+            for(int i = 0; i < 1000; i++)
+                const Profile::Scope timed(Profile::Floor);
+        });
+        const double end_us = time_us([]() {
+            Profile::endFrame();
+        });
+        const double summary_us = time_us([]() {
+            for(int phase = 0; phase < Profile::PHASES; phase++)
+                Profile::summarize(Profile::Phase(phase));
+        });
+        printf("%-28s %10.1f\n", "a scope", scope_us);
+        printf("%-28s %10.1f\n", "closing a frame", end_us * 1000.0);
+        printf("%-28s %10.1f\n", "summaries of every phase", summary_us * 1000.0);
+        Profile::reset();
+    }
+
+    return failures;
+}
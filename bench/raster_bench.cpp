@@ -0,0 +1,500 @@
+#include "bench.h"
+
+#include "atlas.h"
+#include "culling.h"
+#include "play.h"
+#include "raster.h"
+#include "rng.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr float DEGREES_TO_RADIANS = 3.14159265f / 180.0f;
+    constexpr uint32_t CLEAR_COLOR_TOP = 0x68B0D8FF;
+    constexpr int TILE_SIZE = 32;
+
+    // Stand-ins for the sprite sheet and the floor tiles ProgramWide composes out of it,
+    // plain enough that a picture of them can be read
+    struct Textures {
+        std::vector<uint32_t> sprites, floor, repeats[Mesh::REPEATING];
+        static constexpr int SPRITES_SIZE = 2 * TILE_SIZE;
+        static constexpr int FLOOR_WIDTH = Mesh::FLOOR_ATLAS_WIDTH, FLOOR_HEIGHT = Mesh::floorAtlasHeight(Play::FLOOR_TILES);
+        static constexpr int REPEAT_SIZE = TILE_SIZE * Mesh::REPEAT_COPIES;
+        Raster::Texture floor_groups[Mesh::FLOOR_GROUPS];
+
+        Textures() : sprites(SPRITES_SIZE * SPRITES_SIZE), floor(FLOOR_WIDTH * FLOOR_HEIGHT)
+        {
+            floor_groups[0] = floorTexture();
+            for(int group = 0; group < Mesh::REPEATING; group++)
+            {
+                repeats[group].resize(REPEAT_SIZE * REPEAT_SIZE);
+                floor_groups[1 + group] = {repeats[group].data(), REPEAT_SIZE, REPEAT_SIZE, true};
+            }
+        }
+        Textures(const Textures&) = delete;
+
+        Raster::Texture spritesTexture() const
+        {
+            return {sprites.data(), SPRITES_SIZE, SPRITES_SIZE, false};
+        }
+        Raster::Texture floorTexture() const
+        {
+            return {floor.data(), FLOOR_WIDTH, FLOOR_HEIGHT, false};
+        }
+        // one for each group of the floor, see Mesh::Floor
+        const Raster::Texture* floorTextures() const
+        {
+            return floor_groups;
+        }
+    };
+
+    // corners in the order of subtex_uv_funcs: bottom right, bottom left, top right, top left
+    Mesh::QuadUVs tileUVs(int x, int y, int width, int height)
+    {
+        const float left = float(x) / width, right = float(x + TILE_SIZE) / width;
+        const float bottom = float(y) / height, top = float(y + TILE_SIZE) / height;
+        return {{right, left, right, left}, {bottom, bottom, top, top}};
+    }
+
+    // texel(tx, ty) for each texel of the tile at (x, y) of texels, ty going up
+    template<typename Texel>
+    void paint(std::vector<uint32_t>& texels, int width, int x, int y, Texel texel)
+    {
+        for(int ty = 0; ty < TILE_SIZE; ty++)
+            for(int tx = 0; tx < TILE_SIZE; tx++)
+                texels[Atlas::texelOffset(x + tx, y + ty, width)] = texel(tx, ty);
+    }
+
+    // Gives play the UVs MineSweeper would, into textures
+    void makeTextures(Textures& textures, Play& play)
+    {
+        const auto border = [](int tx, int ty, int width) {
+            return tx < width || ty < width || tx >= TILE_SIZE - width || ty >= TILE_SIZE - width;
+        };
+        const auto centre = [](int tx, int ty, int half) {
+            return abs(2 * tx + 1 - TILE_SIZE) < 2 * half && abs(2 * ty + 1 - TILE_SIZE) < 2 * half;
+        };
+
+        const int size = Textures::SPRITES_SIZE;
+        paint(textures.sprites, size, 0, 0, [](int tx, int ty) {
+            return ((ty / 8 + (tx / 16) * 2) % 4 == 0 || ty % 8 == 0) ? 0x6E4A2EFFu : 0xA0704AFFu;
+        });
+        paint(textures.sprites, size, TILE_SIZE, 0, [&](int tx, int ty) {
+            return border(tx, ty, 3) ? 0xFFE040FFu : 0x00000000u;
+        });
+        paint(textures.sprites, size, 0, TILE_SIZE, [&](int tx, int ty) {
+            return (centre(tx, ty, 2) || centre(tx, ty, 12)) && !centre(tx, ty, 10) ? 0xFFFFFFFFu : 0x00000000u;
+        });
+        play.wall_uvs = tileUVs(0, 0, size, size);
+        for(Mesh::QuadUVs& uvs : play.cursor_uvs)
+            uvs = tileUVs(TILE_SIZE, 0, size, size);
+        play.crosshair_uvs = tileUVs(0, TILE_SIZE, size, size);
+
+        // {base, overlay} as setupFloorTiles has them, where Mesh::floorTileUVs has them
+        const uint32_t hidden = 0x9098A0FFu, open = 0xE0D8C0FFu;
+        const uint32_t numbers[8] = {0x2040E0FFu, 0x20A040FFu, 0xE03020FFu, 0x202080FFu, 0x802020FFu, 0x208080FFu, 0x202020FFu, 0x808080FFu};
+        for(int tile = 0; tile < Play::FLOOR_TILES; tile++)
+        {
+            const int x = (tile % Mesh::FLOOR_ATLAS_COLUMNS) * TILE_SIZE, y = (tile / Mesh::FLOOR_ATLAS_COLUMNS) * TILE_SIZE;
+            paint(textures.floor, Textures::FLOOR_WIDTH, x, y, [&](int tx, int ty) {
+                const uint32_t base = tile == Play::FLOOR_EXPLODED ? 0xE02010FFu : (tile < Play::FLOOR_OPEN ? hidden : open);
+                if(border(tx, ty, 2))
+                    return base - 0x30303000u;
+                if(tile == Play::FLOOR_FLAGGED && centre(tx, ty, 8))
+                    return 0xE02010FFu;
+                if(tile == Play::FLOOR_EXPLODED && centre(tx, ty, 8))
+                    return 0x101010FFu;
+                if(tile >= Play::FLOOR_NUMBERS && centre(tx, ty, 6))
+                    return numbers[tile - Play::FLOOR_NUMBERS];
+                return base;
+            });
+        }
+
+        // and the repeating ones copied all over their own textures, the way composeFloorTiles does it
+        for(int group = 0; group < Mesh::REPEATING; group++)
+        {
+            const int tile = Play::FLOOR_REPEATING[group];
+            const int x = (tile % Mesh::FLOOR_ATLAS_COLUMNS) * TILE_SIZE, y = (tile / Mesh::FLOOR_ATLAS_COLUMNS) * TILE_SIZE;
+            for(int copy = 0; copy < Mesh::REPEAT_COPIES * Mesh::REPEAT_COPIES; copy++)
+            {
+                paint(textures.repeats[group], Textures::REPEAT_SIZE, copy % Mesh::REPEAT_COPIES * TILE_SIZE, copy / Mesh::REPEAT_COPIES * TILE_SIZE,
+                      [&](int tx, int ty) {
+                    return textures.floor[Atlas::texelOffset(x + tx, y + ty, Textures::FLOOR_WIDTH)];
+                });
+            }
+        }
+    }
+
+    // A level started from the menu and revealed once, straight down from where the player starts
+    void open(Play& play, Textures& textures, std::vector<Vertex>& vertices, short w, short h, bool endless, uint64_t seed)
+    {
+        Bench::setUpLevel(play, w, h, 20, endless, false, seed);
+        makeTextures(textures, play);
+        Bench::startLevel(play, vertices);
+
+        Play::Frame frame = {0, Keys::DDOWN, 0, 0, true};
+        while(play.angleY > -60.0f)
+            play.update(frame);
+        frame = {Keys::R, Keys::R, 0, 0, true};
+        play.update(frame);
+        play.worker.wait();
+        frame = {0, 0, 0, 0, true};
+        for(int i = 0; i < 3; i++)
+            play.update(frame);
+    }
+
+    // Every pixel written by the quads, as (sum of x, sum of y, count)
+    struct Drawn {
+        double x, y;
+        long count;
+    };
+    Drawn drawnPixels(const Raster::Target& target)
+    {
+        Drawn drawn = {0.0, 0.0, 0};
+        for(int pixel = 0; pixel < Raster::WIDTH * Raster::HEIGHT; pixel++)
+        {
+            if(target.depth[pixel] > 0.0f)
+            {
+                drawn.x += pixel % Raster::WIDTH;
+                drawn.y += pixel / Raster::WIDTH;
+                drawn.count++;
+            }
+        }
+        return drawn;
+    }
+
+    // Every floor quad of the window, in the order draw goes through the chunks the culling keeps
+    void drawUnculled(Raster::Target& target, const Play& play, const Textures& textures, Raster::Stats& stats)
+    {
+        const Mesh::Layout& layout = play.window;
+        Raster::Uniforms uniforms = Raster::levelUniforms(layout, play.positionX, play.positionZ, play.camera(), 0.0f);
+        const Raster::Texture sprites = textures.spritesTexture();
+        const int firsts[4] = {layout.topWalls(), layout.bottomWalls(), layout.leftWalls(), layout.rightWalls()};
+        const int counts[4] = {
+            layout.hasTopWalls() ? layout.width : 0,
+            layout.hasBottomWalls() ? layout.width : 0,
+            layout.hasLeftWalls() ? layout.height : 0,
+            layout.hasRightWalls() ? layout.height : 0,
+        };
+        const float normals[4][2] = {{0.0f, 1.0f}, {0.0f, -1.0f}, {1.0f, 0.0f}, {-1.0f, 0.0f}};
+        for(int side = 0; side < 4; side++)
+        {
+            uniforms.normal[0] = normals[side][0];
+            uniforms.normal[1] = 0.0f;
+            uniforms.normal[2] = normals[side][1];
+            Raster::drawQuads(target, uniforms, sprites, play.vertices, firsts[side], counts[side], stats);
+        }
+        uniforms.normal[0] = 0.0f;
+        uniforms.normal[1] = 1.0f;
+        uniforms.normal[2] = 0.0f;
+        for(int group = 0; group < Mesh::FLOOR_GROUPS; group++)
+        {
+            for(const Mesh::Chunk& chunk : play.floor_mesh.groups[group])
+                Raster::drawQuads(target, uniforms, textures.floorTextures()[group], play.vertices, chunk.first, chunk.count, stats);
+        }
+        if(play.looking_at_floor)
+            Raster::drawQuads(target, uniforms, sprites, play.vertices, layout.cursor(), 1, stats);
+        Raster::drawQuads(target, Raster::crosshairUniforms(), sprites, play.vertices, layout.crosshair(), 1, stats);
+    }
+
+    // Every safe square of the window opened, the way a board looks once it's nearly won
+    void clearWindow(Play& play)
+    {
+        for(short y = short(play.window.y0); y < play.window.y0 + play.window.height; y++)
+        {
+            for(short x = short(play.window.x0); x < play.window.x0 + play.window.width; x++)
+            {
+                const int square = x + y * play.width;
+                if(!play.board.isMine(square) && !play.board.isOpen(square))
+                    play.revealAt({x, y});
+            }
+        }
+        play.updateFloor();
+    }
+
+    // The floor triangles draw submits for the camera of play, or would without leaving out the chunks past LOD_DISTANCE
+    long floorTriangles(const Play& play, bool lod)
+    {
+        const Culling::View view = Culling::makeView(play.window, play.positionX, play.positionZ, play.camera(), 0.0f);
+        std::vector<Culling::Range> ranges;
+        long quads = 0;
+        for(int group = 0; group < Mesh::FLOOR_GROUPS; group++)
+        {
+            if(lod)
+            {
+                Culling::visibleRanges(view, play.floor_mesh.groups[group], ranges);
+                for(const Culling::Range& range : ranges)
+                    quads += range.count;
+            }
+            else
+            {
+                for(const Mesh::Chunk& chunk : play.floor_mesh.groups[group])
+                    quads += Culling::visible(view, chunk) ? chunk.count : 0;
+            }
+        }
+        return quads * 2;
+    }
+
+    uint32_t fnv1a(const std::vector<uint32_t>& pixels)
+    {
+        uint32_t hash = 2166136261u;
+        for(const uint32_t pixel : pixels)
+        {
+            for(int shift = 0; shift < 32; shift += 8)
+                hash = (hash ^ ((pixel >> shift) & 0xFF)) * 16777619u;
+        }
+        return hash;
+    }
+}
+
+int Bench::raster_suite()
+{
+    int failures = 0;
+    Textures textures;
+    std::vector<Vertex> vertices;
+    Raster::Target target;
+
+    header("raster: the screen agrees with the camera Play and Culling use");
+    {
+        Play play;
+        open(play, textures, vertices, 99, 99, false, 1);
+        std::vector<Vertex> single(vertices.size());
+        Rng rng(2);
+        int bad_sight = 0, bad_sides = 0;
+        for(int test = 0; test < 200; test++)
+        {
+            play.angleX = float(rng.below(3600)) / 10.0f;
+            play.angleY = -20.0f - float(rng.below(600)) / 10.0f;
+
+            // the square under the crosshair, as updateCursorLookingAt finds it, is in the middle of the screen
+            play.looking_at_floor = false;
+            play.updateCursorLookingAt(play.camera());
+            if(play.looking_at_floor)
+            {
+                // its own quad, the floor of play having it merged with others
+                const int square = play.looking_at_x + play.looking_at_y * play.width;
+                Mesh::floorTile(single.data(), play.window, square, Mesh::floorTemplate(Mesh::floorTileUVs(Play::FLOOR_HIDDEN, Play::FLOOR_TILES)));
+                const Raster::Uniforms uniforms = Raster::levelUniforms(play.window, play.positionX, play.positionZ, play.camera(), 0.0f);
+                Raster::Stats stats = {};
+                target.clear(0);
+                Raster::drawQuads(target, uniforms, textures.floorTexture(), single.data(), play.window.floorQuad(square), 1, stats);
+                bool centred = false;
+                for(int y = Raster::HEIGHT / 2 - 1; y <= Raster::HEIGHT / 2; y++)
+                    for(int x = Raster::WIDTH / 2 - 1; x <= Raster::WIDTH / 2; x++)
+                        centred = centred || target.depth[x + y * Raster::WIDTH] > 0.0f;
+                bad_sight += !centred;
+            }
+
+            // a speck to the right of the line of sight and above it is drawn right of the middle and above it, both ways round
+            const Culling::View view = Culling::makeView(play.window, play.positionX, play.positionZ, play.camera(), 0.0f);
+            const float yaw = play.angleX * DEGREES_TO_RADIANS, pitch = play.angleY * DEGREES_TO_RADIANS;
+            const float forward[3] = {-cosf(yaw) * cosf(pitch), sinf(pitch), -sinf(yaw) * cosf(pitch)};
+            const float right[3] = {sinf(yaw), 0.0f, -cosf(yaw)};
+            const float up[3] = {
+                right[1] * forward[2] - right[2] * forward[1],
+                right[2] * forward[0] - right[0] * forward[2],
+                right[0] * forward[1] - right[1] * forward[0],
+            };
+            Vertex speck[2 * Mesh::QUAD_VERTICES];
+            for(int corner = 0; corner < Mesh::QUAD_VERTICES; corner++)
+            {
+                const float dx = (corner % 2) * 0.1f, dy = (corner / 2) * 0.1f;
+                float at[3];
+                for(int axis = 0; axis < 3; axis++)
+                    at[axis] = view.eye[axis] + forward[axis] * 5.0f + right[axis] * (1.0f + dx) + up[axis] * (1.0f + dy);
+                speck[corner] = Vertex(at[0], at[1], at[2], 0.0f, 0.0f);
+                speck[Mesh::QUAD_VERTICES + (corner == 1 ? 2 : (corner == 2 ? 1 : corner))] = speck[corner];
+            }
+            const Raster::Uniforms uniforms = Raster::levelUniforms(play.window, play.positionX, play.positionZ, play.camera(), 0.0f);
+            Raster::Stats stats = {};
+            target.clear(0);
+            Raster::drawQuads(target, uniforms, textures.spritesTexture(), speck, 0, 2, stats);
+            const Drawn drawn = drawnPixels(target);
+            bad_sides += drawn.count == 0 || stats.culled != 2 || drawn.x / drawn.count < Raster::WIDTH / 2 || drawn.y / drawn.count > Raster::HEIGHT / 2;
+        }
+        if(bad_sight)
+        {
+            printf("FAIL: %d of the squares looked at weren't under the crosshair\n", bad_sight);
+            failures++;
+        }
+        if(bad_sides)
+        {
+            printf("FAIL: %d specks were drawn somewhere else than the camera sees them, or with both sides or none\n", bad_sides);
+            failures++;
+        }
+        printf("%s\n", failures ? "failed" : "ok");
+    }
+
+    header("raster: walls face the player, culling never changes the picture");
+    {
+        int bad_walls = 0, bad_pictures = 0;
+        Play play;
+        open(play, textures, vertices, 10, 10, false, 3);
+        for(int angle = 0; angle < 360; angle += 30)
+        {
+            const Raster::Uniforms uniforms = Raster::levelUniforms(play.window, play.positionX, play.positionZ, Camera::basis(float(angle), 0.0f), 0.0f);
+            Raster::Stats stats = {};
+            target.clear(0);
+            Raster::drawQuads(target, uniforms, textures.spritesTexture(), play.vertices, play.window.topWalls(), play.window.floorStart(), stats);
+            bad_walls += drawnPixels(target).count == 0;
+        }
+
+        Raster::Target full;
+        const struct {
+            short w, h;
+            bool endless;
+        } levels[] = {{10, 10, false}, {25, 25, false}, {99, 99, false}, {1000, 1000, false}, {0, 0, true}};
+        Rng rng(4);
+        for(const auto& level : levels)
+        {
+            Play play;
+            open(play, textures, vertices, level.w, level.h, level.endless, 5);
+            for(int test = 0; test < 8; test++)
+            {
+                play.angleX = float(rng.below(360));
+                play.angleY = -float(rng.below(80));
+                Raster::Stats stats = {}, full_stats = {};
+                target.clear(CLEAR_COLOR_TOP);
+                full.clear(CLEAR_COLOR_TOP);
+                Raster::draw(target, play.window, play.vertices, play.floor_mesh, textures.spritesTexture(), textures.floorTextures(),
+                             play.positionX, play.positionZ, play.camera(), play.looking_at_floor, 0.0f, stats);
+                drawUnculled(full, play, textures, full_stats);
+                bad_pictures += target.color != full.color;
+            }
+        }
+        if(bad_walls)
+        {
+            printf("FAIL: %d ways of looking from the middle of a 10x10 level saw no wall\n", bad_walls);
+            failures++;
+        }
+        if(bad_pictures)
+        {
+            printf("FAIL: %d pictures changed when the floor chunks out of sight were skipped\n", bad_pictures);
+            failures++;
+        }
+        printf("%s\n", bad_walls || bad_pictures ? "failed" : "ok");
+    }
+
+    header("raster: chunks past LOD_DISTANCE left out, floor triangles a frame and pixels that change");
+    printf("%-18s %-8s %12s %12s %9s\n", "level", "view", "every chunk", "near ones", "changed");
+    {
+        // past LOD_DISTANCE the shader has dropped the floor below what's in front of it:
+        // leaving it out takes the triangles away and leaves every pixel as it was
+        const struct {
+            const char* name;
+            short w, h;
+            bool endless, cleared;
+        } levels[] = {
+            {"99x99", 99, 99, false, false},
+            {"1000x1000", 1000, 1000, false, false},
+            {"1000x1000 cleared", 1000, 1000, false, true},
+            {"endless", 0, 0, true, false},
+        };
+        const struct {
+            const char* name;
+            float angleY;
+        } views[] = {{"down", -60.0f}, {"ahead", -15.0f}, {"level", 0.0f}, {"up", 20.0f}};
+        Raster::Target full;
+        int bad = 0;
+        for(const auto& level : levels)
+        {
+            Play play;
+            open(play, textures, vertices, level.w, level.h, level.endless, 7);
+            if(level.cleared)
+                clearWindow(play);
+            for(const auto& view : views)
+            {
+                long every_triangles = 0, near_triangles = 0, changed = 0;
+                for(int angle = 0; angle < 360; angle += 45)
+                {
+                    play.angleX = float(angle);
+                    play.angleY = view.angleY;
+                    play.looking_at_floor = false;
+                    Raster::Stats stats = {}, full_stats = {};
+                    target.clear(CLEAR_COLOR_TOP);
+                    full.clear(CLEAR_COLOR_TOP);
+                    Raster::draw(target, play.window, play.vertices, play.floor_mesh, textures.spritesTexture(), textures.floorTextures(),
+                                 play.positionX, play.positionZ, play.camera(), false, 0.0f, stats);
+                    drawUnculled(full, play, textures, full_stats);
+                    for(int pixel = 0; pixel < Raster::WIDTH * Raster::HEIGHT; pixel++)
+                        changed += target.color[pixel] != full.color[pixel];
+                    every_triangles += floorTriangles(play, false);
+                    near_triangles += floorTriangles(play, true);
+                }
+                printf("%-18s %-8s %12ld %12ld %9ld\n", level.name, view.name, every_triangles / 8, near_triangles / 8, changed);
+                bad += changed != 0;
+            }
+        }
+        if(bad)
+        {
+            printf("FAIL: %d views changed where the floor past LOD_DISTANCE was left out\n", bad);
+            failures++;
+        }
+        printf("%s\n", bad ? "failed" : "ok");
+    }
+
+    header("raster: what a frame draws, ms per frame on this machine");
+    if(argument)
+        printf("pictures go to %s\n", argument);
+    printf("%-14s %-8s %9s %9s %9s %9s %8s %10s\n", "level", "view", "triangles", "culled", "pixels", "overdraw", "ms", "picture");
+    {
+        const struct {
+            const char* name;
+            short w, h;
+            bool endless;
+        } levels[] = {
+            {"10x10", 10, 10, false},
+            {"25x25", 25, 25, false},
+            {"99x99", 99, 99, false},
+            {"1000x1000", 1000, 1000, false},
+            {"endless", 0, 0, true},
+        };
+        const struct {
+            const char* name;
+            float angleX, angleY, iod;
+        } views[] = {
+            {"down", 90.0f, -60.0f, 0.0f},
+            {"ahead", 90.0f, -15.0f, 0.0f},
+            {"across", 135.0f, -15.0f, 0.0f},
+            {"left eye", 90.0f, -15.0f, -1.0f / 3.0f},
+        };
+        for(const auto& level : levels)
+        {
+            Play play;
+            open(play, textures, vertices, level.w, level.h, level.endless, 6);
+            for(const auto& view : views)
+            {
+                play.angleX = view.angleX;
+                play.angleY = view.angleY;
+                play.looking_at_floor = false;
+                play.updateCursorLookingAt(play.camera());
+                play.updateCursorUVAndPos();
+                Raster::Stats stats = {};
+                const double us = time_us([&]() {
+                    stats = {};
+                    target.clear(CLEAR_COLOR_TOP);
+                    Raster::draw(target, play.window, play.vertices, play.floor_mesh, textures.spritesTexture(), textures.floorTextures(),
+                                 play.positionX, play.positionZ, play.camera(), play.looking_at_floor, view.iod, stats);
+                }, 20.0);
+                printf("%-14s %-8s %9ld %9ld %9ld %8.2fx %8.2f   %08x\n", level.name, view.name, stats.submitted, stats.culled, stats.pixels,
+                       double(stats.pixels) / (Raster::WIDTH * Raster::HEIGHT), us / 1000.0, fnv1a(target.color));
+
+                if(argument)
+                {
+                    std::string path = std::string(argument) + "/" + level.name + "-" + view.name + ".ppm";
+                    for(char& c : path)
+                        c = c == ' ' ? '_' : c;
+                    if(!Raster::writeImage(path.c_str(), target))
+                    {
+                        printf("FAIL: %s can't be written\n", path.c_str());
+                        failures++;
+                    }
+                }
+            }
+        }
+    }
+
+    return failures;
+}
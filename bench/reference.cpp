@@ -0,0 +1,330 @@
+#include "reference.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+Reference::CharBoard::CharBoard(short w, short h, int bomb_count)
+:
+internal(w * h, '0'), visible(w * h, '.'), around(w * h, 0),
+width(w), height(h), bombs(bomb_count), flags_count(0)
+{
+
+}
+
+Reference::CharBoard::CharBoard(const Board& board)
+:
+CharBoard(board.width, board.height, board.bombs)
+{
+    for(int idx = 0; idx < width * height; idx++)
+    {
+        if(board.isMine(idx))
+            internal[idx] = '.';
+        else if(board.count(idx) == 0)
+            internal[idx] = ' ';
+        else
+            internal[idx] = char('0' + board.count(idx));
+    }
+}
+
+std::vector<char> Reference::visibleOf(const Board& board)
+{
+    std::vector<char> visible(board.width * board.height);
+    for(int idx = 0; idx < board.width * board.height; idx++)
+    {
+        if(!board.isOpen(idx))
+            visible[idx] = board.isFlagged(idx) ? 'f' : '.';
+        else if(board.isMine(idx))
+            visible[idx] = '#';
+        else if(board.count(idx) == 0)
+            visible[idx] = ' ';
+        else
+            visible[idx] = char('0' + board.count(idx));
+    }
+    return visible;
+}
+
+void Reference::countPerBomb(Board& board)
+{
+    const int width = board.width;
+    const int height = board.height;
+    std::fill(board.counts.begin(), board.counts.end(), 0);
+    for(int pos = 0; pos < width * height; pos++)
+    {
+        if(!board.isMine(pos))
+            continue;
+
+        const int x_beg = (pos % width) - 1;
+        const int x_end = x_beg + 2;
+        const int y_beg = (pos / width) - 1;
+        const int y_end = y_beg + 2;
+        for(int x = x_beg; x <= x_end; x++)
+        {
+            if(x < 0 || x >= width)
+                continue;
+
+            for(int y = y_beg; y <= y_end; y++)
+            {
+                if(y < 0 || y >= height)
+                    continue;
+
+                const int idx = x + y * width;
+                board.counts[idx / 2] += 1 << ((idx % 2) * 4);
+            }
+        }
+    }
+}
+
+void Reference::generateBombs(CharBoard& board, Coord safe)
+{
+    const int width = board.width;
+    const int height = board.height;
+    const int size = width * height;
+    auto& internal = board.internal;
+    internal.clear();
+    internal.resize(size, '0');
+
+    for(int i = 0; i < board.bombs; i++)
+    {
+        int pos = rand() % size;
+        while(internal[pos] == '.' || (
+        ((pos % width) >= (safe.x - 1) && (pos % width) <= (safe.x + 1)) &&
+        ((pos / width) >= (safe.y - 1) && (pos / width) <= (safe.y + 1))))
+            pos = rand() % size;
+
+        internal[pos] = '.';
+        const int x_beg = (pos % width) - 1;
+        const int x_end = x_beg + 2;
+        const int y_beg = (pos / width) - 1;
+        const int y_end = y_beg + 2;
+        for(int x = x_beg; x <= x_end; x++)
+        {
+            if(x < 0 || x >= width)
+                continue;
+
+            for(int y = y_beg; y <= y_end; y++)
+            {
+                if(y < 0 || y >= height)
+                    continue;
+
+                const int idx = x + y * width;
+                if(internal[idx] != '.')
+                    internal[idx]++;
+            }
+        }
+    }
+
+    for(auto& s : internal)
+    {
+        if(s == '0')
+            s = ' ';
+    }
+}
+
+void Reference::checkAround(CharBoard& board, Coord point)
+{
+    const int pos = point.x + point.y * board.width;
+    if(board.around[pos] != 0)
+        return;
+
+    const char square = board.internal[pos];
+    if(square == ' ')
+    {
+        if(board.visible[pos] == 'f') board.flags_count--;
+        board.visible[pos] = square;
+        board.around[pos] = 1;
+
+        const bool top = point.y == 0;
+        const bool bot = point.y == board.height - 1;
+        const bool left = point.x == 0;
+        const bool right = point.x == board.width - 1;
+        const auto go = [&](int dx, int dy) {
+            checkAround(board, {short(point.x + dx), short(point.y + dy)});
+        };
+
+        if(!top) go(0, -1);
+        if(!bot) go(0, +1);
+        if(!left) go(-1, 0);
+        if(!right) go(+1, 0);
+
+        if(!top && !left) go(-1, -1);
+        if(!bot && !right) go(+1, +1);
+        if(!top && !right) go(+1, -1);
+        if(!bot && !left) go(-1, +1);
+    }
+    else if(square != '.')
+    {
+        board.visible[pos] = square;
+        board.around[pos] = 1;
+    }
+    else
+        board.around[pos] = 1;
+}
+
+Board::Outcome Reference::reveal(CharBoard& board, Coord point)
+{
+    const int pos = point.x + point.y * board.width;
+    const char square = board.internal[pos];
+    board.visible[pos] = square;
+
+    if(square == ' ')
+    {
+        checkAround(board, point);
+    }
+
+    if(square == '.')
+    {
+        for(int idx = 0; idx < board.width * board.height; idx++)
+        {
+            if(board.internal[idx] == '.')
+                board.visible[idx] = '#';
+        }
+        return Board::Outcome::Lost;
+    }
+
+    return checkWin(board) ? Board::Outcome::Won : Board::Outcome::Playing;
+}
+
+void Reference::placeFlag(CharBoard& board, Coord point)
+{
+    const int pos = point.x + point.y * board.width;
+    if(board.visible[pos] == '.')
+    {
+        board.visible[pos] = 'f';
+        board.flags_count++;
+    }
+    else if(board.visible[pos] == 'f')
+    {
+        board.visible[pos] = '.';
+        board.flags_count--;
+    }
+}
+
+bool Reference::checkWin(const CharBoard& board)
+{
+    for(int y = 0; y < board.height; y++)
+    {
+        const int posY = y * board.width;
+        for(int x = 0; x < board.width; x++)
+        {
+            const int posT = x + posY;
+            if(board.internal[posT] == '.' && (board.visible[posT] == '.' || board.visible[posT] == 'f')) // bomb and it's (not found) or (flagged)
+            {
+                continue;
+            }
+            else if(board.internal[posT] != board.visible[posT]) // not revealed yet
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+namespace {
+    // the 6 vertices of a quad each used the texture coordinates of this corner
+    constexpr int six_vertex_corner[6] = {0, 1, 2, 1, 3, 2};
+
+    Reference::FloatVertex floatVertex(float x, float y, float z, const Mesh::QuadUVs& uvs, int vert, float nx, float ny, float nz)
+    {
+        const int corner = six_vertex_corner[vert];
+        return {{x, y, z}, {uvs.u[corner], uvs.v[corner]}, {nx, ny, nz}};
+    }
+}
+
+int Reference::floatLevelSize(short width, short height)
+{
+    return (1 + 1 + (width * 2 + height * 2) + width * height * 2) * 6;
+}
+
+void Reference::floatWalls(FloatVertex* vertices, short width, short height, const Mesh::QuadUVs& uvs)
+{
+    const float miny = height/-2.0f;
+    const float minx = width/-2.0f;
+    const float maxy = -miny;
+    const float maxx = -minx;
+
+    constexpr float wall_deltadir[6] = {0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f};
+    constexpr float wall_dy[6] = {0.0f, 0.0f, 2.0f, 0.0f, 2.0f, 2.0f};
+
+    size_t idx = 0;
+    for(int i = 0; i < width; i++)
+    {
+        const float x = float(i) + minx;
+        for(size_t vert = 0; vert < 6; vert++)
+        {
+            const FloatVertex hi = floatVertex(x + wall_deltadir[6 - vert - 1], -1.0f + wall_dy[6 - vert - 1], miny + 0.0625f/4.0f, uvs, 6 - vert - 1, 0.0f, 0.0f, +1.0f);
+            const FloatVertex lo = floatVertex(x + wall_deltadir[vert], -1.0f + wall_dy[vert], maxy - 0.0625f/4.0f, uvs, vert, 0.0f, 0.0f, -1.0f);
+            vertices[idx + 0 + ((3 + vert) % 6)] = hi;
+            vertices[idx + 6 + vert] = lo;
+        }
+        idx += 12;
+    }
+
+    for(int i = 0; i < height; i++)
+    {
+        const float y = float(i) + miny;
+        for(size_t vert = 0; vert < 6; vert++)
+        {
+            const FloatVertex hi = floatVertex(minx + 0.0625f/4.0f, -1.0f + wall_dy[vert], y + wall_deltadir[vert], uvs, vert, +1.0f, 0.0f, 0.0f);
+            const FloatVertex lo = floatVertex(maxx - 0.0625f/4.0f, -1.0f + wall_dy[6 - vert - 1], y + wall_deltadir[6 - vert - 1], uvs, 6 - vert - 1, -1.0f, 0.0f, 0.0f);
+            vertices[idx + 0 + ((3 + vert) % 6)] = hi;
+            vertices[idx + 6 + vert] = lo;
+        }
+        idx += 12;
+    }
+}
+
+void Reference::floatFloorTile(FloatVertex* vertices, short width, short height, int layer, int square, const Mesh::QuadUVs& uvs)
+{
+    constexpr float floor_dx[6] = {0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f};
+    constexpr float floor_dz[6] = {0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f};
+    constexpr float floor_dy[2] = {
+        0.0f,
+        0.0625f/8.0f,
+    };
+
+    FloatVertex* floor = &vertices[(width * 2 + height * 2) * 6];
+    const float x = width/-2.0f + float(square % width);
+    const float y = height/-2.0f + float(square / width);
+    FloatVertex* quad = &floor[(layer * width * height + square) * 6];
+    for(size_t vert = 0; vert < 6; vert++)
+    {
+        quad[vert] = floatVertex(x + floor_dx[vert], -1.0f + floor_dy[layer], y + floor_dz[vert], uvs, vert, 0.0f, 1.0f, 0.0f);
+    }
+}
+
+void Reference::floatCursor(FloatVertex* vertices, short width, short height, short x, short y, const Mesh::QuadUVs& uvs)
+{
+    constexpr float cursor_dx[6] = {0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f};
+    constexpr float cursor_dz[6] = {0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f};
+
+    // the game used the height's half for x as well, which only ever showed on boards that aren't square
+    FloatVertex* quad = &vertices[floatLevelSize(width, height) - 2 * 6];
+    const float cx = width/-2.0f + float(x);
+    const float cy = height/-2.0f + float(y);
+    for(size_t vert = 0; vert < 6; vert++)
+    {
+        quad[vert] = floatVertex(cx + cursor_dx[vert], -1.0f + (0.0625f/4.0f), cy + cursor_dz[vert], uvs, vert, 0.0f, 1.0f, 0.0f);
+    }
+}
+
+void Reference::floatCrosshair(FloatVertex* vertices, short width, short height, const Mesh::QuadUVs& uvs)
+{
+    constexpr float crosshair_dx[6] = {0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f};
+    constexpr float crosshair_dy[6] = {0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f};
+
+    FloatVertex* quad = &vertices[floatLevelSize(width, height) - 1 * 6];
+    for(size_t vert = 0; vert < 6; vert++)
+    {
+        quad[6 - vert - 1] = floatVertex((crosshair_dx[vert] - 1.0f + 0.5f) / 16.0f, ((crosshair_dy[vert] - 0.5f) / 16.0f), -0.5f, uvs, vert, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+void Reference::floorTile(Vertex* vertices, const Mesh::Layout& layout, int square, const Mesh::QuadUVs& uvs)
+{
+    const float x = layout.width / -2.0f + float(square % layout.board_width - layout.x0);
+    const float y = layout.height / -2.0f + float(square / layout.board_width - layout.y0);
+    Vertex* quad = &vertices[layout.floorQuad(square) * Mesh::QUAD_VERTICES];
+    for(int corner = 0; corner < Mesh::QUAD_VERTICES; corner++)
+        quad[corner] = Vertex(x + float(corner % 2), Mesh::FLOOR_Y, y + float(corner / 2), uvs.u[corner], uvs.v[corner]);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+// The board and level algorithms as they were before being optimized, kept to compare against
+
+#include "board.h"
+#include "mesh.h"
+
+namespace Reference {
+    // The board as it used to be stored: one character per square.
+    // internal: '.' bomb, ' ' blank, '1'..'8' number; visible: '.' hidden, 'f' flag, '#' shown bomb, or the internal square
+    struct CharBoard {
+        std::vector<char> internal, visible;
+        std::vector<signed char> around;
+        short width, height;
+        int bombs;
+        int flags_count;
+
+        CharBoard(short w, short h, int bomb_count);
+        // same bombs as an already generated board, with every square hidden
+        explicit CharBoard(const Board& board);
+    };
+
+    // what visible would hold for a board, to compare with a CharBoard
+    std::vector<char> visibleOf(const Board& board);
+
+    // bump the 3x3 counts around every bomb of the board's plane, one bomb at a time
+    void countPerBomb(Board& board);
+
+    // rand() and retry on collisions or in the safe zone, with a per-bomb neighbour update
+    void generateBombs(CharBoard& board, Coord safe);
+    // recursive flood fill into all 8 neighbours
+    void checkAround(CharBoard& board, Coord point);
+    // open a square, recursing if blank, then scan the whole board for a win
+    Board::Outcome reveal(CharBoard& board, Coord point);
+    void placeFlag(CharBoard& board, Coord point);
+    // compare every square of internal and visible
+    bool checkWin(const CharBoard& board);
+
+    // The level vertex as it was before being packed
+    struct FloatVertex {
+        float position[3];
+        float texcoord[2];
+        float norm[3];
+    };
+    // The level as it used to be laid out, 6 vertices per quad drawn as plain triangles:
+    // {walls (top and bottom interleaved, then left and right interleaved), floor bottom layer, floor top layer, cursor, crosshair}
+    // uvs.u[c], uvs.v[c] go to the corner at (c % 2, c / 2) of a quad, as in Mesh
+    int floatLevelSize(short width, short height);
+    void floatWalls(FloatVertex* vertices, short width, short height, const Mesh::QuadUVs& uvs);
+    void floatFloorTile(FloatVertex* vertices, short width, short height, int layer, int square, const Mesh::QuadUVs& uvs);
+    void floatCursor(FloatVertex* vertices, short width, short height, short x, short y, const Mesh::QuadUVs& uvs);
+    void floatCrosshair(FloatVertex* vertices, short width, short height, const Mesh::QuadUVs& uvs);
+
+    // Mesh::floorTile as it was before templates: every corner made again from floats, with its UVs
+    void floorTile(Vertex* vertices, const Mesh::Layout& layout, int square, const Mesh::QuadUVs& uvs);
+};
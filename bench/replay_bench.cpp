@@ -0,0 +1,259 @@
+#include "bench.h"
+
+#include "play.h"
+#include "replay.h"
+#include "rng.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+    // Someone playing with the default controls, looking around with the D-Pad and walking with ABXY, who knows where the bombs are:
+    // walks and turns a while, then flags or reveals what's in front of them, and steps on a bomb now and then
+    struct Bot {
+        Rng rng;
+        uint32_t walking = 0, turning = 0;
+        int left = 0; // frames before picking something else to do
+
+        explicit Bot(uint64_t seed) : rng(seed) { }
+
+        Play::Frame next(const Play& play, uint32_t held_before)
+        {
+            uint32_t held = 0;
+            if(play.dead || play.win)
+            {
+                // long enough for the end to go away, then back to the menu
+                if(play.frames - play.end_frame > Play::END_FRAMES + 10)
+                    held = Keys::L;
+            }
+            else if(play.angleY > -25.0f)
+                held = Keys::DDOWN;
+            else
+            {
+                if(left-- <= 0)
+                {
+                    const uint32_t walks[] = {0, Keys::X, Keys::X, Keys::X, Keys::A, Keys::Y, Keys::B};
+                    const uint32_t turns[] = {0, 0, Keys::DLEFT, Keys::DRIGHT};
+                    walking = walks[rng.below(7)];
+                    turning = turns[rng.below(4)];
+                    left = 10 + int(rng.below(50));
+                }
+                // standing still, moving loses sight of the floor for the frame
+                if(play.looking_at_floor && play.preparing == Play::Preparing::Nothing && rng.below(8) == 0 && !(held_before & (Keys::L | Keys::R)))
+                    held = click(play);
+                else
+                    held = walking | turning;
+            }
+            return {held & ~held_before, held, 0, 0, play.worker.done()};
+        }
+
+        uint32_t click(const Play& play)
+        {
+            if(!play.generated)
+                return Keys::R;
+            bool open, mine, flagged;
+            if(play.endless)
+            {
+                const Endless::Square at = play.endlessSquare(play.looking_at_x, play.looking_at_y);
+                const Endless::Chunk* chunk = play.endless_board.chunkAt(at.x, at.y);
+                if(!chunk)
+                    return 0;
+                open = Endless::getBit(chunk->open_bits, at.x, at.y);
+                mine = Endless::getBit(chunk->mine_bits, at.x, at.y);
+                flagged = Endless::getBit(chunk->flag_bits, at.x, at.y);
+            }
+            else
+            {
+                const int square = play.looking_at_x + play.looking_at_y * play.width;
+                open = play.board.isOpen(square);
+                mine = play.board.isMine(square);
+                flagged = play.board.isFlagged(square);
+            }
+            if(open)
+                return 0;
+            // one mistake in 200
+            if(mine && rng.below(200) != 0)
+                return flagged ? 0 : Keys::L;
+            return flagged ? Keys::L : Keys::R;
+        }
+    };
+
+    // Plays a level with a bot until it's left or frames went by, recording it the way MineSweeper does
+    Replay::Trace record(short w, short h, int percent, bool endless, bool no_guess, uint64_t seed, int frames)
+    {
+        Play play;
+        Bench::setUpLevel(play, w, h, percent, endless, no_guess, seed);
+        std::vector<Vertex> vertices;
+        Bench::startLevel(play, vertices);
+
+        Replay::Trace trace;
+        Replay::begin(trace, play);
+        Bot bot(seed);
+        uint32_t held = 0;
+        for(int frame = 0; frame < frames && play.playing; frame++)
+        {
+            // a frame on the 3DS is long enough for the first reveal, here the job may not even have begun
+            if(play.preparing != Play::Preparing::Nothing)
+                play.worker.wait();
+            const Play::Frame input = bot.next(play, held);
+            held = input.held;
+            play.update(input);
+            Replay::record(trace, input, play);
+        }
+        play.worker.wait();
+        return trace;
+    }
+
+    struct Replayed {
+        bool started;
+        int diverged; // the first frame whose hash isn't the recorded one, -1 for none
+        std::vector<double> frame_us;
+    };
+
+    // The headless runner: trace played again as fast as it goes, timing every frame
+    Replayed replay(const Replay::Trace& trace)
+    {
+        Replayed result = {false, -1, {}};
+        Play play;
+        if(!Replay::restore(trace, play))
+            return result;
+        result.started = true;
+        std::vector<Vertex> vertices;
+        Bench::startLevel(play, vertices);
+
+        result.frame_us.reserve(trace.frames());
+        int frame = 0;
+        for(const Replay::Run& run : trace.runs)
+        {
+            for(uint32_t i = 0; i < run.count; i++, frame++)
+            {
+                const auto begin = Bench::Clock::now();
+                play.update(run.frame);
+                result.frame_us.push_back(std::chrono::duration<double, std::micro>(Bench::Clock::now() - begin).count());
+                if(result.diverged < 0 && play.hash() != trace.hashes[frame])
+                    result.diverged = frame;
+            }
+        }
+        play.worker.wait();
+        return result;
+    }
+
+    void report(const char* name, const Replay::Trace& trace, const Replayed& replayed)
+    {
+        std::vector<double> sorted = replayed.frame_us;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for(const double us : sorted)
+            total += us;
+        const size_t count = sorted.size();
+        std::vector<uint8_t> data;
+        Replay::write(trace, data);
+        printf("%-24s %7zu %8zu %9.1f %9.1f %9.1f %10.1f\n", name, count, data.size(), count ? total / count : 0.0,
+               count ? sorted[count / 2] : 0.0, count ? sorted[count * 99 / 100] : 0.0, count ? sorted.back() : 0.0);
+    }
+}
+
+int Bench::replay_suite()
+{
+    int failures = 0;
+
+    if(argument)
+    {
+        // a trace from the SD card (see MineSweeper::TRACE_PATH)
+        header("replay: a trace, us per frame");
+        Replay::Trace trace;
+        if(!Replay::readFile(argument, trace))
+        {
+            printf("FAIL: %s isn't a trace\n", argument);
+            return 1;
+        }
+        const Replayed replayed = replay(trace);
+        if(!replayed.started || replayed.diverged >= 0)
+        {
+            printf("FAIL: %s doesn't play out the same, from frame %d\n", argument, replayed.diverged);
+            failures++;
+        }
+        printf("%-24s %7s %8s %9s %9s %9s %10s\n", "trace", "frames", "bytes", "mean", "median", "99%", "longest");
+        report(argument, trace, replayed);
+        return failures;
+    }
+
+    struct {
+        const char* name;
+        short w, h;
+        int percent;
+        bool endless, no_guess;
+        int frames;
+    } levels[] = {
+        {"25x25 20%", 25, 25, 20, false, false, 3000},
+        {"99x99 20%", 99, 99, 20, false, false, 6000},
+        {"99x99 20%, no guessing", 99, 99, 20, false, true, 6000},
+        {"1000x1000 20%", 1000, 1000, 20, false, false, 6000},
+        {"endless 20%", 0, 0, 20, true, false, 6000},
+    };
+    std::vector<Replay::Trace> traces;
+    for(const auto& level : levels)
+        traces.push_back(record(level.w, level.h, level.percent, level.endless, level.no_guess, 1 + traces.size(), level.frames));
+
+    header("replay: traces play out the same, through a file and back");
+    {
+        char directory[] = "/tmp/ms3d_traceXXXXXX";
+        if(!mkdtemp(directory))
+        {
+            printf("FAIL: no temporary directory for the traces\n");
+            return failures + 1;
+        }
+        const std::string path = std::string(directory) + "/last.trace";
+        for(size_t i = 0; i < traces.size(); i++)
+        {
+            Replay::Trace read;
+            if(!Replay::writeFile(path.c_str(), traces[i]) || !Replay::readFile(path.c_str(), read) || read.frames() != traces[i].frames())
+            {
+                printf("FAIL: %s: the trace can't be written and read back\n", levels[i].name);
+                failures++;
+                continue;
+            }
+            const Replayed replayed = replay(read);
+            if(!replayed.started || replayed.diverged >= 0)
+            {
+                printf("FAIL: %s: the replay isn't the game recorded, from frame %d of %d\n", levels[i].name, replayed.diverged, read.frames());
+                failures++;
+            }
+        }
+        unlink(path.c_str());
+        rmdir(directory);
+
+        // the same frames from somewhere else go elsewhere
+        Replay::Trace moved = traces[1];
+        moved.seed++;
+        const Replayed replayed = replay(moved);
+        if(replayed.diverged < 0)
+        {
+            printf("FAIL: a trace played on another board went through the same hashes\n");
+            failures++;
+        }
+
+        std::vector<uint8_t> data;
+        Replay::write(traces[0], data);
+        Replay::Trace read;
+        for(size_t size = 0; size < data.size(); size += 1 + size / 16)
+        {
+            if(Replay::read(data.data(), size, read))
+            {
+                printf("FAIL: a trace cut to %zu bytes of %zu was read\n", size, data.size());
+                failures++;
+                break;
+            }
+        }
+    }
+    printf("%s\n", failures ? "failed" : "ok");
+
+    header("replay: frames played headless, us per frame");
+    printf("%-24s %7s %8s %9s %9s %9s %10s\n", "level", "frames", "bytes", "mean", "median", "99%", "longest");
+    for(size_t i = 0; i < traces.size(); i++)
+        report(levels[i].name, traces[i], replay(traces[i]));
+
+    return failures;
+}
@@ -0,0 +1,395 @@
+#include "bench.h"
+
+#include "board.h"
+#include "endless.h"
+#include "play.h"
+#include "rng.h"
+#include "save.h"
+#include "solver.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+    constexpr int C = Endless::CHUNK_SIZE;
+    // what MineSweeper gives Endless::reset
+    constexpr int ENDLESS_WINDOW = 208;
+
+    // A board played on the way MineSweeper does it, with open_percent of its safe squares opened by clicks
+    // and flag_percent of its bombs flagged
+    Save::Game play(Board& board, short w, short h, int percent, bool no_guess, int open_percent, int flag_percent, uint64_t seed)
+    {
+        Save::Game game = {};
+        game.what = Save::Game::GENERATED | (no_guess ? Save::Game::NO_GUESS : 0);
+        game.bomb_percent = uint8_t(percent);
+        game.width = w;
+        game.height = h;
+        game.seed = seed;
+        game.first = {short(w / 2), short(h / 2)};
+        game.angle_x = 12.5f;
+        game.angle_y = -30.0f;
+        game.position_x = 1.25f;
+        game.position_z = -3.5f;
+
+        board.reset(w, h, percent * w * h / 100);
+        if(no_guess)
+            NoGuess::generate(board, game.first, seed);
+        else
+            board.generateBombs(game.first, seed);
+        board.reveal(game.first);
+
+        Rng rng(seed);
+        const int size = w * h;
+        const int safe = size - board.bombs;
+        for(int tries = 0; tries < size * 4 && (safe - board.hidden_safe) * 100 < safe * open_percent; tries++)
+        {
+            const int square = int(rng.below(size));
+            if(!board.isMine(square) && !board.isOpen(square))
+                board.reveal({short(square % w), short(square / w)});
+        }
+        for(int square = 0; square < size; square++)
+        {
+            if(board.isMine(square) && int(rng.below(100)) < flag_percent)
+                board.placeFlag({short(square % w), short(square / w)});
+        }
+        return game;
+    }
+
+    bool same(const Save::Game& a, const Save::Game& b)
+    {
+        return a.what == b.what && a.bomb_percent == b.bomb_percent && a.width == b.width && a.height == b.height && a.seed == b.seed &&
+               a.first.x == b.first.x && a.first.y == b.first.y && a.origin_x == b.origin_x && a.origin_y == b.origin_y &&
+               a.angle_x == b.angle_x && a.angle_y == b.angle_y && a.position_x == b.position_x && a.position_z == b.position_z;
+    }
+
+    int check_board(const Save::Game& game, const Board& board, const char* what)
+    {
+        std::vector<uint8_t> data;
+        Save::write(game, board, Endless(), data);
+        Save::Game read_game;
+        Board read;
+        Endless unused;
+        if(!Save::read(data.data(), data.size(), read_game, read, unused, ENDLESS_WINDOW))
+        {
+            printf("FAIL: %dx%d %s: the save can't be read back\n", board.width, board.height, what);
+            return 1;
+        }
+        if(!same(game, read_game) || read.mine_bits != board.mine_bits || read.open_bits != board.open_bits || read.flag_bits != board.flag_bits ||
+           read.counts != board.counts || read.flags_count != board.flags_count || read.hidden_safe != board.hidden_safe || read.bombs != board.bombs)
+        {
+            printf("FAIL: %dx%d %s: the board read back isn't the one saved\n", board.width, board.height, what);
+            return 1;
+        }
+        return 0;
+    }
+
+    // An endless board walked on, so that some of what was played is out of memory
+    Save::Game walk(Endless& board, uint64_t seed)
+    {
+        Save::Game game = {};
+        game.what = Save::Game::ENDLESS | Save::Game::GENERATED;
+        game.bomb_percent = 15;
+        game.width = game.height = 4096;
+        game.seed = seed;
+        game.origin_x = -2048;
+        game.origin_y = 100 - 2048;
+
+        board.reset(game.bomb_percent, seed, ENDLESS_WINDOW);
+        Rng rng(seed);
+        int x = 0, y = 0;
+        for(int step = 0; step < 40; step++)
+        {
+            x += int(rng.below(81)) - 30;
+            y += int(rng.below(81)) - 30;
+            board.materialize(x - ENDLESS_WINDOW / 2, y - ENDLESS_WINDOW / 2, x + ENDLESS_WINDOW / 2, y + ENDLESS_WINDOW / 2);
+            for(int click = 0; click < 6; click++)
+            {
+                const Endless::Square point = {x - 40 + int(rng.below(81)), y - 40 + int(rng.below(81))};
+                if(board.isOpen(point.x, point.y))
+                    continue;
+                if(board.isMine(point.x, point.y))
+                    board.placeFlag(point);
+                else
+                    board.reveal(point);
+            }
+        }
+        return game;
+    }
+
+    int check_endless(uint64_t seed)
+    {
+        Endless board;
+        const Save::Game game = walk(board, seed);
+        std::vector<uint8_t> data;
+        Save::write(game, Board(), board, data);
+
+        Save::Game read_game;
+        Board unused;
+        Endless read;
+        if(!Save::read(data.data(), data.size(), read_game, unused, read, ENDLESS_WINDOW) || !same(game, read_game) ||
+           read.opened != board.opened || read.flags_count != board.flags_count)
+        {
+            printf("FAIL: endless seed %016llx: the save can't be read back, or its counters changed\n", (unsigned long long)seed);
+            return 1;
+        }
+
+        // the same window in memory on both, then every chunk played on is the same
+        read.materialize(board.grid_x * C, board.grid_y * C, (board.grid_x + board.grid_w) * C, (board.grid_y + board.grid_h) * C);
+        for(const int chunk : board.grid)
+        {
+            const Endless::Chunk& was = board.pool[chunk];
+            const Endless::Chunk* is = read.chunkAt(was.cx * C, was.cy * C);
+            if(!is || memcmp(was.open_bits, is->open_bits, sizeof(was.open_bits)) || memcmp(was.flag_bits, is->flag_bits, sizeof(was.flag_bits)))
+            {
+                printf("FAIL: endless seed %016llx: chunk (%d, %d) in memory isn't the one saved\n", (unsigned long long)seed, was.cx, was.cy);
+                return 1;
+            }
+        }
+        if(read.played.size() != board.played.size())
+        {
+            printf("FAIL: endless seed %016llx: %zu chunks out of memory instead of %zu\n", (unsigned long long)seed, read.played.size(), board.played.size());
+            return 1;
+        }
+        for(const auto& kept : board.played)
+        {
+            const auto found = read.played.find(kept.first);
+            if(found == read.played.end() || memcmp(&found->second, &kept.second, sizeof(kept.second)))
+            {
+                printf("FAIL: endless seed %016llx: a chunk out of memory isn't the one saved\n", (unsigned long long)seed);
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    // Anything short of the whole save, or with a byte changed where it can't be, isn't read
+    int check_refused(const Save::Game& game, const Board& board)
+    {
+        std::vector<uint8_t> data;
+        Save::write(game, board, Endless(), data);
+        Save::Game read_game;
+        Board read;
+        Endless unused;
+        for(size_t size = 0; size < data.size(); size++)
+        {
+            if(Save::read(data.data(), size, read_game, read, unused, ENDLESS_WINDOW))
+            {
+                printf("FAIL: a save cut to %zu bytes of %zu was read\n", size, data.size());
+                return 1;
+            }
+        }
+
+        struct {
+            const char* what;
+            size_t at;
+            uint8_t value;
+        } damages[] = {
+            {"magic", 0, 'X'},
+            {"version", 4, uint8_t(Save::VERSION + 1)},
+            {"percent", 6, 101},
+            {"plane encoding", 47, 7},
+        };
+        for(const auto& damage : damages)
+        {
+            std::vector<uint8_t> damaged = data;
+            damaged[damage.at] = damage.value;
+            if(Save::read(damaged.data(), damaged.size(), read_game, read, unused, ENDLESS_WINDOW))
+            {
+                printf("FAIL: a save with a wrong %s was read\n", damage.what);
+                return 1;
+            }
+        }
+        std::vector<uint8_t> longer = data;
+        longer.push_back(0);
+        if(Save::read(longer.data(), longer.size(), read_game, read, unused, ENDLESS_WINDOW))
+        {
+            printf("FAIL: a save with a byte too many was read\n");
+            return 1;
+        }
+
+        // a bomb opened: that game was over
+        Board lost = board;
+        for(int square = 0; square < lost.width * lost.height; square++)
+        {
+            if(lost.isMine(square))
+            {
+                Board::setBit(lost.open_bits, square);
+                break;
+            }
+        }
+        data.clear();
+        Save::write(game, lost, Endless(), data);
+        if(Save::read(data.data(), data.size(), read_game, read, unused, ENDLESS_WINDOW))
+        {
+            printf("FAIL: a save with a bomb opened was read\n");
+            return 1;
+        }
+        return 0;
+    }
+
+    int check_file(const Save::Game& game, const Board& board)
+    {
+        char directory[] = "/tmp/ms3d_saveXXXXXX";
+        if(!mkdtemp(directory))
+        {
+            printf("FAIL: no temporary directory to save in\n");
+            return 1;
+        }
+        const std::string path = std::string(directory) + "/save.bin";
+        int failures = 0;
+        Save::Game read_game;
+        Board read;
+        Endless unused;
+        if(Save::readFile(path.c_str(), read_game, read, unused, ENDLESS_WINDOW))
+        {
+            printf("FAIL: a save that doesn't exist was read\n");
+            failures++;
+        }
+        // twice, the second one over the first
+        if(!Save::writeFile(path.c_str(), game, Board(), Endless()) || !Save::writeFile(path.c_str(), game, board, Endless()) ||
+           !Save::readFile(path.c_str(), read_game, read, unused, ENDLESS_WINDOW) || read.open_bits != board.open_bits || read.flag_bits != board.flag_bits)
+        {
+            printf("FAIL: %s can't be written and read back\n", path.c_str());
+            failures++;
+        }
+        if(access((path + ".new").c_str(), F_OK) == 0)
+        {
+            printf("FAIL: the save was left next to %s\n", path.c_str());
+            failures++;
+        }
+        unlink(path.c_str());
+        rmdir(directory);
+        return failures;
+    }
+}
+
+int Bench::save_suite()
+{
+    int failures = 0;
+
+    header("save: games read back the same");
+    uint64_t seed = 1;
+    for(const short sz : sizes)
+    {
+        for(const int percent : densities)
+        {
+            Board board;
+            failures += check_board(play(board, sz, sz, percent, false, 50, 50, seed), board, "half played");
+            failures += check_board(play(board, sz, sz, percent, true, 100, 100, seed), board, "no guessing, all played");
+            seed++;
+        }
+    }
+    {
+        // before the first reveal there's nothing but the size
+        Board board;
+        board.reset(30, 20, 60);
+        Save::Game game = {};
+        game.bomb_percent = 10;
+        game.width = 30;
+        game.height = 20;
+        failures += check_board(game, board, "not generated");
+
+        Board played;
+        failures += check_board(play(played, 1000, 1000, 20, false, 30, 10, seed++), played, "huge");
+    }
+    for(int walk = 0; walk < 8; walk++)
+        failures += check_endless(seed++);
+    printf("%s\n", failures ? "failed" : "ok");
+
+    header("save: refused when cut short or damaged, files in a temporary directory");
+    int refused_failures = 0;
+    {
+        Board board;
+        const Save::Game game = play(board, 99, 99, 20, false, 50, 50, seed++);
+        refused_failures += check_refused(game, board);
+        refused_failures += check_file(game, board);
+    }
+    printf("%s\n", refused_failures ? "failed" : "ok");
+    failures += refused_failures;
+
+    header("save: a level saved between its first reveal's job and the frame picking it up is the one saved after");
+    int waited_failures = 0;
+    {
+        // MineSweeper::save only waits for the job, for the trace to see it picked up on a frame of its own.
+        // Dense no-guess boards, some of which the generator gives up on
+        Play play;
+        std::vector<Vertex> vertices;
+        for(int level = 0; level < 40; level++)
+        {
+            const bool no_guess = level % 2;
+            Bench::setUpLevel(play, 10, 10, no_guess ? 40 : 20, false, no_guess, seed++);
+            Bench::startLevel(play, vertices);
+            Bench::firstReveal(play);
+            std::vector<uint8_t> waited, picked_up;
+            Save::write(play.saved(), play.board, play.endless_board, waited);
+            play.update({0, 0, 0, 0, true});
+            Save::write(play.saved(), play.board, play.endless_board, picked_up);
+            if(play.preparing != Play::Preparing::Nothing || waited != picked_up)
+            {
+                printf("FAIL: level %d saves differently once its job is picked up\n", level);
+                waited_failures++;
+            }
+        }
+    }
+    printf("%s\n", waited_failures ? "failed" : "ok");
+    failures += waited_failures;
+
+    header("save: bytes and time (us) per save");
+    printf("%-30s %8s %10s %10s\n", "game", "bytes", "write", "read");
+    struct {
+        const char* name;
+        short w, h;
+        int percent, open_percent;
+        bool no_guess;
+    } games[] = {
+        {"99x99 20%, first reveal", 99, 99, 20, 0, false},
+        {"99x99 20%, half open", 99, 99, 20, 50, false},
+        {"99x99 20%, all open", 99, 99, 20, 100, false},
+        {"99x99 40%, half open", 99, 99, 40, 50, false},
+        {"99x99 20%, no guessing, half", 99, 99, 20, 50, true},
+        {"1000x1000 20%, half open", 1000, 1000, 20, 50, false},
+    };
+    for(const auto& game_size : games)
+    {
+        Board board;
+        const Save::Game game = play(board, game_size.w, game_size.h, game_size.percent, game_size.no_guess, game_size.open_percent, 50, seed++);
+        std::vector<uint8_t> data;
+        const double write = time_us([&]() {
+            data.clear();
+            Save::write(game, board, Endless(), data);
+        });
+        Save::Game read_game;
+        Board read;
+        Endless unused;
+        const double read_us = time_us([&]() {
+            Save::read(data.data(), data.size(), read_game, read, unused, ENDLESS_WINDOW);
+        });
+        printf("%-30s %8zu %10.1f %10.1f\n", game_size.name, data.size(), write, read_us);
+        if(game_size.w == 99 && data.size() >= 4096)
+        {
+            printf("FAIL: %s takes %zu bytes, more than 4 KiB\n", game_size.name, data.size());
+            failures++;
+        }
+    }
+    {
+        Endless board;
+        const Save::Game game = walk(board, seed++);
+        std::vector<uint8_t> data;
+        const double write = time_us([&]() {
+            data.clear();
+            Save::write(game, Board(), board, data);
+        });
+        Save::Game read_game;
+        Board unused;
+        Endless read;
+        const double read_us = time_us([&]() {
+            Save::read(data.data(), data.size(), read_game, unused, read, ENDLESS_WINDOW);
+        });
+        printf("%-30s %8zu %10.1f %10.1f\n", "endless, 40 steps", data.size(), write, read_us);
+    }
+
+    return failures;
+}
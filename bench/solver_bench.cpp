@@ -0,0 +1,239 @@
+#include "bench.h"
+
+#include "board.h"
+#include "neighbours.h"
+#include "play.h"
+#include "rng.h"
+#include "solver.h"
+
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    Coord center(const Board& board)
+    {
+        return {short(board.width / 2), short(board.height / 2)};
+    }
+
+    // Nothing the solver found is wrong: what it opened has no bomb, what it marked has one
+    int check_sound(const Board& board, const Solver& solver, uint64_t seed)
+    {
+        for(int square = 0; square < board.width * board.height; square++)
+        {
+            if((solver.state[square] == Solver::Open && board.isMine(square)) || (solver.state[square] == Solver::Mine && !board.isMine(square)))
+            {
+                printf("FAIL: %dx%d seed %016llx: the solver got square %d wrong\n", board.width, board.height, (unsigned long long)seed, square);
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    // A no-guess board is still a board: right bomb count, nothing around the first click, right counts,
+    // the same for the same seed, and solved from scratch
+    int check_no_guess(short w, short h, int bombs, Coord safe, uint64_t seed)
+    {
+        Board board, again;
+        board.reset(w, h, bombs);
+        again.reset(w, h, bombs);
+        const bool solved = NoGuess::generate(board, safe, seed);
+        NoGuess::generate(again, safe, seed);
+        if(board.mine_bits != again.mine_bits)
+        {
+            printf("FAIL: %dx%d seed %016llx is not deterministic\n", w, h, (unsigned long long)seed);
+            return 1;
+        }
+
+        int count = 0;
+        for(int y = 0; y < h; y++)
+        {
+            for(int x = 0; x < w; x++)
+            {
+                if(board.isMine(x + y * w))
+                {
+                    count++;
+                    if(abs(x - safe.x) <= 1 && abs(y - safe.y) <= 1)
+                    {
+                        printf("FAIL: %dx%d seed %016llx has a bomb at (%d, %d), next to the first click\n", w, h, (unsigned long long)seed, x, y);
+                        return 1;
+                    }
+                }
+            }
+        }
+        std::vector<uint8_t> counts(board.counts.size()), scratch;
+        Neighbours::count(board.mine_bits.data(), w, h, counts.data(), scratch);
+        if(count != bombs || counts != board.counts)
+        {
+            printf("FAIL: %dx%d seed %016llx has %d bombs instead of %d, or counts that don't match them\n", w, h, (unsigned long long)seed, count, bombs);
+            return 1;
+        }
+
+        Solver solver;
+        if(solved != solver.solve(board, safe))
+        {
+            printf("FAIL: %dx%d seed %016llx: the generator says %s, the solver from scratch says otherwise\n", w, h, (unsigned long long)seed, solved ? "solved" : "not solved");
+            return 1;
+        }
+        return check_sound(board, solver, seed);
+    }
+}
+
+int Bench::solver_suite()
+{
+    int failures = 0;
+
+    header("solver: never wrong on random boards");
+    uint64_t seed = 0;
+    for(const short sz : sizes)
+    {
+        for(const int percent : densities)
+        {
+            for(int game = 0; game < 20; game++)
+            {
+                Board board;
+                board.reset(sz, sz, percent * sz * sz / 100);
+                board.generateBombs(center(board), seed);
+                Solver solver;
+                solver.solve(board, center(board));
+                failures += check_sound(board, solver, seed++);
+            }
+        }
+    }
+    printf("%s\n", failures ? "failed" : "ok");
+
+    header("solver: no-guess boards are boards, solved from scratch");
+    int generation_failures = 0;
+    for(const short sz : sizes)
+    {
+        for(const int percent : densities)
+        {
+            const Coord safes[] = {{0, 0}, {short(sz - 1), short(sz / 2)}, {short(sz / 2), short(sz / 3)}};
+            for(const Coord safe : safes)
+                generation_failures += check_no_guess(sz, sz, percent * sz * sz / 100, safe, seed++);
+        }
+    }
+    printf("%s\n", generation_failures ? "failed" : "ok");
+    failures += generation_failures;
+
+    header("solver: a board the generator gives up on is played as a plain one, and says so");
+    {
+        constexpr short sz = 10;
+        constexpr int percent = 40;
+        int bad = 0;
+        // where the first reveal lands doesn't depend on the seed
+        Play play;
+        std::vector<Vertex> vertices;
+        Bench::setUpLevel(play, sz, sz, percent, false, true, 0);
+        Bench::startLevel(play, vertices);
+        Bench::firstReveal(play);
+        const Coord first = play.first_reveal;
+
+        // the first level seeds whose boards the generator gives up on, and takes
+        uint64_t given_up = 0, taken = 0;
+        bool found_given_up = false, found_taken = false;
+        for(uint64_t level_seed = 1; level_seed < 10000 && !(found_given_up && found_taken); level_seed++)
+        {
+            // drawn from the level's seed the way Play::generateBombs does
+            uint64_t state = level_seed;
+            Board board;
+            board.reset(sz, sz, percent * sz * sz / 100);
+            if(NoGuess::generate(board, first, Rng::splitmix64(state)))
+            {
+                if(!found_taken)
+                    taken = level_seed;
+                found_taken = true;
+            }
+            else
+            {
+                if(!found_given_up)
+                    given_up = level_seed;
+                found_given_up = true;
+            }
+        }
+        if(!found_given_up || !found_taken)
+        {
+            printf("FAIL: no %dx%d board at %d%% the generator gives up on, or none it takes\n", sz, sz, percent);
+            bad++;
+        }
+
+        for(const uint64_t level_seed : {given_up, taken})
+        {
+            const bool guaranteed = level_seed == taken;
+            Bench::setUpLevel(play, sz, sz, percent, false, true, level_seed);
+            Bench::startLevel(play, vertices);
+            Bench::firstReveal(play);
+            play.update({0, 0, 0, 0, true});
+            const Coord at = play.first_reveal;
+            uint64_t state = level_seed;
+            Board plain;
+            plain.reset(sz, sz, percent * sz * sz / 100);
+            plain.generateBombs(first, Rng::splitmix64(state));
+            const Save::Game game = play.saved();
+            // no_guess only stays on with the board it promises, and the save gives the same board back
+            if(at.x != first.x || at.y != first.y || !play.generated || play.no_guess != guaranteed || (!guaranteed && play.board.mine_bits != plain.mine_bits) ||
+               bool(game.what & Save::Game::NO_GUESS) != guaranteed)
+            {
+                printf("FAIL: seed %llu the generator %s: no_guess %d, %s board\n", (unsigned long long)level_seed,
+                       guaranteed ? "takes" : "gives up on", play.no_guess, play.board.mine_bits == plain.mine_bits ? "the plain" : "another");
+                bad++;
+            }
+        }
+        printf("%s\n", bad ? "failed" : "ok");
+        failures += bad;
+    }
+
+    header("solver: plain boards solved without guessing");
+    printf("%7s", "size");
+    for(const int percent : densities)
+        printf(" %9d%%", percent);
+    printf("\n");
+    for(const short sz : sizes)
+    {
+        printf("%3dx%-3d", sz, sz);
+        for(const int percent : densities)
+        {
+            int solved = 0;
+            constexpr int games = 200;
+            for(int game = 0; game < games; game++)
+            {
+                Board board;
+                board.reset(sz, sz, percent * sz * sz / 100);
+                board.generateBombs(center(board), seed++);
+                Solver solver;
+                solved += solver.solve(board, center(board));
+            }
+            printf(" %9.1f%%", 100.0 * solved / games);
+        }
+        printf("\n");
+    }
+
+    header("solver: no-guess generation");
+    printf("%7s %5s %12s %12s %10s %10s %10s %8s\n", "size", "bombs", "boards/s", "us/board", "attempts", "repairs", "solves", "gave up");
+    for(const short sz : sizes)
+    {
+        for(const int percent : densities)
+        {
+            const int bombs = percent * sz * sz / 100;
+            Board board;
+            int accepted = 0, gave_up = 0;
+            long attempts = 0, repairs = 0, solves = 0;
+            const double us = time_us([&]() {
+                board.reset(sz, sz, bombs);
+            }, [&]() {
+                NoGuess::Stats stats;
+                if(NoGuess::generate(board, center(board), seed++, &stats))
+                    accepted++;
+                else
+                    gave_up++;
+                attempts += stats.boards;
+                repairs += stats.repairs;
+                solves += stats.solves;
+            }, 200.0);
+            const int runs = accepted + gave_up;
+            printf("%3dx%-3d %5d %12.1f %12.1f %10.2f %10.1f %10.2f %8d\n", sz, sz, bombs, 1e6 / us, us,
+                double(attempts) / runs, double(repairs) / runs, double(solves) / runs, gave_up);
+        }
+    }
+
+    return failures;
+}
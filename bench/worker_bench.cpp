@@ -0,0 +1,128 @@
+#include "bench.h"
+
+#include "board.h"
+#include "solver.h"
+#include "worker.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace {
+    using Job = std::function<void()>;
+
+    // A main loop that does a frame's worth of work, and looks at the worker once per frame until the job is done.
+    // Returns the longest frame, in milliseconds
+    double longest_frame(Worker& worker, const Job& job, bool on_worker)
+    {
+        constexpr double FRAME_WORK_MS = 1.0;
+        double longest = 0.0;
+        auto frame_start = Bench::Clock::now();
+        if(on_worker)
+            worker.start(job);
+        else
+            job();
+        for(;;)
+        {
+            // the frame itself
+            while(std::chrono::duration<double, std::milli>(Bench::Clock::now() - frame_start).count() < FRAME_WORK_MS) { }
+
+            const auto now = Bench::Clock::now();
+            longest = std::max(longest, std::chrono::duration<double, std::milli>(now - frame_start).count());
+            frame_start = now;
+            if(worker.done())
+                break;
+        }
+        worker.wait();
+        return longest;
+    }
+}
+
+int Bench::worker_suite()
+{
+    int failures = 0;
+
+    header("worker: jobs run once each, in order, and what they wrote is there once done");
+    {
+        Worker worker;
+        if(!worker.done())
+        {
+            printf("FAIL: a worker without a job isn't done\n");
+            failures++;
+        }
+
+        std::vector<int> results;
+        for(int job = 0; job < 100; job++)
+        {
+            // each job needs what the one before it wrote
+            worker.start([&results, job]() {
+                const int before = results.empty() ? -1 : results.back();
+                results.push_back(before + 1 == job ? job : -1);
+            });
+        }
+        worker.wait();
+        if(!worker.done() || results.size() != 100 || std::count(results.begin(), results.end(), -1) != 0)
+        {
+            printf("FAIL: 100 jobs gave %zu results, or ran out of order\n", results.size());
+            failures++;
+        }
+
+        // polled the way the main loop does
+        Board board;
+        board.reset(99, 99, 1960);
+        worker.start([&board]() {
+            board.generateBombs({49, 49}, 1);
+            board.reveal({49, 49});
+        });
+        while(!worker.done()) { }
+        Board again;
+        again.reset(99, 99, 1960);
+        again.generateBombs({49, 49}, 1);
+        again.reveal({49, 49});
+        if(board.mine_bits != again.mine_bits || board.open_bits != again.open_bits)
+        {
+            printf("FAIL: the board made on the worker isn't the one made right away\n");
+            failures++;
+        }
+        worker.wait();
+    }
+    printf("%s\n", failures ? "failed" : "ok");
+
+    header("worker: level start, longest frame of a main loop doing 1 ms per frame (ms)");
+    printf("%-34s %10s %10s\n", "job", "inline", "worker");
+    struct {
+        const char* name;
+        short w, h;
+        int percent;
+        bool no_guess;
+    } levels[] = {
+        {"99x99 20%, no guessing", 99, 99, 20, true},
+        {"99x99 30%, no guessing", 99, 99, 30, true},
+        {"1000x1000 20%, first reveal", 1000, 1000, 20, false},
+    };
+    for(const auto& level : levels)
+    {
+        Worker worker;
+        Board board;
+        uint64_t seed = 0;
+        const Job job = [&]() {
+            const Coord first = {short(level.w / 2), short(level.h / 2)};
+            board.reset(level.w, level.h, level.percent * level.w * level.h / 100);
+            if(level.no_guess)
+                NoGuess::generate(board, first, seed++);
+            else
+                board.generateBombs(first, seed++);
+            board.reveal(first);
+        };
+        double inline_ms = 0.0, worker_ms = 0.0;
+        constexpr int runs = 5;
+        for(int run = 0; run < runs; run++)
+        {
+            inline_ms = std::max(inline_ms, longest_frame(worker, job, false));
+            worker_ms = std::max(worker_ms, longest_frame(worker, job, true));
+        }
+        printf("%-34s %10.2f %10.2f\n", level.name, inline_ms, worker_ms);
+    }
+
+    return failures;
+}
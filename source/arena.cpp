@@ -0,0 +1,60 @@
+#include "arena.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+const Allocator Arena::heap = {&malloc, &free};
+
+Arena::Arena(const Allocator& allocator)
+    : allocator(allocator), block(nullptr), size(0), top(0), high_water(0), blocks(0)
+{
+}
+
+Arena::~Arena()
+{
+    release();
+}
+
+bool Arena::reserve(size_t capacity)
+{
+    top = 0;
+    if(block && size >= capacity)
+        return true;
+
+    release();
+    // room to line up the start too, in case the allocator doesn't (malloc)
+    block = allocator.allocate(capacity + ALIGNMENT - 1);
+    if(!block)
+        return false;
+    size = capacity + ALIGNMENT - 1;
+    blocks++;
+    return true;
+}
+
+void* Arena::take(size_t bytes)
+{
+    const uintptr_t base = reinterpret_cast<uintptr_t>(block);
+    const uintptr_t start = (base + top + ALIGNMENT - 1) & ~uintptr_t(ALIGNMENT - 1);
+    const size_t end = start - base + bytes;
+    if(!block || end > size)
+        return nullptr;
+
+    top = end;
+    if(top > high_water)
+        high_water = top;
+    return reinterpret_cast<void*>(start);
+}
+
+void Arena::reset()
+{
+    top = 0;
+}
+
+void Arena::release()
+{
+    if(block)
+        allocator.release(block);
+    block = nullptr;
+    size = 0;
+    top = 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+// The memory pool the geometry of a level is taken from
+
+#include <cstddef>
+
+// Where an Arena gets its block from: linearAlloc and linearFree on the 3DS (see LevelWide), malloc and free anywhere else
+struct Allocator {
+    void* (*allocate)(size_t bytes);
+    void (*release)(void* memory);
+};
+
+// One block reserved once and handed out again and again: buffers are taken one after the other from its start,
+// and all given back at once. Levels of any size one after another then neither fragment what the block came from
+// nor pay for an allocation each
+struct Arena {
+    // What is taken starts on a multiple of this, like what linearAlloc returns
+    static constexpr size_t ALIGNMENT = 0x80;
+    // malloc and free
+    static const Allocator heap;
+
+    explicit Arena(const Allocator& allocator);
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Makes sure the block holds at least capacity bytes, only going back to the allocator for a bigger one.
+    // Whatever was taken is given back. false if the allocator had none, and then the arena holds nothing
+    bool reserve(size_t capacity);
+    // bytes after whatever was taken since the last reset, nullptr if they don't fit in the block
+    void* take(size_t bytes);
+    // Gives back everything taken, keeping the block
+    void reset();
+    // Gives the block back to the allocator
+    void release();
+
+    size_t capacity() const
+    {
+        return size;
+    }
+    size_t used() const
+    {
+        return top;
+    }
+    // The most ever used at once, padding included, since the arena was made
+    size_t highWater() const
+    {
+        return high_water;
+    }
+    // How many blocks the allocator gave, reserve having had to grow
+    int reservations() const
+    {
+        return blocks;
+    }
+
+private:
+    Allocator allocator;
+    void* block;
+    size_t size, top, high_water;
+    int blocks;
+};
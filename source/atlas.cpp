@@ -0,0 +1,35 @@
+#include "atlas.h"
+
+uint32_t Atlas::over(uint32_t base, uint32_t overlay)
+{
+    const uint32_t alpha = overlay & 0xFF;
+    if(alpha == 0xFF)
+        return overlay;
+    if(alpha == 0)
+        return base;
+
+    // every channel, alpha included: overlay * alpha + base * (1 - alpha), rounded
+    uint32_t out = 0;
+    for(int shift = 0; shift < 32; shift += 8)
+    {
+        const uint32_t top = shift ? (overlay >> shift) & 0xFF : 0xFF;
+        const uint32_t bottom = (base >> shift) & 0xFF;
+        const uint32_t mixed = top * alpha + bottom * (0xFF - alpha);
+        out |= ((mixed + 0x7F) / 0xFF) << shift;
+    }
+    return out;
+}
+
+void Atlas::compose(const uint32_t* src, int src_width, int base_x, int base_y, int overlay_x, int overlay_y,
+                    uint32_t* dst, int dst_width, int dst_x, int dst_y, int size)
+{
+    for(int y = 0; y < size; y++)
+    {
+        for(int x = 0; x < size; x++)
+        {
+            const uint32_t base = src[texelOffset(base_x + x, base_y + y, src_width)];
+            const uint32_t overlay = src[texelOffset(overlay_x + x, overlay_y + y, src_width)];
+            dst[texelOffset(dst_x + x, dst_y + y, dst_width)] = over(base, overlay);
+        }
+    }
+}
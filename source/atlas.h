@@ -0,0 +1,23 @@
+#pragma once
+
+// Texel work on 3DS textures: they are GPU_RGBA8, one uint32_t per texel with the alpha in the low byte, stored in 8x8 tiles
+// whose texels go in Z-order. Rows count from the start of the data, which is the bottom of the image (v = 0).
+
+#include <cstdint>
+
+namespace Atlas {
+    inline int texelOffset(int x, int y, int width)
+    {
+        // interleave the low 3 bits of x and y, x first
+        const int morton = (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) | ((x & 4) << 2) | ((y & 4) << 3);
+        return ((y >> 3) * (width >> 3) + (x >> 3)) * 64 + morton;
+    }
+
+    // overlay drawn on top of base with regular alpha blending
+    uint32_t over(uint32_t base, uint32_t overlay);
+
+    // Writes overlay over base into dst, all three being size x size squares of texels.
+    // (x, y) are the bottom left texels of each square, in their texture's rows (see above)
+    void compose(const uint32_t* src, int src_width, int base_x, int base_y, int overlay_x, int overlay_y,
+                 uint32_t* dst, int dst_width, int dst_x, int dst_y, int size);
+};
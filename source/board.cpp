@@ -0,0 +1,270 @@
+#include "board.h"
+#include "neighbours.h"
+#include "rng.h"
+
+#include <algorithm>
+
+namespace {
+    #define XY_TO_IDX(x, y, m) ((x) + ((y) * (m)->width))
+    #define IDX_TO_X(idx, m) ((idx) % (m)->width)
+    #define IDX_TO_Y(idx, m) ((idx) / (m)->width)
+
+    #define PT_TO_IDX(pt, m) ((pt).x + ((pt).y * (m)->width))
+}
+
+void Board::reset(short w, short h, int bomb_count)
+{
+    width = w;
+    height = h;
+    bombs = bomb_count;
+    flags_count = 0;
+
+    const int size = width * height;
+    const int words = (size + WORD_BITS - 1) / WORD_BITS;
+    hidden_safe = size - bombs;
+    mine_bits.assign(words, 0);
+    open_bits.assign(words, 0);
+    flag_bits.assign(words, 0);
+    counts.assign((size + 1) / 2, 0);
+    revealed.clear();
+    revealed.reserve(size);
+    flood_stack.clear();
+    flood_stack.reserve(size);
+}
+
+void Board::generateBombs(Coord safe, uint64_t bomb_seed)
+{
+    const int size = width * height;
+    std::fill(mine_bits.begin(), mine_bits.end(), 0);
+    seed = bomb_seed;
+
+    // The squares a bomb may go on are numbered in reading order, skipping the safe zone,
+    // so that picking a candidate number is all it takes: no retries, whatever the density.
+    const int safe_x_beg = std::max(safe.x - 1, 0);
+    const int safe_x_end = std::min(safe.x + 1, width - 1);
+    const int safe_y_beg = std::max(safe.y - 1, 0);
+    const int safe_y_end = std::min(safe.y + 1, height - 1);
+    const int safe_w = safe_x_end - safe_x_beg + 1;
+    const int safe_h = safe_y_end - safe_y_beg + 1;
+    const int row_candidates = width - safe_w;
+    const int before_safe = safe_y_beg * width;
+    const int beside_safe = safe_h * row_candidates;
+    const int candidates = size - safe_w * safe_h;
+    const auto candidate_to_idx = [&](int c) -> int {
+        if(c < before_safe)
+            return c;
+        c -= before_safe;
+        if(c < beside_safe)
+        {
+            const int y = safe_y_beg + c / row_candidates;
+            int x = c % row_candidates;
+            if(x >= safe_x_beg)
+                x += safe_w;
+            return XY_TO_IDX(x, y, this);
+        }
+        c -= beside_safe;
+        return (safe_y_end + 1) * width + c;
+    };
+
+    // Floyd's sampling: exactly one random number per bomb, and every set of squares is equally likely
+    Rng rng(seed);
+    const int placed = std::min(bombs, candidates);
+    hidden_safe = size - placed;
+    for(int j = candidates - placed; j < candidates; j++)
+    {
+        int pos = candidate_to_idx(rng.below(j + 1));
+        if(isMine(pos))
+            pos = candidate_to_idx(j);
+
+        setBit(mine_bits, pos);
+    }
+
+    Neighbours::count(mine_bits.data(), width, height, counts.data(), count_scratch);
+}
+
+void Board::moveMine(int from, int to)
+{
+    clearBit(mine_bits, from);
+    setBit(mine_bits, to);
+
+    // a bomb counts itself, so its whole 3x3 square changes
+    const auto bump = [this](int pos, int delta) {
+        const int x = IDX_TO_X(pos, this);
+        const int y = IDX_TO_Y(pos, this);
+        for(int ny = std::max(y - 1, 0); ny <= std::min(y + 1, height - 1); ny++)
+        {
+            for(int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); nx++)
+            {
+                const int idx = XY_TO_IDX(nx, ny, this);
+                const int shift = (idx % 2) * 4;
+                counts[idx / 2] = uint8_t(counts[idx / 2] + delta * (1 << shift));
+            }
+        }
+    };
+    bump(from, -1);
+    bump(to, +1);
+}
+
+void Board::checkAround(Coord point)
+{
+    const int start = PT_TO_IDX(point, this);
+    if(isOpen(start))
+        return;
+
+    // a square is marked open when it's pushed, so it can't be pushed twice
+    // and the stack never holds more than the whole board
+    setBit(open_bits, start);
+    flood_stack.push_back(start);
+    while(!flood_stack.empty())
+    {
+        const int pos = flood_stack.back();
+        flood_stack.pop_back();
+
+        if(isFlagged(pos))
+        {
+            clearBit(flag_bits, pos);
+            flags_count--;
+        }
+        revealed.push_back(pos);
+        hidden_safe--;
+
+        if(count(pos) != 0)
+            continue;
+
+        const int x = IDX_TO_X(pos, this);
+        const int y = IDX_TO_Y(pos, this);
+        const int x_beg = x == 0 ? x : x - 1;
+        const int x_end = x == width - 1 ? x : x + 1;
+        const int y_beg = y == 0 ? y : y - 1;
+        const int y_end = y == height - 1 ? y : y + 1;
+        for(int ny = y_beg; ny <= y_end; ny++)
+        {
+            for(int nx = x_beg; nx <= x_end; nx++)
+            {
+                const int idx = XY_TO_IDX(nx, ny, this);
+                if(!isOpen(idx))
+                {
+                    setBit(open_bits, idx);
+                    flood_stack.push_back(idx);
+                }
+            }
+        }
+    }
+}
+
+Board::Outcome Board::reveal(Coord point)
+{
+    revealed.clear();
+
+    const int pos = PT_TO_IDX(point, this);
+    if(isMine(pos))
+    {
+        revealMines();
+        return Outcome::Lost;
+    }
+
+    checkAround(point);
+
+    return checkWin() ? Outcome::Won : Outcome::Playing;
+}
+
+Board::Outcome Board::chord(Coord point)
+{
+    revealed.clear();
+
+    const int pos = PT_TO_IDX(point, this);
+    if(!isOpen(pos) || isMine(pos))
+        return Outcome::Playing;
+
+    const int x_beg = point.x == 0 ? point.x : point.x - 1;
+    const int x_end = point.x == width - 1 ? point.x : point.x + 1;
+    const int y_beg = point.y == 0 ? point.y : point.y - 1;
+    const int y_end = point.y == height - 1 ? point.y : point.y + 1;
+    int flags = 0;
+    for(int y = y_beg; y <= y_end; y++)
+        for(int x = x_beg; x <= x_end; x++)
+            flags += isFlagged(XY_TO_IDX(x, y, this));
+    if(flags != count(pos))
+        return Outcome::Playing;
+
+    // the openings of every square around go one after the other into revealed, and skip what an earlier one opened
+    bool lost = false;
+    for(int y = y_beg; y <= y_end; y++)
+    {
+        for(int x = x_beg; x <= x_end; x++)
+        {
+            const int idx = XY_TO_IDX(x, y, this);
+            if(isOpen(idx) || isFlagged(idx))
+                continue;
+            if(isMine(idx))
+                lost = true;
+            else
+                checkAround({short(x), short(y)});
+        }
+    }
+    if(lost)
+    {
+        revealMines();
+        return Outcome::Lost;
+    }
+
+    return checkWin() ? Outcome::Won : Outcome::Playing;
+}
+
+void Board::placeFlag(Coord point)
+{
+    const int pos = PT_TO_IDX(point, this);
+    if(isOpen(pos))
+        return;
+
+    if(isFlagged(pos))
+    {
+        clearBit(flag_bits, pos);
+        flags_count--;
+    }
+    else
+    {
+        setBit(flag_bits, pos);
+        flags_count++;
+    }
+}
+
+int Board::countFlags() const
+{
+    int flags = 0;
+    for(const Word word : flag_bits)
+        flags += __builtin_popcount(word);
+    return flags;
+}
+
+void Board::revealMines()
+{
+    const int words = int(mine_bits.size());
+    for(int w = 0; w < words; w++)
+    {
+        Word hidden_mines = mine_bits[w] & ~open_bits[w];
+        open_bits[w] |= hidden_mines;
+        while(hidden_mines)
+        {
+            revealed.push_back(w * WORD_BITS + __builtin_ctz(hidden_mines));
+            hidden_mines &= hidden_mines - 1;
+        }
+    }
+}
+
+bool Board::scanWin() const
+{
+    // the padding bits are 0 in both planes, so they need masking out of the last word
+    const int size = width * height;
+    const int words = int(mine_bits.size());
+    for(int w = 0; w < words; w++)
+    {
+        Word hidden_safe_squares = ~(mine_bits[w] | open_bits[w]);
+        const int bits_left = size - w * WORD_BITS;
+        if(bits_left < WORD_BITS)
+            hidden_safe_squares &= (Word(1) << bits_left) - 1;
+        if(hidden_safe_squares)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+// The rules of a board
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+typedef struct {
+    short x, y;
+} Coord;
+
+struct Board {
+    enum class Outcome {
+        Playing,
+        Lost,
+        Won,
+    };
+
+    // One bit per square, square (x, y) is bit (x + y * width) of the plane.
+    // Bits past the last square of the last word are always 0.
+    using Word = uint32_t;
+    static constexpr int WORD_BITS = 32;
+
+    std::vector<Word> mine_bits, open_bits, flag_bits;
+    // number of bombs around each square, two squares per byte, even squares in the low nibble
+    std::vector<uint8_t> counts;
+    // squares revealed by the last reveal(), in the order they were opened
+    std::vector<int> revealed;
+    // flood fill work list, sized to the board in reset() so that it never allocates while playing
+    std::vector<int> flood_stack;
+    std::vector<uint8_t> count_scratch; // see Neighbours::count
+
+    short width, height;
+    int bombs;
+    int flags_count;
+    int hidden_safe; // squares without a bomb that are still to be revealed, the game is won at 0
+    uint64_t seed; // what the bombs were placed from, see generateBombs and NoGuess::generate
+
+    Board() : width(0), height(0), bombs(0), flags_count(0), hidden_safe(0), seed(0) { }
+
+    static bool getBit(const std::vector<Word>& plane, int idx)
+    {
+        return (plane[idx / WORD_BITS] >> (idx % WORD_BITS)) & 1;
+    }
+    static void setBit(std::vector<Word>& plane, int idx)
+    {
+        plane[idx / WORD_BITS] |= Word(1) << (idx % WORD_BITS);
+    }
+    static void clearBit(std::vector<Word>& plane, int idx)
+    {
+        plane[idx / WORD_BITS] &= ~(Word(1) << (idx % WORD_BITS));
+    }
+
+    int index(Coord point) const
+    {
+        return point.x + point.y * width;
+    }
+    bool isMine(int idx) const
+    {
+        return getBit(mine_bits, idx);
+    }
+    bool isOpen(int idx) const
+    {
+        return getBit(open_bits, idx);
+    }
+    bool isFlagged(int idx) const
+    {
+        return getBit(flag_bits, idx);
+    }
+    int count(int idx) const
+    {
+        return (counts[idx / 2] >> ((idx % 2) * 4)) & 0xF;
+    }
+
+    void reset(short w, short h, int bomb_count);
+
+    // Places the bombs anywhere but in the 3x3 square around safe, the same seed always gives the same board
+    void generateBombs(Coord safe, uint64_t bomb_seed);
+    // Moves the bomb of square from to square to, which has none, keeping the counts around both right
+    void moveMine(int from, int to);
+    // Opens point, and the whole blank area around it if there is one. Every square is visited at most once
+    void checkAround(Coord point);
+    Outcome reveal(Coord point);
+    // On an open number with as many flags around it, reveals every other hidden square around it at once:
+    // a single batch in revealed and a single outcome, losing if one of them is a bomb. Does nothing anywhere else
+    Outcome chord(Coord point);
+    void placeFlag(Coord point);
+    bool checkWin() const
+    {
+        return hidden_safe == 0;
+    }
+
+    // Word at a time operations over the planes
+    int countFlags() const;
+    void revealMines();
+    bool scanWin() const;
+};
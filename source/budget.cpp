@@ -0,0 +1,56 @@
+#include "budget.h"
+#include "board.h"
+#include "culling.h"
+#include "endless.h"
+#include "mesh.h"
+#include "neighbours.h"
+#include "replay.h"
+#include "solver.h"
+
+Budget::Level Budget::level(int width, int height, bool no_guess)
+{
+    const size_t size = size_t(width) * height;
+    const size_t words = (size + Board::WORD_BITS - 1) / Board::WORD_BITS;
+    const Mesh::Layout window = Mesh::window(width, height, 0.0f, 0.0f);
+    const size_t chunks = size_t(window.chunks_x) * window.chunks_y;
+
+    Level level;
+    // see Board::reset: 3 bit planes, a nibble of count per square, and revealed and flood_stack can each hold the whole board
+    level.heap = 3 * words * sizeof(Board::Word) + (size + 1) / 2 + 2 * size * sizeof(int);
+    level.heap += Neighbours::scratchSize(width, height);
+    if(no_guess)
+        level.heap += Solver::memorySize(width, height);
+    // the squares of the window waiting for updateFloor, its floor as it's meshed, and the ranges ThreeD draws
+    level.heap += size_t(window.width) * window.height * sizeof(int);
+    level.heap += Mesh::Floor::memorySize(window) + chunks * sizeof(Culling::Range);
+    // its trace, see MineSweeper::update
+    level.heap += Replay::memorySize();
+
+    level.linear = size_t(window.quads()) * Mesh::QUAD_VERTICES * sizeof(Vertex);
+    return level;
+}
+
+Budget::Level Budget::endless()
+{
+    const Mesh::Layout window = Mesh::window(Mesh::WINDOW_SIZE, Mesh::WINDOW_SIZE, 0.0f, 0.0f);
+    const size_t chunks = size_t(window.chunks_x) * window.chunks_y;
+    const size_t side = Endless::chunksFor(Mesh::WINDOW_SIZE);
+    const size_t pool = side * side;
+
+    Level level;
+    // see Endless::reset: the chunks, their grid and free list, and revealed and flood_stack can each hold all of them
+    level.heap = pool * (sizeof(Endless::Chunk) + 2 * sizeof(int));
+    level.heap += 2 * pool * Endless::CHUNK_SIZE * Endless::CHUNK_SIZE * sizeof(Endless::Square);
+    level.heap += size_t(window.width) * window.height * sizeof(int);
+    level.heap += Mesh::Floor::memorySize(window) + chunks * sizeof(Culling::Range);
+    // its trace, see MineSweeper::update
+    level.heap += Replay::memorySize();
+
+    level.linear = size_t(window.quads()) * Mesh::QUAD_VERTICES * sizeof(Vertex);
+    return level;
+}
+
+size_t Budget::geometry()
+{
+    return endless().linear;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+// What a level costs in heap and linear memory
+
+#include <cstddef>
+
+namespace Budget {
+    // Bytes a width x height level holds on to while it's played:
+    // heap for the board and the lists kept next to it, linear memory for the geometry of its window (see Mesh::window)
+    struct Level {
+        size_t heap, linear;
+    };
+
+    // A no-guess level also holds a solver while its bombs are placed (see NoGuess::generate)
+    Level level(int width, int height, bool no_guess = false);
+    // An endless level: the chunks under its window (see Endless::materialize).
+    // What's kept of the chunks played on and left behind isn't counted, it grows with the ground covered
+    Level endless();
+    // Linear memory reserved once for the geometry of every level (see LevelWide): the most any window takes, that of endless
+    size_t geometry();
+};
@@ -0,0 +1,38 @@
+#include "bytes.h"
+
+#include <cstdio>
+#include <string>
+
+bool Bytes::writeFile(const char* path, const std::vector<uint8_t>& data)
+{
+    const std::string temporary = std::string(path) + ".new";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if(!file)
+        return false;
+    const bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+    if(fclose(file) != 0 || !written)
+    {
+        remove(temporary.c_str());
+        return false;
+    }
+    // some file systems won't rename over a file
+    if(rename(temporary.c_str(), path) == 0)
+        return true;
+    remove(path);
+    return rename(temporary.c_str(), path) == 0;
+}
+
+bool Bytes::readFile(const char* path, std::vector<uint8_t>& data)
+{
+    FILE* file = fopen(path, "rb");
+    if(!file)
+        return false;
+    data.clear();
+    uint8_t buffer[4096];
+    size_t got;
+    while((got = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        data.insert(data.end(), buffer, buffer + got);
+    const bool failed = ferror(file);
+    fclose(file);
+    return !failed;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+// Byte streams of the files the game writes
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Bytes {
+    // Appends values to out, little-endian whatever the machine
+    struct Writer {
+        std::vector<uint8_t>& out;
+
+        void u8(uint8_t value)
+        {
+            out.push_back(value);
+        }
+        void u16(uint16_t value)
+        {
+            u8(uint8_t(value));
+            u8(uint8_t(value >> 8));
+        }
+        void u32(uint32_t value)
+        {
+            u16(uint16_t(value));
+            u16(uint16_t(value >> 16));
+        }
+        void u64(uint64_t value)
+        {
+            u32(uint32_t(value));
+            u32(uint32_t(value >> 32));
+        }
+        void f32(float value)
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            u32(bits);
+        }
+        // 7 bits a byte, the high bit set on every byte but the last (LEB128)
+        void leb(uint32_t value)
+        {
+            while(value >= 0x80)
+            {
+                u8(uint8_t(value | 0x80));
+                value >>= 7;
+            }
+            u8(uint8_t(value));
+        }
+    };
+
+    // Reads back what Writer wrote. Past the end of data everything reads as 0, and ok turns false
+    struct Reader {
+        const uint8_t* data;
+        size_t size, at;
+        bool ok;
+
+        uint8_t u8()
+        {
+            if(at >= size)
+            {
+                ok = false;
+                return 0;
+            }
+            return data[at++];
+        }
+        uint16_t u16()
+        {
+            const uint16_t low = u8();
+            return uint16_t(low | (u8() << 8));
+        }
+        uint32_t u32()
+        {
+            const uint32_t low = u16();
+            return low | (uint32_t(u16()) << 16);
+        }
+        uint64_t u64()
+        {
+            const uint64_t low = u32();
+            return low | (uint64_t(u32()) << 32);
+        }
+        float f32()
+        {
+            const uint32_t bits = u32();
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+        uint32_t leb()
+        {
+            uint32_t value = 0;
+            for(int shift = 0; shift < 32; shift += 7)
+            {
+                const uint8_t byte = u8();
+                value |= uint32_t(byte & 0x7F) << shift;
+                if(!(byte & 0x80))
+                    return value;
+            }
+            ok = false;
+            return 0;
+        }
+        // everything read, and nothing left
+        bool whole() const
+        {
+            return ok && at == size;
+        }
+    };
+
+    // data is written next to path first and then renamed over it,
+    // so that a file cut short by a crash doesn't replace the last one. False if it couldn't be written
+    bool writeFile(const char* path, const std::vector<uint8_t>& data);
+    // the whole file at path in data, false if it couldn't be read
+    bool readFile(const char* path, std::vector<uint8_t>& data);
+};
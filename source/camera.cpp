@@ -0,0 +1,95 @@
+#include "camera.h"
+
+#include <cstdint>
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+
+    // sin(x) for x in [-PI, PI], as a Taylor series long enough to be exact in a float
+    constexpr double taylorSine(double x)
+    {
+        double term = x, sum = x;
+        for(int n = 1; n < 20; n++)
+        {
+            term *= -x * x / ((2 * n) * (2 * n + 1));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // one turn, and the first entry again at the end so that interpolating never wraps
+    struct Table {
+        float sine[Camera::STEPS + 1];
+    };
+    constexpr Table makeTable()
+    {
+        Table table = {};
+        for(int step = 0; step <= Camera::STEPS; step++)
+        {
+            const double x = 2.0 * PI * step / Camera::STEPS;
+            table.sine[step] = float(taylorSine(x > PI ? x - 2.0 * PI : x));
+        }
+        return table;
+    }
+    constexpr Table table = makeTable();
+
+    // sine at degrees plus quarter turns
+    float lookup(float degrees, int quarters)
+    {
+        // whole turns off first: that subtraction is exact, where scaling a large angle into steps would round it
+        const float within = degrees - float(int32_t(degrees * (1.0f / 360.0f))) * 360.0f;
+        const float steps = within * (Camera::STEPS / 360.0f);
+        // rounded down, negative angles included, without going through floorf
+        int32_t whole = int32_t(steps);
+        if(float(whole) > steps)
+            whole--;
+        const float fraction = steps - float(whole);
+        const int at = (whole + quarters * (Camera::STEPS / 4)) & (Camera::STEPS - 1);
+        return table.sine[at] + (table.sine[at + 1] - table.sine[at]) * fraction;
+    }
+}
+
+float Camera::sine(float degrees)
+{
+    return lookup(degrees, 0);
+}
+
+float Camera::cosine(float degrees)
+{
+    return lookup(degrees, 1);
+}
+
+Camera::Basis Camera::basis(float angleX, float angleY)
+{
+    return {cosine(angleX), sine(angleX), cosine(angleY), sine(angleY)};
+}
+
+void Camera::modelView(const Basis& basis, float rows[4][4])
+{
+    // turning by angleX - 90 about y: its cosine is sin_x, its sine -cos_x
+    const float c = basis.sin_x, s = -basis.cos_x;
+    const float turn[3][3] = {
+        { c, 0.0f, s},
+        { 0.0f, 1.0f, 0.0f},
+        {-s, 0.0f, c},
+    };
+    // then by -angleY about (c, 0, s), already of length 1
+    const float x = c, z = s;
+    const float cb = basis.cos_y, sb = -basis.sin_y, t = 1.0f - cb;
+    const float tilt[3][3] = {
+        {t * x * x + cb, -sb * z, t * z * x},
+        {sb * z, cb, -sb * x},
+        {t * x * z, sb * x, t * z * z + cb},
+    };
+
+    for(int row = 0; row < 4; row++)
+    {
+        for(int col = 0; col < 4; col++)
+            rows[row][col] = row == col && row == 3 ? 1.0f : 0.0f;
+    }
+    for(int row = 0; row < 3; row++)
+    {
+        for(int col = 0; col < 3; col++)
+            rows[row][col] = turn[row][0] * tilt[0][col] + turn[row][1] * tilt[1][col] + turn[row][2] * tilt[2][col];
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+// The trig of the camera, shared by moving around, culling and drawing
+
+namespace Camera {
+    // Sine and cosine of an angle in degrees, interpolated in a table of STEPS per turn made at compile time:
+    // within 1e-5 of libm for any angle, for a few multiplies instead of a call to sinf or cosf on the ARM11
+    constexpr int STEPS = 1024;
+    float sine(float degrees);
+    float cosine(float degrees);
+
+    // The trig of a camera at angleX, angleY (see Play), worked out once a frame and shared by everything that needs it:
+    // moving, finding the square under the crosshair, culling and the modelView of ThreeD::draw
+    struct Basis {
+        float cos_x, sin_x;
+        float cos_y, sin_y;
+    };
+    Basis basis(float angleX, float angleY);
+
+    // What ThreeD::draw used to get out of Mtx_RotateY by angleX - 90 then Mtx_Rotate about that direction by -angleY,
+    // as the rows of a 4x4 matrix applied to column vectors like C3D_Mtx
+    void modelView(const Basis& basis, float rows[4][4]);
+};
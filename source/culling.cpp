@@ -0,0 +1,96 @@
+#include "culling.h"
+
+#include <cmath>
+
+namespace {
+    constexpr float DEGREES_TO_RADIANS = 3.14159265f / 180.0f;
+    // a little wider than the projection, so that rounding never loses a chunk on the edge of the screen
+    constexpr float FOV_SLACK = 1.05f;
+    // how far up the sides go for every step forward, worked out once rather than in every view
+    const float TAN_Y = tanf(Culling::FOV_Y_DEGREES / 2.0f * DEGREES_TO_RADIANS) * FOV_SLACK;
+}
+
+Culling::View Culling::makeView(const Mesh::Layout& layout, float posX, float posZ, const Camera::Basis& camera, float iod)
+{
+    View view;
+
+    // the shader moves vertices by (posX, posZ) plus where the window is on the board, so that's where the eye sits among them,
+    // and looks the opposite way of the camera direction updateCursorLookingAt uses
+    view.eye[0] = -(posX + layout.centreX());
+    view.eye[1] = 0.0f;
+    view.eye[2] = -(posZ + layout.centreZ());
+
+    const float forward[3] = {
+        -camera.cos_x * camera.cos_y,
+        camera.sin_y,
+        -camera.sin_x * camera.cos_y,
+    };
+    // forward x world up, then right x forward
+    const float right[3] = {camera.sin_x, 0.0f, -camera.cos_x};
+    const float up[3] = {
+        right[1] * forward[2] - right[2] * forward[1],
+        right[2] * forward[0] - right[0] * forward[2],
+        right[0] * forward[1] - right[1] * forward[0],
+    };
+
+    const float tan_x = TAN_Y * ASPECT_RATIO;
+    for(int axis = 0; axis < 3; axis++)
+    {
+        view.sides[0][axis] = forward[axis] * tan_x + right[axis];
+        view.sides[1][axis] = forward[axis] * tan_x - right[axis];
+        view.sides[2][axis] = forward[axis] * TAN_Y + up[axis];
+        view.sides[3][axis] = forward[axis] * TAN_Y - up[axis];
+    }
+
+    view.margin = fabsf(iod);
+    return view;
+}
+
+bool Culling::visible(const View& view, const Mesh::Chunk& chunk)
+{
+    const float min[3] = {chunk.min_x - view.margin - view.eye[0], FLOOR_LOW - view.eye[1], chunk.min_z - view.margin - view.eye[2]};
+    const float max[3] = {chunk.max_x + view.margin - view.eye[0], FLOOR_HIGH - view.eye[1], chunk.max_z + view.margin - view.eye[2]};
+
+    // past the fog: measured flat, from the closest point of the chunk
+    const float dx = min[0] > 0.0f ? min[0] : (max[0] < 0.0f ? max[0] : 0.0f);
+    const float dz = min[2] > 0.0f ? min[2] : (max[2] < 0.0f ? max[2] : 0.0f);
+    if(dx * dx + dz * dz > FOG_END * FOG_END)
+        return false;
+
+    // entirely outside one side: even the corner furthest inside it is out
+    for(const auto& side : view.sides)
+    {
+        float furthest = 0.0f;
+        for(int axis = 0; axis < 3; axis++)
+            furthest += side[axis] * (side[axis] > 0.0f ? max[axis] : min[axis]);
+        if(furthest < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool Culling::far(const View& view, const Mesh::Chunk& chunk)
+{
+    // measured flat, from the closest point of the chunk, grown by the margin like in visible
+    const float min_x = chunk.min_x - view.margin - view.eye[0], max_x = chunk.max_x + view.margin - view.eye[0];
+    const float min_z = chunk.min_z - view.margin - view.eye[2], max_z = chunk.max_z + view.margin - view.eye[2];
+    const float dx = min_x > 0.0f ? min_x : (max_x < 0.0f ? max_x : 0.0f);
+    const float dz = min_z > 0.0f ? min_z : (max_z < 0.0f ? max_z : 0.0f);
+    return dx * dx + dz * dz >= LOD_DISTANCE * LOD_DISTANCE;
+}
+
+void Culling::visibleRanges(const View& view, const std::vector<Mesh::Chunk>& chunks, std::vector<Range>& ranges)
+{
+    ranges.clear();
+    for(const Mesh::Chunk& chunk : chunks)
+    {
+        // a group of the floor may have nothing in a chunk (see Mesh::Floor)
+        if(chunk.count == 0 || !visible(view, chunk) || far(view, chunk))
+            continue;
+
+        if(!ranges.empty() && ranges.back().first + ranges.back().count == chunk.first)
+            ranges.back().count += chunk.count;
+        else
+            ranges.push_back({chunk.first, chunk.count});
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+// Which chunks of the floor each eye draws
+
+#include "camera.h"
+#include "mesh.h"
+
+#include <vector>
+
+namespace Culling {
+    // what ThreeD sets up: the vertical field of view and aspect ratio of the projection, and where the fog ends
+    constexpr float FOV_Y_DEGREES = 50.0f;
+    constexpr float ASPECT_RATIO = 400.0f / 240.0f;
+    constexpr float FOG_END = 75.0f;
+    // how far around the player the window of a board has to reach (see Mesh::covers): what the fog lets through,
+    // and the stereo eye offset
+    constexpr float WINDOW_REACH = FOG_END + 1.0f;
+    // where the floor is drawn, and how far the shader drops it in the distance (see smoothstep in program.v.pica)
+    constexpr float FLOOR_HIGH = -1.0f;
+    constexpr float FLOOR_LOW = FLOOR_HIGH - 30.0f;
+    // Past this far from the camera the shader has dropped the floor all the way, and what's left of it before the fog
+    // is seen below the floor a couple of squares in front of the player, which hides it: a chunk entirely beyond it isn't drawn
+    constexpr float LOD_DISTANCE = 50.0f;
+
+    // A camera, in the space of the level's vertices:
+    // the eye, and the inward normals of the 4 sides of its frustum, which all go through the eye
+    struct View {
+        float eye[3];
+        float sides[4][3];
+        // how far past its sides and the fog a chunk may be and still be drawn, covering the stereo eye offset
+        float margin;
+    };
+
+    // posX, posZ, the camera and iod as ThreeD::draw gets them
+    View makeView(const Mesh::Layout& layout, float posX, float posZ, const Camera::Basis& camera, float iod);
+
+    bool visible(const View& view, const Mesh::Chunk& chunk);
+    // the chunk is entirely further than LOD_DISTANCE from either eye, measured flat like the shader does
+    bool far(const View& view, const Mesh::Chunk& chunk);
+
+    // A range of quads to draw
+    struct Range {
+        int first, count;
+    };
+    // replaces ranges with the quads of every chunk that may be visible and isn't far, merging the ones that follow each other
+    void visibleRanges(const View& view, const std::vector<Mesh::Chunk>& chunks, std::vector<Range>& ranges);
+};
@@ -0,0 +1,358 @@
+#include "endless.h"
+#include "rng.h"
+
+#include <cassert>
+#include <cstring>
+
+void Endless::mines(uint64_t seed, uint32_t threshold, int cx, int cy, Word* out)
+{
+    // every chunk has its own stream, numbered by its coordinates: a counter-based generator,
+    // so nothing depends on which chunks were made before
+    uint64_t counter = keyOf(cx, cy);
+    Rng rng(seed ^ Rng::splitmix64(counter));
+    for(int y = 0; y < CHUNK_SIZE; y++)
+    {
+        Word row = 0;
+        for(int x = 0; x < CHUNK_SIZE; x++)
+        {
+            if(rng.next() < threshold)
+                row |= Word(1) << x;
+        }
+        out[y] = row;
+    }
+
+    for(int y = SPAWN_Y - 1; y <= SPAWN_Y + 1; y++)
+    {
+        for(int x = SPAWN_X - 1; x <= SPAWN_X + 1; x++)
+        {
+            if((x >> CHUNK_SHIFT) == cx && (y >> CHUNK_SHIFT) == cy)
+                out[y & (CHUNK_SIZE - 1)] &= ~(Word(1) << (x & (CHUNK_SIZE - 1)));
+        }
+    }
+}
+
+void Endless::reset(int bomb_percent, uint64_t bomb_seed, int size)
+{
+    seed = bomb_seed;
+    threshold = thresholdOf(bomb_percent);
+    flags_count = 0;
+    opened = 0;
+
+    const int side = chunksFor(size);
+    const int chunks = side * side;
+    pool.resize(chunks);
+    free_chunks.clear();
+    free_chunks.reserve(chunks);
+    for(int chunk = chunks - 1; chunk >= 0; chunk--)
+        free_chunks.push_back(chunk);
+    grid.clear();
+    grid.reserve(chunks);
+    grid_x = grid_y = grid_w = grid_h = 0;
+    played.clear();
+
+    // a flood or a loss can't go past the chunks in memory
+    revealed.clear();
+    revealed.reserve(chunks * CHUNK_SIZE * CHUNK_SIZE);
+    flood_stack.clear();
+    flood_stack.reserve(chunks * CHUNK_SIZE * CHUNK_SIZE);
+}
+
+void Endless::load(Chunk& chunk, int cx, int cy)
+{
+    chunk.cx = cx;
+    chunk.cy = cy;
+    mines(seed, threshold, cx, cy, chunk.mine_bits);
+
+    const auto found = played.find(keyOf(cx, cy));
+    if(found != played.end())
+    {
+        memcpy(chunk.open_bits, found->second.open_bits, sizeof(chunk.open_bits));
+        memcpy(chunk.flag_bits, found->second.flag_bits, sizeof(chunk.flag_bits));
+        played.erase(found);
+    }
+    else
+    {
+        memset(chunk.open_bits, 0, sizeof(chunk.open_bits));
+        memset(chunk.flag_bits, 0, sizeof(chunk.flag_bits));
+    }
+}
+
+void Endless::unload(Chunk& chunk)
+{
+    Word touched = 0;
+    for(int y = 0; y < CHUNK_SIZE; y++)
+        touched |= chunk.open_bits[y] | chunk.flag_bits[y];
+    if(!touched)
+        return;
+
+    Played& kept = played[keyOf(chunk.cx, chunk.cy)];
+    memcpy(kept.open_bits, chunk.open_bits, sizeof(kept.open_bits));
+    memcpy(kept.flag_bits, chunk.flag_bits, sizeof(kept.flag_bits));
+}
+
+void Endless::countAround(Chunk& chunk)
+{
+    // the bomb planes of the chunk and of the 8 around it, made again for the ones out of memory
+    Word made[3][3][CHUNK_SIZE];
+    const Word* planes[3][3];
+    for(int dy = 0; dy < 3; dy++)
+    {
+        for(int dx = 0; dx < 3; dx++)
+        {
+            const int cx = chunk.cx + dx - 1, cy = chunk.cy + dy - 1;
+            const Chunk* around = chunkAt(cx * CHUNK_SIZE, cy * CHUNK_SIZE);
+            if(around)
+            {
+                planes[dy][dx] = around->mine_bits;
+            }
+            else
+            {
+                mines(seed, threshold, cx, cy, made[dy][dx]);
+                planes[dy][dx] = made[dy][dx];
+            }
+        }
+    }
+
+    // rows of the chunk with a square more on each side: bit x + 1 is square x, from row -1 to row CHUNK_SIZE
+    uint64_t rows[CHUNK_SIZE + 2];
+    for(int y = -1; y <= CHUNK_SIZE; y++)
+    {
+        const int py = y < 0 ? 0 : (y < CHUNK_SIZE ? 1 : 2);
+        const int row = y & (CHUNK_SIZE - 1);
+        rows[y + 1] = (planes[py][0][row] >> (CHUNK_SIZE - 1)) |
+                      (uint64_t(planes[py][1][row]) << 1) |
+                      (uint64_t(planes[py][2][row] & 1) << (CHUNK_SIZE + 1));
+    }
+
+    // a bomb counts itself, like Neighbours::count
+    for(int y = 0; y < CHUNK_SIZE; y++)
+    {
+        for(int x = 0; x < CHUNK_SIZE; x += 2)
+        {
+            const int even = __builtin_popcountll(((rows[y] >> x) & 7) | (((rows[y + 1] >> x) & 7) << 3) | (((rows[y + 2] >> x) & 7) << 6));
+            const int odd = __builtin_popcountll(((rows[y] >> (x + 1)) & 7) | (((rows[y + 1] >> (x + 1)) & 7) << 3) | (((rows[y + 2] >> (x + 1)) & 7) << 6));
+            chunk.counts[(x + y * CHUNK_SIZE) / 2] = uint8_t(even | (odd << 4));
+        }
+    }
+}
+
+void Endless::materialize(int x0, int y0, int x1, int y1)
+{
+    const int new_x = x0 >> CHUNK_SHIFT;
+    const int new_y = y0 >> CHUNK_SHIFT;
+    const int new_w = ((x1 - 1) >> CHUNK_SHIFT) - new_x + 1;
+    const int new_h = ((y1 - 1) >> CHUNK_SHIFT) - new_y + 1;
+    assert(size_t(new_w * new_h) <= pool.size());
+
+    const auto inside = [&](int cx, int cy) {
+        return cx >= new_x && cy >= new_y && cx < new_x + new_w && cy < new_y + new_h;
+    };
+
+    // what goes out first, so that its chunks can be reused
+    std::vector<int> new_grid(new_w * new_h, -1);
+    for(const int chunk : grid)
+    {
+        if(chunk < 0)
+            continue;
+        Chunk& kept = pool[chunk];
+        if(inside(kept.cx, kept.cy))
+        {
+            new_grid[(kept.cx - new_x) + (kept.cy - new_y) * new_w] = chunk;
+        }
+        else
+        {
+            unload(kept);
+            free_chunks.push_back(chunk);
+        }
+    }
+
+    std::vector<int> loaded;
+    loaded.reserve(new_grid.size());
+    for(int cy = 0; cy < new_h; cy++)
+    {
+        for(int cx = 0; cx < new_w; cx++)
+        {
+            int& slot = new_grid[cx + cy * new_w];
+            if(slot >= 0)
+                continue;
+            slot = free_chunks.back();
+            free_chunks.pop_back();
+            load(pool[slot], new_x + cx, new_y + cy);
+            loaded.push_back(slot);
+        }
+    }
+    grid.swap(new_grid);
+    grid_x = new_x;
+    grid_y = new_y;
+    grid_w = new_w;
+    grid_h = new_h;
+
+    // the bombs of every chunk around are known by now, in memory or not
+    for(const int chunk : loaded)
+        countAround(pool[chunk]);
+
+    revealed.clear();
+    for(const int chunk : loaded)
+        carryOn(pool[chunk]);
+}
+
+void Endless::carryOn(const Chunk& chunk)
+{
+    // only the squares on both sides of the edges of the chunk can be next to an opening that was cut short
+    const int base_x = chunk.cx * CHUNK_SIZE;
+    const int base_y = chunk.cy * CHUNK_SIZE;
+    for(int ly = -1; ly <= CHUNK_SIZE; ly++)
+    {
+        for(int lx = -1; lx <= CHUNK_SIZE; lx++)
+        {
+            if(lx > 0 && ly > 0 && lx < CHUNK_SIZE - 1 && ly < CHUNK_SIZE - 1)
+                continue;
+
+            const int x = base_x + lx, y = base_y + ly;
+            if(!resident(x, y) || isOpen(x, y))
+                continue;
+
+            bool next_to_blank = false;
+            for(int ny = y - 1; ny <= y + 1 && !next_to_blank; ny++)
+            {
+                for(int nx = x - 1; nx <= x + 1 && !next_to_blank; nx++)
+                    next_to_blank = resident(nx, ny) && isOpen(nx, ny) && count(nx, ny) == 0;
+            }
+            if(next_to_blank)
+                checkAround({x, y});
+        }
+    }
+}
+
+void Endless::checkAround(Square point)
+{
+    Chunk* start = chunkAt(point.x, point.y);
+    if(getBit(start->open_bits, point.x, point.y))
+        return;
+
+    // same as Board::checkAround, squares of chunks out of memory are left for carryOn
+    start->open_bits[point.y & (CHUNK_SIZE - 1)] |= Word(1) << (point.x & (CHUNK_SIZE - 1));
+    flood_stack.push_back(point);
+    while(!flood_stack.empty())
+    {
+        const Square pos = flood_stack.back();
+        flood_stack.pop_back();
+
+        Chunk* chunk = chunkAt(pos.x, pos.y);
+        const Word bit = Word(1) << (pos.x & (CHUNK_SIZE - 1));
+        Word& flags = chunk->flag_bits[pos.y & (CHUNK_SIZE - 1)];
+        if(flags & bit)
+        {
+            flags &= ~bit;
+            flags_count--;
+        }
+        revealed.push_back(pos);
+        opened++;
+
+        if(count(pos.x, pos.y) != 0)
+            continue;
+
+        for(int ny = pos.y - 1; ny <= pos.y + 1; ny++)
+        {
+            for(int nx = pos.x - 1; nx <= pos.x + 1; nx++)
+            {
+                Chunk* around = chunkAt(nx, ny);
+                if(!around)
+                    continue;
+                Word& open = around->open_bits[ny & (CHUNK_SIZE - 1)];
+                const Word around_bit = Word(1) << (nx & (CHUNK_SIZE - 1));
+                if(!(open & around_bit))
+                {
+                    open |= around_bit;
+                    flood_stack.push_back({nx, ny});
+                }
+            }
+        }
+    }
+}
+
+Board::Outcome Endless::reveal(Square point)
+{
+    revealed.clear();
+
+    if(isMine(point.x, point.y))
+    {
+        revealMines();
+        return Board::Outcome::Lost;
+    }
+
+    checkAround(point);
+    return Board::Outcome::Playing;
+}
+
+Board::Outcome Endless::chord(Square point)
+{
+    revealed.clear();
+
+    if(!isOpen(point.x, point.y) || isMine(point.x, point.y))
+        return Board::Outcome::Playing;
+    int flags = 0;
+    for(int y = point.y - 1; y <= point.y + 1; y++)
+    {
+        for(int x = point.x - 1; x <= point.x + 1; x++)
+        {
+            if(!resident(x, y))
+                return Board::Outcome::Playing;
+            flags += isFlagged(x, y);
+        }
+    }
+    if(flags != count(point.x, point.y))
+        return Board::Outcome::Playing;
+
+    bool lost = false;
+    for(int y = point.y - 1; y <= point.y + 1; y++)
+    {
+        for(int x = point.x - 1; x <= point.x + 1; x++)
+        {
+            if(isOpen(x, y) || isFlagged(x, y))
+                continue;
+            if(isMine(x, y))
+                lost = true;
+            else
+                checkAround({x, y});
+        }
+    }
+    if(lost)
+    {
+        revealMines();
+        return Board::Outcome::Lost;
+    }
+    return Board::Outcome::Playing;
+}
+
+void Endless::revealMines()
+{
+    for(const int index : grid)
+    {
+        if(index < 0)
+            continue;
+        Chunk& chunk = pool[index];
+        for(int y = 0; y < CHUNK_SIZE; y++)
+        {
+            Word hidden_mines = chunk.mine_bits[y] & ~chunk.open_bits[y];
+            chunk.open_bits[y] |= hidden_mines;
+            while(hidden_mines)
+            {
+                revealed.push_back({chunk.cx * CHUNK_SIZE + __builtin_ctz(hidden_mines), chunk.cy * CHUNK_SIZE + y});
+                hidden_mines &= hidden_mines - 1;
+            }
+        }
+    }
+}
+
+void Endless::placeFlag(Square point)
+{
+    Chunk* chunk = chunkAt(point.x, point.y);
+    if(getBit(chunk->open_bits, point.x, point.y))
+        return;
+
+    Word& flags = chunk->flag_bits[point.y & (CHUNK_SIZE - 1)];
+    const Word bit = Word(1) << (point.x & (CHUNK_SIZE - 1));
+    flags ^= bit;
+    flags_count += (flags & bit) ? 1 : -1;
+}
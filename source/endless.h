@@ -0,0 +1,137 @@
+#pragma once
+
+// The rules of the endless board
+
+#include "board.h"
+
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+// A board without edges. Where the bombs are is a pure function of the seed and of the chunk coordinates,
+// so only the chunks around the player are ever in memory: the rest is made again when the player comes back,
+// save for what was opened or flagged on it.
+// Squares are (x, y) anywhere in int, chunk (cx, cy) holds the squares (cx * CHUNK_SIZE + [0, CHUNK_SIZE), same for y).
+struct Endless {
+    using Word = Board::Word;
+    // a row of a chunk is a single word of each plane
+    static constexpr int CHUNK_SHIFT = 5;
+    static constexpr int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+    static_assert(CHUNK_SIZE == Board::WORD_BITS, "a row of a chunk should be one word");
+    // the 3x3 squares around (0, 0) never have a bomb, that's where the player starts
+    static constexpr int SPAWN_X = 0, SPAWN_Y = 0;
+
+    struct Square {
+        int x, y;
+    };
+
+    struct Chunk {
+        int cx, cy;
+        // bit x of word y is square (x, y) of the chunk
+        Word mine_bits[CHUNK_SIZE], open_bits[CHUNK_SIZE], flag_bits[CHUNK_SIZE];
+        // number of bombs around each square, bombs of the chunks around included, two squares per byte like Board
+        uint8_t counts[CHUNK_SIZE * CHUNK_SIZE / 2];
+    };
+    // what's kept of a chunk that goes out of memory after being played on
+    struct Played {
+        Word open_bits[CHUNK_SIZE], flag_bits[CHUNK_SIZE];
+    };
+
+    // The chunks in memory are the ones of a rectangle, every one of them at grid[(cx - grid_x) + (cy - grid_y) * grid_w]
+    std::vector<Chunk> pool;
+    std::vector<int> free_chunks;
+    std::vector<int> grid; // index in pool, -1 for none
+    int grid_x, grid_y, grid_w, grid_h;
+    std::unordered_map<uint64_t, Played> played; // by keyOf
+
+    // squares opened by the last reveal() or materialize(), in the order they were opened
+    std::vector<Square> revealed;
+    std::vector<Square> flood_stack;
+
+    uint64_t seed;
+    uint32_t threshold; // a square has a bomb when its random number is below this
+    int flags_count;
+    int opened; // squares without a bomb revealed so far, the score
+
+    Endless() : grid_x(0), grid_y(0), grid_w(0), grid_h(0), seed(0), threshold(0), flags_count(0), opened(0) { }
+
+    // Bomb planes of chunk (cx, cy), the same for the same seed and percentage whatever else happened
+    static void mines(uint64_t seed, uint32_t threshold, int cx, int cy, Word* out);
+    static uint64_t keyOf(int cx, int cy)
+    {
+        return (uint64_t(uint32_t(cx)) << 32) | uint32_t(cy);
+    }
+    static uint32_t thresholdOf(int bomb_percent)
+    {
+        return uint32_t(uint64_t(bomb_percent) * (uint64_t(1) << 32) / 100);
+    }
+
+    // Chunks a side needed for any rectangle of size squares a side to be in memory
+    static int chunksFor(int size)
+    {
+        return (size + CHUNK_SIZE - 1) / CHUNK_SIZE + 1;
+    }
+
+    // Forgets everything, and sizes the memory for rectangles up to size x size squares (see materialize)
+    void reset(int bomb_percent, uint64_t bomb_seed, int size);
+    // Keeps in memory the chunks over the squares [x0, x1) x [y0, y1), and only those.
+    // Openings that stopped at the edge of the last rectangle carry on into the new chunks (see revealed)
+    void materialize(int x0, int y0, int x1, int y1);
+
+    Chunk* chunkAt(int x, int y)
+    {
+        const int cx = (x >> CHUNK_SHIFT) - grid_x;
+        const int cy = (y >> CHUNK_SHIFT) - grid_y;
+        if(cx < 0 || cy < 0 || cx >= grid_w || cy >= grid_h)
+            return nullptr;
+        const int chunk = grid[cx + cy * grid_w];
+        return chunk < 0 ? nullptr : &pool[chunk];
+    }
+    const Chunk* chunkAt(int x, int y) const
+    {
+        return const_cast<Endless*>(this)->chunkAt(x, y);
+    }
+    bool resident(int x, int y) const
+    {
+        return chunkAt(x, y) != nullptr;
+    }
+
+    // These only work on squares in memory
+    static bool getBit(const Word* plane, int x, int y)
+    {
+        return (plane[y & (CHUNK_SIZE - 1)] >> (x & (CHUNK_SIZE - 1))) & 1;
+    }
+    bool isMine(int x, int y) const
+    {
+        return getBit(chunkAt(x, y)->mine_bits, x, y);
+    }
+    bool isOpen(int x, int y) const
+    {
+        return getBit(chunkAt(x, y)->open_bits, x, y);
+    }
+    bool isFlagged(int x, int y) const
+    {
+        return getBit(chunkAt(x, y)->flag_bits, x, y);
+    }
+    int count(int x, int y) const
+    {
+        const int idx = (x & (CHUNK_SIZE - 1)) + (y & (CHUNK_SIZE - 1)) * CHUNK_SIZE;
+        return (chunkAt(x, y)->counts[idx / 2] >> ((idx % 2) * 4)) & 0xF;
+    }
+
+    // Like Board, but the opening stops at the chunks out of memory, and there's no winning
+    Board::Outcome reveal(Square point);
+    // Like Board, doing nothing unless the squares around point are all in memory
+    Board::Outcome chord(Square point);
+    void placeFlag(Square point);
+
+private:
+    void load(Chunk& chunk, int cx, int cy);
+    void unload(Chunk& chunk);
+    void countAround(Chunk& chunk);
+    void checkAround(Square point);
+    // shows every bomb in memory, the rest of the board is too far to matter
+    void revealMines();
+    // opens the squares next to open blanks of the chunks around that couldn't be opened while it was out of memory
+    void carryOn(const Chunk& chunk);
+};
@@ -1,5 +1,6 @@
 #include "verts.h"
 #include "mine.h"
+#include "profile.h"
 #include "spritesheet.h"
 
 u32 __stacksize__ = 128 * 1024;
@@ -8,8 +9,6 @@ int main()
 {
     // Initialize libs
 
-    srand(time(nullptr));
-
     romfsInit();
     gfxInitDefault();
     // consoleInit(GFX_BOTTOM, nullptr);
@@ -29,34 +28,51 @@ int main()
     C2D_SpriteSheet sheet = C2D_SpriteSheetLoad("romfs:/gfx/spritesheet.t3x");
 
     ProgramWide::init(C2D_SpriteSheetGetImage(sheet, 0).tex);
+    if(!LevelWide::reserve())
+        DEBUGPRINT("couldn't reserve linear memory for the biggest level\n");
 
     MineSweeper mines(sheet);
+    mines.seed = osGetTime();
+    if(mines.resume())
+        DEBUGPRINT("resumed the saved game\n");
+
+    // Going to the HOME menu may be the last the program sees: it can be closed from there, or the console turned off.
+    // The other hooks can come from APT's own thread, while the game is being played on this one
+    aptHookCookie save_hook;
+    aptHook(&save_hook, [](APT_HookType hook, void* param) {
+        if(hook == APTHOOK_ONSUSPEND)
+            static_cast<MineSweeper*>(param)->save();
+    }, &mines);
 
     // Main loop
     while (aptMainLoop())
     {
-        hidScanInput();
+        u32 kDown, kHeld;
+        touchPosition touch;
+        {
+            const Profile::Scope timed(Profile::Input);
+            hidScanInput();
+            kDown = hidKeysDown();
+            kHeld = hidKeysHeld();
+            hidTouchRead(&touch);
+        }
 
         // Respond to user input
-        u32 kDown = hidKeysDown();
-        u32 kHeld = hidKeysHeld();
         if (kDown & KEY_START)
             break; // break in order to return to hbmenu
-        else if(kDown & KEY_SELECT)
-            mines.in_controls = !mines.in_controls;
 
-        touchPosition touch;
-        hidTouchRead(&touch);
-        mines.update(kDown, kHeld, touch);
-
-        /*
-        printf("\x1b[2;1HCPU:     %6.2f%%\x1b[K", C3D_GetProcessingTime()*6.0f);
-        printf("\x1b[3;1HGPU:     %6.2f%%\x1b[K", C3D_GetDrawingTime()*6.0f);
-        printf("\x1b[4;1HCmdBuf:  %6.2f%%\x1b[K", C3D_GetCmdBufUsage()*100.0f);
-        printf("\x1b[6;1HWidth:  %2d\x1b[K", mines.width);
-        printf("\x1b[7;1HHeight:  %2d\x1b[K", mines.height);
-        printf("\x1b[8;1HBomb %%:  %2d%%\x1b[K", mines.bombpercent);
-        */
+        // touching the bottom screen shows how long the last frames took, touching it again writes them down
+        if (kDown & KEY_TOUCH)
+        {
+            if(mines.show_profile)
+                mines.writeProfile();
+            mines.show_profile = !mines.show_profile;
+        }
+
+        {
+            const Profile::Scope timed(Profile::Update);
+            mines.update(kDown, kHeld, touch);
+        }
 
         // Render the scene
         C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
@@ -70,11 +86,16 @@ int main()
             C3D_FrameDrawOn(top_screen_left);
             if(mines.playing)
             {
-                mines.renderTerrain(-iod);
+                const Camera::Basis camera = mines.camera();
+                {
+                    const Profile::Scope timed(Profile::LeftEye);
+                    mines.renderTerrain(camera, -iod);
+                }
                 if(iod > 0.0f)
                 {
                     C3D_FrameDrawOn(top_screen_right);
-                    mines.renderTerrain(iod);
+                    const Profile::Scope timed(Profile::RightEye);
+                    mines.renderTerrain(camera, iod);
                 }
             }
             else
@@ -89,14 +110,25 @@ int main()
             C3D_FrameDrawOn(bottom_screen);
             C2D_SceneTarget(bottom_screen);
 
-            C2D_Prepare();
-            mines.renderGui();
-            C2D_Flush();
+            {
+                const Profile::Scope timed(Profile::Gui);
+                C2D_Prepare();
+                mines.renderGui();
+                if(mines.show_profile)
+                    mines.renderProfile();
+                C2D_Flush();
+            }
 
         C3D_FrameEnd(0);
+        Profile::endFrame();
     }
 
-    LevelWide::exit();
+    // the game in progress is picked up next time, this also waits for a level still in the making
+    aptUnhook(&save_hook);
+    if(mines.playing)
+        mines.writeTrace();
+    mines.save();
+    LevelWide::release();
     ProgramWide::exit();
 
     C2D_SpriteSheetFree(sheet);
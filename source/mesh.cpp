@@ -0,0 +1,408 @@
+#include "mesh.h"
+
+namespace {
+    // Storage orders of the corners: both make the same two triangles, wound the other way round
+    constexpr int facing_front[Mesh::QUAD_VERTICES] = {0, 1, 2, 3};
+    constexpr int facing_back[Mesh::QUAD_VERTICES] = {0, 2, 1, 3};
+
+    // the cursor floats slightly above the floor, so that they don't fight
+    constexpr float CURSOR_DY = 0.0625f/4.0f;
+    // walls are pulled in slightly so that the floor never pokes through them
+    constexpr float WALL_INSET = 0.0625f/4.0f;
+    constexpr float WALL_HEIGHT = 2.0f;
+
+    // no tile yet, see Floor::reset
+    constexpr uint8_t NO_TILE = 0xFF;
+    // what Floor::changed has for a chunk
+    constexpr uint8_t UNCHANGED = 0, SQUARES_CHANGED = 1, NOT_MESHED = 2;
+    static_assert(Mesh::CHUNK_SIZE * Mesh::CHUNK_SIZE <= 256, "a quad of a chunk should be a byte away from its start, see Floor::slots");
+
+    // every patch, made by the compiler: patches.templates[h - 1][w - 1] is w x h squares
+    struct Patches {
+        Mesh::QuadTemplate templates[Mesh::MERGE_SIZE][Mesh::MERGE_SIZE];
+    };
+    constexpr Patches makePatches()
+    {
+        Patches patches = {};
+        for(int h = 1; h <= Mesh::MERGE_SIZE; h++)
+            for(int w = 1; w <= Mesh::MERGE_SIZE; w++)
+                patches.templates[h - 1][w - 1] = Mesh::patchTemplate(w, h);
+        return patches;
+    }
+    constexpr Patches patches = makePatches();
+
+    // a template moved by x, z steps of a Vertex
+    void copyQuad(Vertex* quad, const Mesh::QuadTemplate& tile, int16_t x, int16_t z)
+    {
+        for(int vert = 0; vert < Mesh::QUAD_VERTICES; vert++)
+        {
+            quad[vert] = tile.corners[vert];
+            quad[vert].position[0] += x;
+            quad[vert].position[2] += z;
+        }
+    }
+
+    // position(dx, dy, out) gives the position of the corner at (dx, dy) of the quad
+    template<typename Position>
+    void writeQuad(Vertex* quad, const int* order, const Mesh::QuadUVs& uvs, Position position)
+    {
+        for(int vert = 0; vert < Mesh::QUAD_VERTICES; vert++)
+        {
+            const int corner = order[vert];
+            float pos[3];
+            position(float(corner % 2), float(corner / 2), pos);
+            quad[vert] = Vertex(pos[0], pos[1], pos[2], uvs.u[corner], uvs.v[corner]);
+        }
+    }
+}
+
+void Mesh::fillIndices(uint16_t* indices, int quads)
+{
+    for(int quad = 0; quad < quads; quad++)
+    {
+        for(int i = 0; i < QUAD_INDICES; i++)
+        {
+            indices[quad * QUAD_INDICES + i] = uint16_t(quad * QUAD_VERTICES + quad_indices[i]);
+        }
+    }
+}
+
+void Mesh::chunks(const Layout& layout, std::vector<Chunk>& out)
+{
+    out.clear();
+    out.reserve(layout.chunks_x * layout.chunks_y);
+    const float minx = layout.width / -2.0f;
+    const float miny = layout.height / -2.0f;
+    for(int chunk_y = 0; chunk_y < layout.chunks_y; chunk_y++)
+    {
+        for(int chunk_x = 0; chunk_x < layout.chunks_x; chunk_x++)
+        {
+            Chunk chunk;
+            chunk.first = layout.chunkStart(chunk_x, chunk_y);
+            chunk.count = layout.chunkWidth(chunk_x) * layout.chunkHeight(chunk_y);
+            chunk.min_x = minx + float(chunk_x * CHUNK_SIZE);
+            chunk.min_z = miny + float(chunk_y * CHUNK_SIZE);
+            chunk.max_x = chunk.min_x + float(layout.chunkWidth(chunk_x));
+            chunk.max_z = chunk.min_z + float(layout.chunkHeight(chunk_y));
+            out.push_back(chunk);
+        }
+    }
+}
+
+Mesh::Layout Mesh::window(int board_width, int board_height, float x, float y)
+{
+    const int w = board_width < WINDOW_SIZE ? board_width : WINDOW_SIZE;
+    const int h = board_height < WINDOW_SIZE ? board_height : WINDOW_SIZE;
+    const auto start = [](float centre, int size, int board_size) {
+        const int first = int(centre) - size / 2;
+        return first < 0 ? 0 : (first > board_size - size ? board_size - size : first);
+    };
+    return Layout(board_width, board_height, start(x, w, board_width), start(y, h, board_height), w, h);
+}
+
+bool Mesh::covers(const Layout& layout, float x, float y, float reach)
+{
+    return (layout.hasLeftWalls() || x - reach >= float(layout.x0)) &&
+           (layout.hasRightWalls() || x + reach <= float(layout.x0 + layout.width)) &&
+           (layout.hasTopWalls() || y - reach >= float(layout.y0)) &&
+           (layout.hasBottomWalls() || y + reach <= float(layout.y0 + layout.height));
+}
+
+void Mesh::walls(Vertex* vertices, const Layout& layout, const QuadUVs& uvs)
+{
+    const float minx = layout.width / -2.0f;
+    const float miny = layout.height / -2.0f;
+    const float maxx = -minx;
+    const float maxy = -miny;
+
+    for(int i = 0; i < layout.width; i++)
+    {
+        const float x = minx + float(i);
+        writeQuad(&vertices[(layout.topWalls() + i) * QUAD_VERTICES], facing_back, uvs, [&](float dx, float dy, float* pos) {
+            pos[0] = x + dx;
+            pos[1] = FLOOR_Y + dy * WALL_HEIGHT;
+            pos[2] = miny + WALL_INSET;
+        });
+        writeQuad(&vertices[(layout.bottomWalls() + i) * QUAD_VERTICES], facing_front, uvs, [&](float dx, float dy, float* pos) {
+            pos[0] = x + dx;
+            pos[1] = FLOOR_Y + dy * WALL_HEIGHT;
+            pos[2] = maxy - WALL_INSET;
+        });
+    }
+
+    for(int i = 0; i < layout.height; i++)
+    {
+        const float y = miny + float(i);
+        writeQuad(&vertices[(layout.leftWalls() + i) * QUAD_VERTICES], facing_front, uvs, [&](float dx, float dy, float* pos) {
+            pos[0] = minx + WALL_INSET;
+            pos[1] = FLOOR_Y + dy * WALL_HEIGHT;
+            pos[2] = y + dx;
+        });
+        writeQuad(&vertices[(layout.rightWalls() + i) * QUAD_VERTICES], facing_back, uvs, [&](float dx, float dy, float* pos) {
+            pos[0] = maxx - WALL_INSET;
+            pos[1] = FLOOR_Y + dy * WALL_HEIGHT;
+            pos[2] = y + dx;
+        });
+    }
+}
+
+void Mesh::floorTile(Vertex* vertices, const Layout& layout, int square, const QuadTemplate& tile)
+{
+    // squares are whole units apart, and windows are whole or half units off centre: both are whole steps of a Vertex
+    const int16_t x = Vertex::quantize(layout.width / -2.0f + float(square % layout.board_width - layout.x0), Vertex::POSITION_SCALE);
+    const int16_t z = Vertex::quantize(layout.height / -2.0f + float(square / layout.board_width - layout.y0), Vertex::POSITION_SCALE);
+    copyQuad(&vertices[layout.floorQuad(square) * QUAD_VERTICES], tile, x, z);
+}
+
+Mesh::Floor::Floor()
+:
+layout(0, 0)
+{
+
+}
+
+void Mesh::Floor::reset(const Layout& window)
+{
+    layout = window;
+    tiles.assign(size_t(layout.width) * layout.height, NO_TILE);
+    meshed.assign(tiles.size(), NO_TILE);
+    slots.assign(tiles.size(), 0);
+    const int chunk_count = layout.chunks_x * layout.chunks_y;
+    changed.assign(chunk_count, NOT_MESHED);
+    changed_chunks.clear();
+    changed_chunks.reserve(chunk_count);
+    for(int chunk = 0; chunk < chunk_count; chunk++)
+        changed_chunks.push_back(chunk);
+    chunks(layout, groups[0]);
+    for(int group = 1; group < FLOOR_GROUPS; group++)
+        groups[group] = groups[0];
+}
+
+void Mesh::Floor::set(int square, int tile)
+{
+    const int x = square % layout.board_width - layout.x0;
+    const int y = square / layout.board_width - layout.y0;
+    uint8_t& at = tiles[x + y * layout.width];
+    if(at == tile)
+        return;
+    at = uint8_t(tile);
+    const int chunk = x / CHUNK_SIZE + y / CHUNK_SIZE * layout.chunks_x;
+    if(changed[chunk] == UNCHANGED)
+    {
+        changed[chunk] = SQUARES_CHANGED;
+        changed_chunks.push_back(chunk);
+    }
+}
+
+void Mesh::Floor::update(Vertex* vertices, const QuadTemplate* tile_templates, const int* group_of)
+{
+    for(const int chunk : changed_chunks)
+    {
+        if(changed[chunk] == NOT_MESHED)
+            meshChunk(vertices, chunk, tile_templates, group_of);
+        else
+            patchChunk(vertices, chunk, tile_templates, group_of);
+        changed[chunk] = UNCHANGED;
+    }
+    changed_chunks.clear();
+}
+
+void Mesh::Floor::meshChunk(Vertex* vertices, int chunk, const QuadTemplate* tile_templates, const int* group_of)
+{
+    const int chunk_x = chunk % layout.chunks_x, chunk_y = chunk / layout.chunks_x;
+    const int width = layout.chunkWidth(chunk_x), height = layout.chunkHeight(chunk_y);
+    const int left = chunk_x * CHUNK_SIZE, top = chunk_y * CHUNK_SIZE;
+    // squares are whole units apart, and windows are whole or half units off centre: whole steps of a Vertex, see floorTile
+    constexpr int STEP = int(Vertex::POSITION_SCALE);
+    const int x0 = Vertex::quantize(layout.width / -2.0f + float(left), Vertex::POSITION_SCALE);
+    const int z0 = Vertex::quantize(layout.height / -2.0f + float(top), Vertex::POSITION_SCALE);
+
+    // the squares on their own in reading order from the end of the range back
+    const int end = layout.chunkStart(chunk_x, chunk_y) + width * height;
+    int count = 0;
+    for(int y = 0; y < height; y++)
+    {
+        for(int x = 0; x < width; x++)
+        {
+            const int at = left + x + (top + y) * layout.width;
+            const int tile = tiles[at];
+            meshed[at] = uint8_t(tile);
+            if(group_of[tile] != 0)
+                continue;
+            slots[at] = uint8_t(count++);
+            copyQuad(&vertices[(end - count) * QUAD_VERTICES], tile_templates[tile], int16_t(x0 + x * STEP), int16_t(z0 + y * STEP));
+        }
+    }
+    groups[0][chunk].first = end - count;
+    groups[0][chunk].count = count;
+    mergePatches(vertices, chunk, group_of, 1);
+}
+
+void Mesh::Floor::patchChunk(Vertex* vertices, int chunk, const QuadTemplate* tile_templates, const int* group_of)
+{
+    const int chunk_x = chunk % layout.chunks_x, chunk_y = chunk / layout.chunks_x;
+    const int width = layout.chunkWidth(chunk_x), height = layout.chunkHeight(chunk_y);
+    const int left = chunk_x * CHUNK_SIZE, top = chunk_y * CHUNK_SIZE;
+    constexpr int STEP = int(Vertex::POSITION_SCALE);
+    const int x0 = Vertex::quantize(layout.width / -2.0f + float(left), Vertex::POSITION_SCALE);
+    const int z0 = Vertex::quantize(layout.height / -2.0f + float(top), Vertex::POSITION_SCALE);
+
+    // a square on its own has the quad at its slot, counted back from the end of the range,
+    // for as long as what's meshed there has no group
+    Chunk& own = groups[0][chunk];
+    const int end = layout.chunkStart(chunk_x, chunk_y) + width * height;
+    const auto quadAt = [&](int slot) { return &vertices[(end - 1 - slot) * QUAD_VERTICES]; };
+    int merge_from = FLOOR_GROUPS;
+    for(int y = 0; y < height; y++)
+    {
+        for(int x = 0; x < width; x++)
+        {
+            const int at = left + x + (top + y) * layout.width;
+            const int tile = tiles[at], was = meshed[at];
+            if(tile == was)
+                continue;
+            meshed[at] = uint8_t(tile);
+            const int group = group_of[tile], was_group = group_of[was];
+            if(group != 0 && group < merge_from)
+                merge_from = group;
+            if(was_group != 0 && was_group < merge_from)
+                merge_from = was_group;
+
+            if(group == 0 && was_group == 0)
+                copyQuad(quadAt(slots[at]), tile_templates[tile], int16_t(x0 + x * STEP), int16_t(z0 + y * STEP));
+            else if(group == 0)
+            {
+                // the patches never reach that far, there are fewer of them than squares left
+                slots[at] = uint8_t(own.count++);
+                copyQuad(quadAt(slots[at]), tile_templates[tile], int16_t(x0 + x * STEP), int16_t(z0 + y * STEP));
+            }
+            else if(was_group == 0)
+            {
+                // the last square on its own moves into the slot left
+                const int slot = slots[at], last = --own.count;
+                if(slot == last)
+                    continue;
+                Vertex* into = quadAt(slot);
+                const Vertex* from = quadAt(last);
+                for(int vert = 0; vert < QUAD_VERTICES; vert++)
+                    into[vert] = from[vert];
+                for(int sy = top; sy < top + height; sy++)
+                {
+                    for(int sx = left; sx < left + width; sx++)
+                    {
+                        const int other = sx + sy * layout.width;
+                        if(slots[other] == last && group_of[meshed[other]] == 0)
+                            slots[other] = uint8_t(slot);
+                    }
+                }
+            }
+        }
+    }
+    own.first = end - own.count;
+    if(merge_from < FLOOR_GROUPS)
+        mergePatches(vertices, chunk, group_of, merge_from);
+}
+
+void Mesh::Floor::mergePatches(Vertex* vertices, int chunk, const int* group_of, int from)
+{
+    const int chunk_x = chunk % layout.chunks_x, chunk_y = chunk / layout.chunks_x;
+    const int width = layout.chunkWidth(chunk_x), height = layout.chunkHeight(chunk_y);
+    const int left = chunk_x * CHUNK_SIZE, top = chunk_y * CHUNK_SIZE;
+    const uint8_t* chunk_tiles = &meshed[left + top * layout.width];
+    constexpr int STEP = int(Vertex::POSITION_SCALE);
+    const int x0 = Vertex::quantize(layout.width / -2.0f + float(left), Vertex::POSITION_SCALE);
+    const int z0 = Vertex::quantize(layout.height / -2.0f + float(top), Vertex::POSITION_SCALE);
+
+    // the squares of each group wait for its turn
+    uint8_t waiting[CHUNK_SIZE * CHUNK_SIZE];
+    int waiting_in[FLOOR_GROUPS] = {};
+    for(int y = 0; y < height; y++)
+    {
+        for(int x = 0; x < width; x++)
+        {
+            const int group = group_of[chunk_tiles[x + y * layout.width]];
+            waiting[x + y * CHUNK_SIZE] = uint8_t(group >= from ? group : 0);
+            waiting_in[group]++;
+        }
+    }
+
+    // the groups before from keep their patches
+    int quad = from == 1 ? layout.chunkStart(chunk_x, chunk_y) : groups[from - 1][chunk].first + groups[from - 1][chunk].count;
+    for(int group = from; group < FLOOR_GROUPS; group++)
+    {
+        const int start = quad;
+        const auto mergeable = [&](int x, int y, int run) {
+            for(int dx = 0; dx < run; dx++)
+            {
+                if(waiting[x + dx + y * CHUNK_SIZE] != group)
+                    return false;
+            }
+            return true;
+        };
+        for(int y = 0; y < height && waiting_in[group] > 0; y++)
+        {
+            for(int x = 0; x < width; x++)
+            {
+                if(waiting[x + y * CHUNK_SIZE] != group)
+                    continue;
+                // the widest run along the row, then as many rows of it as follow
+                int run = 1;
+                while(run < MERGE_SIZE && x + run < width && waiting[x + run + y * CHUNK_SIZE] == group)
+                    run++;
+                int rows = 1;
+                while(rows < MERGE_SIZE && y + rows < height && mergeable(x, y + rows, run))
+                    rows++;
+                for(int dy = 0; dy < rows; dy++)
+                    for(int dx = 0; dx < run; dx++)
+                        waiting[x + dx + (y + dy) * CHUNK_SIZE] = 0;
+                waiting_in[group] -= run * rows;
+                copyQuad(&vertices[quad++ * QUAD_VERTICES], patches.templates[rows - 1][run - 1], int16_t(x0 + x * STEP), int16_t(z0 + y * STEP));
+            }
+        }
+        groups[group][chunk].first = start;
+        groups[group][chunk].count = quad - start;
+    }
+}
+
+int Mesh::Floor::quads() const
+{
+    int count = 0;
+    for(const std::vector<Chunk>& group : groups)
+        for(const Chunk& chunk : group)
+            count += chunk.count;
+    return count;
+}
+
+size_t Mesh::Floor::memory() const
+{
+    size_t bytes = tiles.capacity() + meshed.capacity() + slots.capacity() + changed.capacity() + changed_chunks.capacity() * sizeof(int);
+    for(const std::vector<Chunk>& group : groups)
+        bytes += group.capacity() * sizeof(Chunk);
+    return bytes;
+}
+
+size_t Mesh::Floor::memorySize(const Layout& window)
+{
+    const size_t chunk_count = size_t(window.chunks_x) * window.chunks_y;
+    return 3 * size_t(window.width) * window.height + chunk_count * (FLOOR_GROUPS * sizeof(Chunk) + 1 + sizeof(int));
+}
+
+void Mesh::cursor(Vertex* vertices, const Layout& layout, int x, int y, const QuadUVs& uvs)
+{
+    const float cx = layout.width / -2.0f + float(x - layout.x0);
+    const float cy = layout.height / -2.0f + float(y - layout.y0);
+    writeQuad(&vertices[layout.cursor() * QUAD_VERTICES], facing_front, uvs, [&](float dx, float dy, float* pos) {
+        pos[0] = cx + dx;
+        pos[1] = FLOOR_Y + CURSOR_DY;
+        pos[2] = cy + dy;
+    });
+}
+
+void Mesh::crosshair(Vertex* vertices, const Layout& layout, const QuadUVs& uvs)
+{
+    writeQuad(&vertices[layout.crosshair() * QUAD_VERTICES], facing_back, uvs, [&](float dx, float dy, float* pos) {
+        pos[0] = (dx - 0.5f) / 16.0f;
+        pos[1] = (dy - 0.5f) / 16.0f;
+        pos[2] = -0.5f;
+    });
+}
@@ -0,0 +1,315 @@
+#pragma once
+
+// The geometry of a level
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Positions are in 1/POSITION_SCALE units, small enough for the layer and wall offsets,
+// and texture coordinates in 1/TEXCOORD_SCALE units, exact for any texture up to 16384 texels wide.
+// The shader scales them back. There is no normal: each draw sets it as a fixed attribute (see ThreeD::draw),
+// which makes a vertex 10 bytes instead of 32.
+struct Vertex {
+    static constexpr float POSITION_SCALE = 128.0f;
+    static constexpr float TEXCOORD_SCALE = 16384.0f;
+
+    int16_t position[3];
+    int16_t texcoord[2];
+
+    constexpr Vertex() : position{0,0,0}, texcoord{0,0} { }
+    constexpr Vertex(float x, float y, float z, float u, float v)
+    :
+    position{quantize(x, POSITION_SCALE), quantize(y, POSITION_SCALE), quantize(z, POSITION_SCALE)},
+    texcoord{quantize(u, TEXCOORD_SCALE), quantize(v, TEXCOORD_SCALE)}
+    {
+
+    }
+
+    // rounds to the nearest step, without going through libm
+    static constexpr int16_t quantize(float value, float scale)
+    {
+        const float scaled = value * scale;
+        return int16_t(scaled < 0.0f ? scaled - 0.5f : scaled + 0.5f);
+    }
+};
+static_assert(sizeof(Vertex) == 10, "Vertex should be tightly packed");
+
+namespace Mesh {
+    // Every quad is 4 vertices, corner c being at (c % 2, c / 2) of the quad, drawn as the triangles {0, 1, 2} and {1, 3, 2}
+    constexpr int QUAD_VERTICES = 4;
+    constexpr int QUAD_INDICES = 6;
+    constexpr uint16_t quad_indices[QUAD_INDICES] = {0, 1, 2, 1, 3, 2};
+    // 16-bit indices can't reach past 65536 vertices, which a 99x99 level has more of:
+    // levels are drawn BATCH_QUADS at a time, every batch indexing from its own first vertex,
+    // so one index buffer of that many quads serves every level
+    constexpr int BATCH_QUADS = 4096;
+
+    // Texture coordinates of the 4 corners of a quad
+    struct QuadUVs {
+        float u[QUAD_VERTICES];
+        float v[QUAD_VERTICES];
+    };
+
+    // The floor tiles get a texture of their own, composed out of the sprite sheet (see ProgramWide::composeFloorTiles):
+    // FLOOR_TILE_TEXELS a side, FLOOR_ATLAS_COLUMNS to a row from the bottom left. Unlike the sprite sheet, which tex3ds packs,
+    // where each one goes is known when building, so their UVs are worked out by the compiler
+    constexpr int FLOOR_TILE_TEXELS = 32;
+    constexpr int FLOOR_ATLAS_COLUMNS = 4;
+    constexpr int FLOOR_ATLAS_WIDTH = FLOOR_TILE_TEXELS * FLOOR_ATLAS_COLUMNS;
+    // rows of a texture of tiles of them, a power of two like every texture
+    constexpr int floorAtlasHeight(int tiles)
+    {
+        int height = 8;
+        while(height < (tiles + FLOOR_ATLAS_COLUMNS - 1) / FLOOR_ATLAS_COLUMNS * FLOOR_TILE_TEXELS)
+            height *= 2;
+        return height;
+    }
+    // corners in the order of subtex_uv_funcs: bottom right, bottom left, top right, top left
+    constexpr QuadUVs floorTileUVs(int tile, int tiles)
+    {
+        const float left = float(tile % FLOOR_ATLAS_COLUMNS * FLOOR_TILE_TEXELS) / FLOOR_ATLAS_WIDTH;
+        const float right = float(tile % FLOOR_ATLAS_COLUMNS * FLOOR_TILE_TEXELS + FLOOR_TILE_TEXELS) / FLOOR_ATLAS_WIDTH;
+        const float bottom = float(tile / FLOOR_ATLAS_COLUMNS * FLOOR_TILE_TEXELS) / floorAtlasHeight(tiles);
+        const float top = float(tile / FLOOR_ATLAS_COLUMNS * FLOOR_TILE_TEXELS + FLOOR_TILE_TEXELS) / floorAtlasHeight(tiles);
+        return {{right, left, right, left}, {bottom, bottom, top, top}};
+    }
+
+    constexpr float FLOOR_Y = -1.0f;
+    // A floor square ready to be copied: its vertices at the origin, which are moved by whole steps of a Vertex
+    // to where the square is (see floorTile), the same as if they had been made there
+    struct QuadTemplate {
+        Vertex corners[QUAD_VERTICES];
+    };
+    constexpr QuadTemplate floorTemplate(const QuadUVs& uvs)
+    {
+        QuadTemplate tile = {};
+        for(int corner = 0; corner < QUAD_VERTICES; corner++)
+            tile.corners[corner] = Vertex(float(corner % 2), FLOOR_Y, float(corner / 2), uvs.u[corner], uvs.v[corner]);
+        return tile;
+    }
+
+    // The floor is one quad per square, cut into chunks of CHUNK_SIZE x CHUNK_SIZE squares (less along the far edges),
+    // each one a single range of quads, so that chunks out of sight can be skipped (see Culling)
+    constexpr int CHUNK_SIZE = 16;
+
+    // Only a window of at most WINDOW_SIZE x WINDOW_SIZE squares of a board has geometry, moved along with the player:
+    // that's all the fog lets through (see Culling::FOG_END) with room to walk before it has to move,
+    // and it keeps positions within reach of 16 bits
+    constexpr int WINDOW_SIZE = 13 * CHUNK_SIZE;
+    static_assert(WINDOW_SIZE / 2 + 1 < 32768 / Vertex::POSITION_SCALE, "window positions should fit in a Vertex");
+
+    // Where every part of a level starts, in quads:
+    // {top walls, bottom walls, left walls, right walls, floor chunks, cursor, crosshair}
+    // Each side of walls is contiguous so that it can be drawn with its own normal.
+    // Floor chunks are in reading order, and so are the squares inside each of them.
+    // width and height are those of the window, whose squares start at (x0, y0) of the board;
+    // vertices are placed around the centre of the window rather than the centre of the board
+    struct Layout {
+        int board_width, board_height;
+        int x0, y0;
+        int width, height;
+        int chunks_x, chunks_y;
+
+        // the whole board
+        Layout(int w, int h)
+        :
+        Layout(w, h, 0, 0, w, h)
+        {
+
+        }
+        Layout(int board_w, int board_h, int x, int y, int w, int h)
+        :
+        board_width(board_w), board_height(board_h),
+        x0(x), y0(y),
+        width(w), height(h),
+        chunks_x((w + CHUNK_SIZE - 1) / CHUNK_SIZE), chunks_y((h + CHUNK_SIZE - 1) / CHUNK_SIZE)
+        {
+
+        }
+
+        // where the centre of the window is, from the centre of the board
+        float centreX() const
+        {
+            return board_width / -2.0f + float(x0) + width / 2.0f;
+        }
+        float centreZ() const
+        {
+            return board_height / -2.0f + float(y0) + height / 2.0f;
+        }
+        // square is x + y * board_width
+        bool contains(int square) const
+        {
+            const int x = square % board_width - x0;
+            const int y = square / board_width - y0;
+            return x >= 0 && y >= 0 && x < width && y < height;
+        }
+        // walls only go where the window reaches the edges of the board
+        bool hasTopWalls() const
+        {
+            return y0 == 0;
+        }
+        bool hasBottomWalls() const
+        {
+            return y0 + height == board_height;
+        }
+        bool hasLeftWalls() const
+        {
+            return x0 == 0;
+        }
+        bool hasRightWalls() const
+        {
+            return x0 + width == board_width;
+        }
+
+        int topWalls() const
+        {
+            return 0;
+        }
+        int bottomWalls() const
+        {
+            return width;
+        }
+        int leftWalls() const
+        {
+            return width * 2;
+        }
+        int rightWalls() const
+        {
+            return width * 2 + height;
+        }
+        int floorStart() const
+        {
+            return (width + height) * 2;
+        }
+        int chunkWidth(int chunk_x) const
+        {
+            const int left = width - chunk_x * CHUNK_SIZE;
+            return left < CHUNK_SIZE ? left : CHUNK_SIZE;
+        }
+        int chunkHeight(int chunk_y) const
+        {
+            const int left = height - chunk_y * CHUNK_SIZE;
+            return left < CHUNK_SIZE ? left : CHUNK_SIZE;
+        }
+        // every row of chunks before is full height, every chunk before in the row is full width
+        int chunkStart(int chunk_x, int chunk_y) const
+        {
+            return floorStart() + chunk_y * CHUNK_SIZE * width + chunk_x * CHUNK_SIZE * chunkHeight(chunk_y);
+        }
+        // square is x + y * board_width, and has to be in the window
+        int floorQuad(int square) const
+        {
+            const int x = square % board_width - x0;
+            const int y = square / board_width - y0;
+            const int chunk_x = x / CHUNK_SIZE;
+            const int chunk_y = y / CHUNK_SIZE;
+            return chunkStart(chunk_x, chunk_y) + (y % CHUNK_SIZE) * chunkWidth(chunk_x) + (x % CHUNK_SIZE);
+        }
+        int cursor() const
+        {
+            return floorStart() + width * height;
+        }
+        int crosshair() const
+        {
+            return cursor() + 1;
+        }
+        int quads() const
+        {
+            return crosshair() + 1;
+        }
+    };
+
+    // The window of a board_width x board_height board around the point (x, y) of the board, in squares:
+    // as close to centred on it as the edges allow. Every window of a board is the same size
+    Layout window(int board_width, int board_height, float x, float y);
+    // Whether the window still has everything within reach of (x, y), or needs moving.
+    // The edges of the board count as covered, there's nothing past them to see
+    bool covers(const Layout& layout, float x, float y, float reach);
+
+    // A floor chunk: its quads, and the square it covers in the space of the vertices
+    struct Chunk {
+        int first, count;
+        float min_x, min_z, max_x, max_z;
+    };
+
+    // The tiles of the floor that come in large patches, a fresh board's hidden squares and the open ones of big openings,
+    // each get a texture of their own: the tile REPEAT_COPIES times each way, wrapping round (see ProgramWide::composeFloorTiles).
+    // A patch of one of them up to MERGE_SIZE squares a side is then a single quad, its UVs going over the copies
+    // from -1 to 1, as far as a Vertex reaches
+    constexpr int REPEATING = 2;
+    constexpr int REPEAT_COPIES = 4;
+    constexpr int MERGE_SIZE = 2 * REPEAT_COPIES;
+    // What the floor is drawn as, one texture at a time: group 0 is the squares on their own out of the floor's texture,
+    // then come the patches of each repeating tile
+    constexpr int FLOOR_GROUPS = 1 + REPEATING;
+
+    // A patch of width x height squares, at the origin like floorTemplate, corner c at (c % 2, c / 2) of it.
+    // u goes right to left and v bottom to top over every square, the way floorTileUVs has a tile
+    constexpr QuadTemplate patchTemplate(int width, int height)
+    {
+        QuadTemplate patch = {};
+        for(int corner = 0; corner < QUAD_VERTICES; corner++)
+        {
+            const int dx = corner % 2 * width, dz = corner / 2 * height;
+            patch.corners[corner] = Vertex(float(dx), FLOOR_Y, float(dz),
+                                           -1.0f + float(width - dx) / REPEAT_COPIES, -1.0f + float(dz) / REPEAT_COPIES);
+        }
+        return patch;
+    }
+
+    // The floor of a window, meshed a chunk at a time with the patches of each repeating tile merged greedily:
+    // row by row, the widest run of squares first, then as many rows of it as there are.
+    // A chunk's range of quads (see Layout::chunkStart) has its patches group by group, and its squares on their own at the end.
+    // Only the chunks with a square that changed are meshed again, and only what changed in them: a square on its own
+    // keeps its quad, the last one moves into the quad of one that leaves, and the patches of a group are merged again,
+    // along with the groups after it, only when a square joins or leaves them
+    struct Floor {
+        // the chunks of each group, as Culling takes them
+        std::vector<Chunk> groups[FLOOR_GROUPS];
+
+        Floor();
+        // every square of window without a tile, all of it to be meshed
+        void reset(const Layout& window);
+        // square is x + y * board_width, and has to be in the window
+        void set(int square, int tile);
+        // Meshes the chunks changed since the last update into vertices:
+        // tiles[t] is tile t on its own square, group_of[t] its group, 0 for a tile without a texture of its own
+        void update(Vertex* vertices, const QuadTemplate* tiles, const int* group_of);
+        // every quad the floor is drawn with now, out of width * height squares
+        int quads() const;
+        // bytes held for a window, see Budget, and held now
+        static size_t memorySize(const Layout& window);
+        size_t memory() const;
+
+    private:
+        Layout layout;
+        std::vector<uint8_t> tiles; // of every square of the window, in reading order
+        std::vector<uint8_t> meshed; // the same, as the vertices have them
+        std::vector<uint8_t> slots; // of every square on its own, its quad back from the end of its chunk's range
+        std::vector<uint8_t> changed; // of every chunk, see update
+        std::vector<int> changed_chunks;
+
+        // every square of the chunk from its tiles, after reset
+        void meshChunk(Vertex* vertices, int chunk, const QuadTemplate* tiles, const int* group_of);
+        // only the squares whose tile isn't the one meshed
+        void patchChunk(Vertex* vertices, int chunk, const QuadTemplate* tiles, const int* group_of);
+        // the patches of the groups from from on, the ones before it are left as they are
+        void mergePatches(Vertex* vertices, int chunk, const int* group_of, int from);
+    };
+
+    // indices for quads [0, quads), quad_indices offset by 4 for each quad
+    void fillIndices(uint16_t* indices, int quads);
+    // every floor chunk of the layout, in the order they're stored
+    void chunks(const Layout& layout, std::vector<Chunk>& out);
+
+    // vertices always points at the start of the level, the quads are put where layout says.
+    // Walls are written along every side of the window, only the ones Layout says exist are meant to be drawn
+    void walls(Vertex* vertices, const Layout& layout, const QuadUVs& uvs);
+    // square is x + y * board_width, and has to be in the window
+    void floorTile(Vertex* vertices, const Layout& layout, int square, const QuadTemplate& tile);
+    // (x, y) is a square of the board in the window
+    void cursor(Vertex* vertices, const Layout& layout, int x, int y, const QuadUVs& uvs);
+    // in view space, right in front of the camera
+    void crosshair(Vertex* vertices, const Layout& layout, const QuadUVs& uvs);
+};
@@ -1,14 +1,66 @@
 #include "mine.h"
+#include "budget.h"
+#include "profile.h"
+#include "rng.h"
+#include "save.h"
 
 #include "spritesheet.h"
 
+#include <algorithm>
+#include <malloc.h>
+#include <sys/stat.h>
+
+extern "C" u32 __ctru_heap_size;
+
+namespace {
+    // what the allocators lose to bookkeeping, and what the rest of the game allocates while playing
+    constexpr size_t HEAP_SLACK = 256 * 1024;
+    constexpr size_t LINEAR_SLACK = 256 * 1024;
+    // enough for every line of renderProfile
+    constexpr size_t PROFILE_GLYPHS = 512;
+
+    static_assert(MineSweeper::MAX_SZ <= Save::MAX_SIDE, "every board should fit in a save");
+    static_assert(Keys::A == KEY_A && Keys::B == KEY_B && Keys::X == KEY_X && Keys::Y == KEY_Y && Keys::L == KEY_L && Keys::R == KEY_R &&
+                  Keys::SELECT == KEY_SELECT && Keys::START == KEY_START && Keys::UP == KEY_UP && Keys::DOWN == KEY_DOWN &&
+                  Keys::LEFT == KEY_LEFT && Keys::RIGHT == KEY_RIGHT && Keys::CSTICK_UP == KEY_CSTICK_UP &&
+                  Keys::CSTICK_DOWN == KEY_CSTICK_DOWN && Keys::CSTICK_LEFT == KEY_CSTICK_LEFT && Keys::CSTICK_RIGHT == KEY_CSTICK_RIGHT,
+                  "the rules should see the buttons the way libctru gives them");
+
+    // A side of the board a big step further in direction (1 or -1): by 100 while it stays past 100, by 10 otherwise,
+    // stopping at the smallest and biggest sizes
+    short sizeStep(short size, int direction)
+    {
+        const int step = (direction > 0 ? size : size - 100) >= 100 ? 100 : 10;
+        return short(std::min(std::max(size + direction * step, int(MineSweeper::MIN_SZ)), int(MineSweeper::MAX_SZ)));
+    }
+}
+
+using SubtexUVFPtr = void(*)(const Tex3DS_SubTexture*, float*, float*);
+// one per corner of a Mesh quad
+static constexpr SubtexUVFPtr subtex_uv_funcs[Mesh::QUAD_VERTICES] = {
+    &Tex3DS_SubTextureBottomRight,
+    &Tex3DS_SubTextureBottomLeft,
+    &Tex3DS_SubTextureTopRight,
+    &Tex3DS_SubTextureTopLeft,
+};
+
+static Mesh::QuadUVs subtexUVs(const Tex3DS_SubTexture* subtex)
+{
+    Mesh::QuadUVs uvs;
+    for(int corner = 0; corner < Mesh::QUAD_VERTICES; corner++)
+    {
+        subtex_uv_funcs[corner](subtex, &uvs.u[corner], &uvs.v[corner]);
+    }
+    return uvs;
+}
+
 MineSweeper::MineSweeper(C2D_SpriteSheet sheet)
 :
-width(MIN_SZ), height(MIN_SZ), bombpercent(MIN_BOMBS_PERCENT),
+menu_width(MIN_SZ), menu_height(MIN_SZ), menu_no_guess(false),
 selected_editing(Editing::Width),
-angleX(0.0f), angleY(0.0f), positionX(0.0f), positionZ(0.0f), rotate_speed_factor(ROTATE_SPEED_BASE_FACTOR),
-playing(false), dead(false), win(false), looking_at_floor(false), floor_changed(false),
-in_controls(false), editing_control_type(EditingControls::ABXY), abxy_look(false), dpad_look(true), y_axis_inverted(false)
+too_big(false),
+show_profile(false),
+profile_text(C2D_TextBufNew(PROFILE_GLYPHS))
 {
     hidden_image = C2D_SpriteSheetGetImage(sheet, spritesheet_hidden_idx);
     open_image = C2D_SpriteSheetGetImage(sheet, spritesheet_open_idx);
@@ -48,243 +100,33 @@ in_controls(false), editing_control_type(EditingControls::ABXY), abxy_look(false
     C2D_PlainImageTint(&back_tint, C2D_Color32f(0.125f, 0.125f, 0.125f, 1), 1.0f);
     C2D_PlainImageTint(&front_tint, C2D_Color32f(0.875f, 0.875f, 0.875f, 1), 1.0f);
     C2D_PlainImageTint(&selected_tint, C2D_Color32(255, 200, 76, 255), 1.0f);
-}
-
-namespace {
-    #define XY_TO_IDX(x, y, m) ((x) + ((y) * (m)->width))
-    #define IDX_TO_X(idx, m) ((idx) % (m)->width)
-    #define IDX_TO_Y(idx, m) ((idx) / (m)->width)
-
-    #define PT_TO_IDX(pt, m) ((pt).x + ((pt).y * (m)->width))
-
-    int isTopPoint(Coord point, MineSweeper& mine)
-    {
-        return point.y == 0;
-    }
-    int isBotPoint(Coord point, MineSweeper& mine)
-    {
-        return point.y == mine.height - 1;
-    }
-    int isLeftPoint(Coord point, MineSweeper& mine)
-    {
-        return point.x == 0;
-    }
-    int isRightPoint(Coord point, MineSweeper& mine)
-    {
-        return point.x == mine.width - 1;
-    }
-    Coord modifyPoint(Coord point, short dx, short dy)
-    {
-        return (Coord){point.x + dx, point.y + dy};
-    }
-}
-
-void MineSweeper::generateBombs()
-{
-    const int size = width * height;
-    internal.clear();
-    internal.resize(size, '0');
-    visible.clear();
-    visible.resize(size, '.');
-    around.clear();
-    around.resize(size, 0);
-
-    for(int i = 0; i < bombs; i++)
-    {
-        int pos = rand() % size;
-        while(internal[pos] == '.' || ( \
-        (IDX_TO_X(pos, this) >= (looking_at_x - 1) && IDX_TO_X(pos, this) <= (looking_at_x + 1)) && \
-        (IDX_TO_Y(pos, this) >= (looking_at_y - 1) && IDX_TO_Y(pos, this) <= (looking_at_y + 1))))
-            pos = rand() % size;
-
-        internal[pos] = '.';
-        const int x_beg = IDX_TO_X(pos, this) - 1;
-        const int x_end = x_beg + 2;
-        const int y_beg = IDX_TO_Y(pos, this) - 1;
-        const int y_end = y_beg + 2;
-        for(int x = x_beg; x <= x_end; x++)
-        {
-            if(x < 0 || x >= width)
-                continue;
+    C2D_PlainImageTint(&refused_tint, C2D_Color32(216, 64, 48, 255), 1.0f);
+    C2D_PlainImageTint(&no_guess_tint, C2D_Color32(96, 200, 96, 255), 1.0f);
 
-            for(int y = y_beg; y <= y_end; y++)
-            {
-                if(y < 0 || y >= height)
-                    continue;
-                
-                const int idx = XY_TO_IDX(x, y, this);
-                if(internal[idx] != '.')
-                    internal[idx]++;
-            }
-        }
-    }
+    width = height = MIN_SZ;
+    bombpercent = MIN_BOMBS_PERCENT;
 
-    for(auto& s : internal)
-    {
-        if(s == '0')
-            s = ' ';
-    }
-}
-void MineSweeper::checkAround(Coord point)
-{
-    const int pos = PT_TO_IDX(point, this);
-    if(around[pos] != 0)
-        return;
-
-    const char square = internal[pos];
-    if(square == ' ')
-    {
-        if(visible[pos] == 'f') flags_count--;
-        visible[pos] = square;
-        around[pos] = 1;
-
-        if(!isTopPoint(point, *this))
-            checkAround(modifyPoint(point, 0, -1));
-        if(!isBotPoint(point, *this))
-            checkAround(modifyPoint(point, 0, +1));
-        if(!isLeftPoint(point, *this))
-            checkAround(modifyPoint(point, -1, 0));
-        if(!isRightPoint(point, *this))
-            checkAround(modifyPoint(point, +1, 0));
-            
-        if(!isTopPoint(point, *this) && !isLeftPoint(point, *this))
-            checkAround(modifyPoint(point, -1, -1));
-        if(!isBotPoint(point, *this) && !isRightPoint(point, *this))
-            checkAround(modifyPoint(point, +1, +1));
-        if(!isTopPoint(point, *this) && !isRightPoint(point, *this))
-            checkAround(modifyPoint(point, +1, -1));
-        if(!isBotPoint(point, *this) && !isLeftPoint(point, *this))
-            checkAround(modifyPoint(point, -1, +1));
-    }
-    else if(square != '.')
+    setupFloorTiles();
+    for(int i = 0; i <= 2; i++)
     {
-        visible[pos] = square;
-        around[pos] = 1;
+        cursor_uvs[i] = subtexUVs(cursor_images[i].subtex);
     }
-    else
-        around[pos] = 1;
+    crosshair_uvs = subtexUVs(crosshair_image.subtex);
+    wall_uvs = subtexUVs(wall_image.subtex);
 }
 
-void MineSweeper::reveal()
+MineSweeper::~MineSweeper()
 {
-    const int pos = XY_TO_IDX(looking_at_x, looking_at_y, this);
-    const char square = internal[pos];
-    visible[pos] = square;
-
-    if(square == ' ')
-    {
-        checkAround({looking_at_x, looking_at_y});
-    }
-
-    if(square == '.')
-    {
-        for(short y = 0; y < height; y++)
-        {
-            for(short x = 0; x < width; x++)
-            {
-                const int idx = XY_TO_IDX(x, y, this);
-                if(internal[idx] == '.')
-                    visible[idx] = '#';
-            }
-        }
-        should_update_cursor = false;
-        should_update_cursor_verts = false;
-        looking_at_floor = false;
-        dead = true;
-        end_time = osGetTime();
-        DEBUGPRINT("lose!\n");
-    }
-    else
-    {
-        for(int y = 0; y < height; y++)
-        {
-            const int posY = y * width;
-            for(int x = 0; x < width; x++)
-            {
-                const int posT = x + posY;
-                if(internal[posT] == '.' && (visible[posT] == '.' || visible[posT] == 'f')) // bomb and it's (not found) or (flagged)
-                {
-                    continue;
-                }
-                else if(internal[posT] != visible[posT]) // not revealed yet
-                {
-                    return;
-                }
-            }
-        }
-        should_update_cursor = false;
-        should_update_cursor_verts = false;
-        looking_at_floor = false;
-        win = true;
-        end_time = osGetTime();
-        DEBUGPRINT("win!\n");
-    }
+    C2D_TextBufDelete(profile_text);
 }
 
-void MineSweeper::placeFlag()
+// Draws the last digits digits of value, leading zeros included, every one step pixels to the right of the last
+static void drawDigits(const C2D_Image* numbers, int value, int digits, float x, float y, float depth, float step, float scale)
 {
-    const int pos = XY_TO_IDX(looking_at_x, looking_at_y, this);
-    if(visible[pos] == '.')
-    {
-        visible[pos] = 'f';
-        flags_count++;
-    }
-    else if(visible[pos] == 'f')
+    for(int digit = digits - 1; digit >= 0; digit--)
     {
-        visible[pos] = '.';
-        flags_count--;
-    }
-}
-
-using SubtexUVFPtr = void(*)(const Tex3DS_SubTexture*, float*, float*);
-static constexpr SubtexUVFPtr subtex_uv_funcs[6] = {
-    &Tex3DS_SubTextureBottomRight,
-    &Tex3DS_SubTextureBottomLeft,
-    &Tex3DS_SubTextureTopRight,
-    &Tex3DS_SubTextureBottomLeft,
-    &Tex3DS_SubTextureTopLeft,
-    &Tex3DS_SubTextureTopRight,
-};
-
-void MineSweeper::lookDir(float x, float y)
-{
-    angleX += x;
-    angleY += y_axis_inverted ? -y : y;
-    if(angleY < -90.0f)
-    {
-        angleY = -90.0f;
-    }
-    else if(angleY > 90.0f)
-    {
-        angleY = 90.0f;
-    }
-    
-    looking_at_floor = false;
-    should_update_cursor = false;
-    if(angleY < 0.0f)
-    {
-        should_update_cursor = true;
-    }
-}
-void MineSweeper::advance(float angle, float delta)
-{
-    const float c = cosf(C3D_AngleFromDegrees(angle));
-    const float s = sinf(C3D_AngleFromDegrees(angle));
-    C3D_FVec dir = FVec3_Scale(FVec3_New(c, 0.0f, s), delta);
-    C3D_FVec pos = FVec3_Add(FVec3_New(positionX, 0.0f, positionZ), dir);
-
-    const float mX = get_terrain_min_x();
-    const float mY = get_terrain_min_y();
-    constexpr float proximity = 0.5f;
-    if(pos.x <= (mX + proximity) || pos.x > (-mX - proximity) || pos.z <= (mY + proximity) || pos.z > (-mY - proximity)) return;
-    positionX = pos.x;
-    positionZ = pos.z;
-
-    looking_at_floor = false;
-    should_update_cursor = false;
-    if(angleY < 0.0f)
-    {
-        should_update_cursor = true;
+        C2D_DrawImageAt(numbers[value % 10], x + digit * step, y, depth, nullptr, scale, scale);
+        value /= 10;
     }
 }
 
@@ -386,13 +228,14 @@ void MineSweeper::renderGui()
             C2D_DrawImageAt(dead_image, x - 1, y - 1, 0.25f, &front_tint);
             return;
         }
+        // an endless level counts the squares opened instead of the bombs
         const C2D_Image* icons[2] = {
-            &bomb_image,
+            endless ? &open_image : &bomb_image,
             &flag_image,
         };
         int* parts[2] = {
-            &bombs,
-            &flags_count,
+            endless ? &endless_board.opened : &bombs,
+            endless ? &endless_board.flags_count : &board.flags_count,
         };
 
         int y = 0;
@@ -404,19 +247,19 @@ void MineSweeper::renderGui()
         y = icon_base_y;
         for(int i = 0; i < 2; i++)
         {
-            C2D_DrawImageAt(*(icons[i]), icon_base_x + (icon_w - icons[i]->subtex->width) / 2, y + (icon_h - icons[i]->subtex->height) / 2, 0.0f);
+            // green for as long as the board is one without guessing, the way the menu shows it
+            const bool tinted = no_guess && !endless && i == 0;
+            C2D_DrawImageAt(*(icons[i]), icon_base_x + (icon_w - icons[i]->subtex->width) / 2, y + (icon_h - icons[i]->subtex->height) / 2, 0.0f, tinted ? &no_guess_tint : nullptr);
             
             C2D_DrawImageAt(outline_image, icon_base_x + icon_w + 4 + 1, y + 1, 0.0f, &back_tint, 1.5f, 1.0f);
 
             C2D_DrawImageAt(outline_image, icon_base_x + icon_w + 4 - 1, y - 1, 0.25f, &front_tint, 1.5f, 1.0f);
 
-            div_t thousands = div(*(parts[i]), 1000);
-            div_t hundreds = div(thousands.rem, 100);
-            div_t smaller = div(hundreds.rem, 10);
-            C2D_DrawImageAt(numbers_images[thousands.quot], icon_base_x + icon_w + 20, y + (64 - 32)/2, 0.5f);
-            C2D_DrawImageAt(numbers_images[hundreds.quot], icon_base_x + icon_w + 20 + 26, y + (64 - 32)/2, 0.5f);
-            C2D_DrawImageAt(numbers_images[smaller.quot], icon_base_x + icon_w + 20 + 26 * 2, y + (64 - 32)/2, 0.5f);
-            C2D_DrawImageAt(numbers_images[smaller.rem], icon_base_x + icon_w + 20 + 26 * 3, y + (64 - 32)/2, 0.5f);
+            // huge boards have more bombs than 4 digits hold, both counters then get 6 smaller ones
+            if(!endless && bombs <= 9999)
+                drawDigits(numbers_images, *(parts[i]), 4, icon_base_x + icon_w + 20, y + (64 - 32)/2, 0.5f, 26.0f, 1.0f);
+            else
+                drawDigits(numbers_images, *(parts[i]), 6, icon_base_x + icon_w + 14, y + (64 - 24)/2, 0.5f, 20.0f, 0.75f);
 
             y += icon_padding_y + icon_h;
         }
@@ -453,7 +296,16 @@ void MineSweeper::renderGui()
         y = icon_base_y;
         for(int i = 0; i < 3; i++)
         {
-            C2D_DrawImageAt(*(icons[i]), icon_base_x + (icon_w - icons[i]->subtex->width) / 2, y + (icon_h - icons[i]->subtex->height) / 2, 0.0f);
+            // endless levels only have a percentage of bombs
+            if(endless && edit[i] != Editing::Bombs)
+            {
+                y += icon_padding_y + icon_h;
+                continue;
+            }
+
+            // the bomb icon turns green for boards without guessing
+            const bool tinted = no_guess && !endless && edit[i] == Editing::Bombs;
+            C2D_DrawImageAt(*(icons[i]), icon_base_x + (icon_w - icons[i]->subtex->width) / 2, y + (icon_h - icons[i]->subtex->height) / 2, 0.0f, tinted ? &no_guess_tint : nullptr);
             
             C2D_DrawImageAt(outline_image, icon_base_x + 2 + icon_w + 4, y + 2, 0.0f, &back_tint);
             // C2D_DrawImageAt(up_image, icon_base_x + 2 + icon_w + 4 + outline_w + 4, y + 2, 0.0f, &back_tint);
@@ -463,15 +315,22 @@ void MineSweeper::renderGui()
             // C2D_DrawImageAt(up_image, icon_base_x + icon_w + 4 + outline_w + 4, y, 0.25f, &front_tint);
             // C2D_DrawImageAt(down_image, icon_base_x + icon_w + 4 + outline_w + 4, y + arrow_h, 0.25f, &front_tint);
 
-            div_t vals = div(*(parts[i]), 10);
-            C2D_DrawImageAt(numbers_images[vals.quot], icon_base_x + icon_w + 4 + 16, y + (64 - 32)/2, 0.5f);
-            C2D_DrawImageAt(numbers_images[vals.rem], icon_base_x + icon_w + 4 + 16 + 32, y + (64 - 32)/2, 0.5f);
+            // sizes past 99 get smaller digits to fit in the outline
+            const int value = *(parts[i]);
+            if(value <= 99)
+                drawDigits(numbers_images, value, 2, icon_base_x + icon_w + 4 + 16, y + (64 - 32)/2, 0.5f, 32.0f, 1.0f);
+            else if(value <= 999)
+                drawDigits(numbers_images, value, 3, icon_base_x + icon_w + 4 + 16, y + (64 - 24)/2, 0.5f, 20.0f, 0.75f);
+            else
+                drawDigits(numbers_images, value, 4, icon_base_x + icon_w + 4 + 6, y + (64 - 24)/2, 0.5f, 20.0f, 0.75f);
 
             y += icon_padding_y + icon_h;
         }
 
         C2D_DrawImageAt(outline_image, ok_x + 2, ok_y + 2, 0.0f, &back_tint);
-        C2D_DrawImageAt(outline_image, ok_x, ok_y, 0.25f, Editing::Ok == selected_editing ? &selected_tint : &front_tint);
+        // the button blinks while the level is being made
+        const bool blink = preparing == Preparing::Level && (osGetTime() / 250) % 2;
+        C2D_DrawImageAt(outline_image, ok_x, ok_y, 0.25f, too_big ? &refused_tint : (Editing::Ok == selected_editing && !blink ? &selected_tint : &front_tint));
         C2D_DrawImageAt(ok_image, ok_x + (96 - 64)/2, ok_y + (64 - 32)/2, 0.5f, &front_tint);
     }
 }
@@ -482,557 +341,186 @@ void MineSweeper::renderLogo()
     C2D_DrawImageAt(logo_image, x, y, 0.0f);
 }
 
-void MineSweeper::updateFloor()
+void MineSweeper::renderProfile()
 {
-    auto vertices = LevelWide::get_floor_verts();
-
-    const float miny = get_terrain_min_y();
-    const float minx = get_terrain_min_x();
-    // const float maxy = -miny;
-    const float maxx = -minx;
-
-    constexpr float floor_dx[6] = {0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f};
-    constexpr float floor_dz[6] = {0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f};
-    
-    // planes offset vertically
-    constexpr float floor_dy[2] = {
-        0.0f,
-        0.0625f/8.0f,
+    // a phase a row, over the rest of the bottom screen: the shortest, average and 99th percentile of the frames kept
+    constexpr float columns[3] = {128.0f, 184.0f, 240.0f};
+    constexpr float row = 18.0f;
+    const u32 color = C2D_Color32(0xFF, 0xFF, 0xFF, 0xFF);
+    C2D_DrawRectSolid(0.0f, 0.0f, 0.875f, 320.0f, 240.0f, C2D_Color32(0x00, 0x00, 0x00, 0xC0));
+    C2D_TextBufClear(profile_text);
+    const auto draw = [&](const char* string, float x, float y) {
+        C2D_Text text;
+        C2D_TextParse(&text, profile_text, string);
+        C2D_TextOptimize(&text);
+        C2D_DrawText(&text, C2D_WithColor, x, y, 0.9375f, 0.5f, 0.5f, color);
     };
 
-    // outer: {bottom layer, top layer}
-    // inner: {vert 0 1 2 3 0 2 3}
-    float vs[6 + 8][6];
-    float us[6 + 8][6];
-    const Tex3DS_SubTexture* subtexes[6 + 8] = {
-        hidden_image.subtex,
-        open_image.subtex,
-        red_image.subtex,
-        empty_image.subtex,
-        bomb_image.subtex,
-        flag_image.subtex,
-    };
-    for(int i = 1; i <= 8; i++)
+    char line[32];
+    snprintf(line, sizeof(line), "%d frames, us", Profile::frames());
+    draw(line, 8.0f, 8.0f);
+    draw("min", columns[0], 8.0f);
+    draw("avg", columns[1], 8.0f);
+    draw("99%", columns[2], 8.0f);
+    for(int phase = 0; phase < Profile::PHASES; phase++)
     {
-        subtexes[i + 5] = numbers_images[i].subtex;
-    }
-    for(int typ = 0; typ < (6+8); typ++)
-    {
-        auto sub = subtexes[typ];
-        for(int vert = 0; vert < 6; vert++)
+        const float y = 8.0f + row * (phase + 1);
+        const Profile::Summary summary = Profile::summarize(Profile::Phase(phase));
+        draw(Profile::names[phase], 8.0f, y);
+        const double values[3] = {summary.min, summary.avg, summary.p99};
+        for(int column = 0; column < 3; column++)
         {
-            subtex_uv_funcs[vert](sub, &us[typ][vert], &vs[typ][vert]);
+            snprintf(line, sizeof(line), "%.0f", values[column]);
+            draw(line, columns[column], y);
         }
     }
-
-    size_t idx = floor_idx;
-    const size_t layer_size = width * height;
-    C3D_FVec normal_floor_up = FVec3_New(0.0f, 1.0f, 0.0f);
-    for(size_t layer = 0; layer < 2; layer++)
-    {
-        float x = minx;
-        float y = miny;
-        for(size_t square = 0; square < layer_size; square++)
-        {
-            int subtex_idx = -1;
-            if(layer == 0)
-            {
-                if(visible[square] == '.')
-                    subtex_idx = 0;
-                else if(visible[square] == 'f')
-                    subtex_idx = 0;
-                else if(visible[square] == '#')
-                    subtex_idx = 2;
-                else
-                    subtex_idx = 1;
-            }
-            else
-            {
-                if(visible[square] == '.' || visible[square] == ' ')
-                    subtex_idx = 3;
-                else if(visible[square] == '#')
-                    subtex_idx = 4;
-                else if(visible[square] == 'f')
-                    subtex_idx = 5;
-                else
-                    subtex_idx = 6 + (visible[square] - '1');
-            }
-            for(size_t vert = 0; vert < 6; vert++)
-            {
-                C3D_FVec pos = FVec3_New(x + floor_dx[vert], -1.0f + floor_dy[layer], y + floor_dz[vert]);
-                Vertex v(pos, us[subtex_idx][vert], vs[subtex_idx][vert], normal_floor_up);
-                vertices[idx] = v;
-                idx++;
-            }
-
-            x += 1.0f;
-            if(x >= maxx)
-            {
-                x = minx;
-                y += 1.0f;
-            }
-        }
-    }
-}
-
-void MineSweeper::updateCursorUVAndPos(Vertex* store_in)
-{
-    float cursor_u[6];
-    float cursor_v[6];
-    const Tex3DS_SubTexture* cursor_subtex = cursor_images[cursor_frame].subtex;
-    for(int vert = 0; vert < 6; vert++)
-    {
-        subtex_uv_funcs[vert](cursor_subtex, &cursor_u[vert], &cursor_v[vert]);
-    }
-
-    const float miny = get_terrain_min_y();
-    const float minx = get_terrain_min_x();
-
-    constexpr float cursor_dx[6] = {0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f};
-    constexpr float cursor_dz[6] = {0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f};
-
-    C3D_FVec normal_up = FVec3_New(0.0f, 1.0f, 0.0f);
-    const float x = miny + float(looking_at_x);
-    const float y = miny + float(looking_at_y);
-    for(size_t vert = 0; vert < 6; vert++)
-    {
-        C3D_FVec pos = FVec3_New(x + cursor_dx[vert], -1.0f + (0.0625f/4.0f), y + cursor_dz[vert]);
-        Vertex v(pos, cursor_u[vert], cursor_v[vert], normal_up);
-        store_in[vert] = v;
-    }
+    // and how busy the last frame kept the CPU and the GPU, in percent of a frame
+    snprintf(line, sizeof(line), "CPU %.0f%%  GPU %.0f%%", C3D_GetProcessingTime() * 6.0f, C3D_GetDrawingTime() * 6.0f);
+    draw(line, 8.0f, 8.0f + row * (Profile::PHASES + 1));
 }
 
-void MineSweeper::updateCursorLookingAt()
+void MineSweeper::setupFloorTiles()
 {
-    const float miny = get_terrain_min_y();
-    const float minx = get_terrain_min_x();
-    C3D_FVec camera_pos_vec = FVec3_New(positionX, 0.0f, positionZ);
-    C3D_FVec floor_normal_vec = FVec3_New(0.0f, 1.0f, 0.0f);
-    C3D_FVec floor_pos_vec = FVec3_New(0.0f, -1.0f, 0.0f);
-    C3D_FVec camera_dir_vec = FVec3_Normalize(FVec3_New(
-        cosf(C3D_AngleFromDegrees(angleX))*cosf(C3D_AngleFromDegrees(angleY)),
-        sinf(C3D_AngleFromDegrees(angleY)),
-        sinf(C3D_AngleFromDegrees(angleX))*cosf(C3D_AngleFromDegrees(angleY))
-    ));
-    float dot = FVec3_Dot(floor_normal_vec, camera_dir_vec);
-    if(dot != 0.0f)
+    // {base, overlay} of every floor tile
+    const Tex3DS_SubTexture* tiles[FLOOR_TILES][2] = {
+        {hidden_image.subtex, empty_image.subtex},
+        {hidden_image.subtex, flag_image.subtex},
+        {red_image.subtex, bomb_image.subtex},
+        {open_image.subtex, empty_image.subtex},
+    };
+    for(int i = 1; i <= 8; i++)
     {
-        float dist = FVec3_Dot(floor_normal_vec, FVec3_Subtract(floor_pos_vec, camera_pos_vec)) / dot;
-        if(dist <= 3.16f)
-        {
-            C3D_FVec endpoint = FVec3_Add(camera_pos_vec, FVec3_Scale(camera_dir_vec, dist));
-            int x = width - int(endpoint.x - minx) - 1;
-            int y = height - int(endpoint.z - miny) - 1;
-            int total = x + y * width;
-
-            if(x < 0 || y < 0 || total < 0 || x >= width || y >= height) return;
-
-            looking_at_floor = true;
-            if(x == looking_at_x && y == looking_at_y) return;
-
-            framectr = 0;
-            cursor_frame = 0;
-            cursor_frame_dir = 1;
-            looking_at_x = x;
-            looking_at_y = y;
-            should_update_cursor_verts = true;
-        }
+        tiles[FLOOR_NUMBERS + i - 1][0] = open_image.subtex;
+        tiles[FLOOR_NUMBERS + i - 1][1] = numbers_images[i].subtex;
     }
+    ProgramWide::composeFloorTiles(tiles, FLOOR_TILES, FLOOR_REPEATING);
 }
 
-void MineSweeper::generateCrosshair()
+bool MineSweeper::prepareLevel()
 {
-    auto vertices = LevelWide::get_crosshair_verts();
-
-    constexpr float crosshair_dx[6] = {0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f};
-    constexpr float crosshair_dy[6] = {0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f};
-
-    float crosshair_u[6];
-    float crosshair_v[6];
-    const Tex3DS_SubTexture* cross_subtex = crosshair_image.subtex;
-    for(int vert = 0; vert < 6; vert++)
-    {
-        subtex_uv_funcs[vert](cross_subtex, &crosshair_u[vert], &crosshair_v[vert]);
-    }
-    C3D_FVec normal_camera = FVec3_New(0.0f, 0.0f, 1.0f);
-    for(size_t vert = 0; vert < 6; vert++)
-    {
-        C3D_FVec pos = FVec3_New((crosshair_dx[vert] - 1.0f + 0.5f) / 16.0f, ((crosshair_dy[vert] - 0.5f) / 16.0f), -0.5f);
-        Vertex v(pos, crosshair_u[vert], crosshair_v[vert], normal_camera);
-
-        vertices[6 - vert - 1] = v;
-    }
+    // the buffer is made here, what goes in it on the worker, while the menu stays up
+    if(!LevelWide::init(Mesh::window(width, height, get_board_x(), get_board_y())))
+        return false;
+    prepare(LevelWide::get_vertices(), LevelWide::get_layout());
+    return true;
 }
 
-void MineSweeper::generateCursor()
+bool MineSweeper::levelFits()
 {
-    updateCursorUVAndPos(LevelWide::get_cursor_verts());
+    const Budget::Level level = endless ? Budget::endless() : Budget::level(width, height, no_guess);
+    // what's left of the heap: never handed to malloc yet, or given back to it
+    const struct mallinfo heap = mallinfo();
+    const size_t heap_free = __ctru_heap_size - heap.arena + heap.fordblks;
+    // the geometry goes where LevelWide reserved, unless it couldn't
+    const bool linear_fits = level.linear <= LevelWide::reserved() || level.linear + LINEAR_SLACK <= linearSpaceFree();
+    return level.heap + HEAP_SLACK <= heap_free && linear_fits;
 }
 
-void MineSweeper::generateFloorLayers(size_t layer_size)
+void MineSweeper::save()
 {
-    auto vertices = LevelWide::get_floor_verts();
-    const float miny = get_terrain_min_y();
-    const float minx = get_terrain_min_x();
-    // const float maxy = -miny;
-    const float maxx = -minx;
-
-    constexpr float floor_dx[6] = {0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f};
-    constexpr float floor_dz[6] = {0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f};
-    
-    // planes offset vertically
-    constexpr float floor_dy[2] = {
-        0.0f,
-        0.0625f/8.0f,
-    };
-
-    // outer: {bottom layer, top layer}
-    // inner: {vert 0 1 2 3 0 2 3}
-    float us[2][6];
-    float vs[2][6];
-    const Tex3DS_SubTexture* subtexes[2] = {
-        hidden_image.subtex,
-        empty_image.subtex,
-    };
-    for(int layer = 0; layer < 2; layer++)
-    {
-        auto sub = subtexes[layer];
-        for(int vert = 0; vert < 6; vert++)
-        {
-            subtex_uv_funcs[vert](sub, &us[layer][vert], &vs[layer][vert]);
-        }
+    // what the job did is only picked up by the next update, for the level and its trace to see it on the frame it happened
+    // (see Replay): saved tells a waited for job from a finished one
+    worker.wait();
+    const bool level = playing || preparing == Preparing::Level;
+    const bool ended = dead || win || (preparing == Preparing::Bombs && first_outcome != Board::Outcome::Playing);
+    if(!level || ended)
+    {
+        remove(SAVE_PATH);
+        return;
     }
 
-    size_t idx = 0;
-    const C3D_FVec normal_floor_up = FVec3_New(0.0f, 1.0f, 0.0f);
-    for(size_t layer = 0; layer < 2; layer++)
-    {
-        float x = minx;
-        float y = miny;
-        for(size_t square = 0; square < layer_size; square++)
-        {
-            for(size_t vert = 0; vert < 6; vert++)
-            {
-                C3D_FVec pos = FVec3_New(x + floor_dx[vert], -1.0f + floor_dy[layer], y + floor_dz[vert]);
-                Vertex v(pos, us[layer][vert], vs[layer][vert], normal_floor_up);
-                vertices[idx] = v;
-                idx++;
-            }
-
-            x += 1.0f;
-            if(x >= maxx)
-            {
-                x = minx;
-                y += 1.0f;
-            }
-        }
-    }
+    mkdir(SAVE_DIRECTORY, 0777);
+    const u64 start = osGetTime();
+    if(Save::writeFile(SAVE_PATH, saved(), board, endless_board))
+        DEBUGPRINT("saved in %llu ms\n", osGetTime() - start);
+    else
+        DEBUGPRINT("couldn't save to %s\n", SAVE_PATH);
 }
 
-void MineSweeper::generateWalls()
+bool MineSweeper::resume()
 {
-    auto vertices = LevelWide::get_wall_verts();
-    const float miny = get_terrain_min_y();
-    const float minx = get_terrain_min_x();
-    const float maxy = -miny;
-    const float maxx = -minx;
-
-    constexpr float wall_deltadir[6] = {0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f};
-    constexpr float wall_dy[6] = {0.0f, 0.0f, 2.0f, 0.0f, 2.0f, 2.0f};
-
-    float wall_u[6];
-    float wall_v[6];
-    const Tex3DS_SubTexture* wall_subtex = wall_image.subtex;
-    for(int vert = 0; vert < 6; vert++)
+    Save::Game game;
+    if(!Save::readFile(SAVE_PATH, game, board, endless_board, Mesh::WINDOW_SIZE))
     {
-        subtex_uv_funcs[vert](wall_subtex, &wall_u[vert], &wall_v[vert]);
+        board = Board();
+        endless_board = Endless();
+        return false;
     }
 
-    const C3D_FVec normal_wall_at_left = FVec3_New(+1.0f, 0.0f, 0.0f);
-    const C3D_FVec normal_wall_at_right = FVec3_New(-1.0f, 0.0f, 0.0f);
-    const C3D_FVec normal_wall_at_top = FVec3_New(0.0f, 0.0f, +1.0f);
-    const C3D_FVec normal_wall_at_bottom = FVec3_New(0.0f, 0.0f, -1.0f);
-
-    size_t idx = 0;
-    for(int i = 0; i < width; i++)
+    restore(game);
+    if(!endless)
     {
-        const float x = float(i) + minx;
-        for(size_t vert = 0; vert < 6; vert++)
-        {
-            C3D_FVec poshi = FVec3_New(x + wall_deltadir[6 - vert - 1], -1.0f + wall_dy[6 - vert - 1], miny + 0.0625f/4.0f);
-            C3D_FVec poslo = FVec3_New(x + wall_deltadir[vert], -1.0f + wall_dy[vert], maxy - 0.0625f/4.0f);
-
-            Vertex hi(poshi, wall_u[6 - vert - 1], wall_v[6 - vert - 1], normal_wall_at_top);
-            Vertex lo(poslo, wall_u[vert], wall_v[vert], normal_wall_at_bottom);
-
-            vertices[idx + 0 + ((3 + vert) % 6)] = hi;
-            vertices[idx + 6 + vert] = lo;
-        }
-        idx += 12;
+        menu_width = width;
+        menu_height = height;
     }
-
-    for(int i = 0; i < height; i++)
+    menu_no_guess = no_guess;
+    if(!prepareLevel())
     {
-        const float y = float(i) + miny;
-        for(size_t vert = 0; vert < 6; vert++)
-        {
-            C3D_FVec poshi = FVec3_New(minx + 0.0625f/4.0f, -1.0f + wall_dy[vert], y + wall_deltadir[vert]);
-            C3D_FVec poslo = FVec3_New(maxx - 0.0625f/4.0f, -1.0f + wall_dy[6 - vert - 1], y + wall_deltadir[6 - vert - 1]);
-            
-            Vertex hi(poshi, wall_u[vert], wall_v[vert], normal_wall_at_left);
-            Vertex lo(poslo, wall_u[6 - vert - 1], wall_v[6 - vert - 1], normal_wall_at_right);
-            
-            vertices[idx + 0 + ((3 + vert) % 6)] = hi;
-            vertices[idx + 6 + vert] = lo;
-        }
-        idx += 12;
+        DEBUGPRINT("the saved %dx%d doesn't fit in linear memory\n", width, height);
+        width = menu_width;
+        height = menu_height;
+        board = Board();
+        endless_board = Endless();
+        return false;
     }
+    return true;
 }
 
-void MineSweeper::generateVertices()
+void MineSweeper::writeTrace()
 {
-    const float miny = get_terrain_min_y();
-    const float minx = get_terrain_min_x();
-    // const float maxy = -miny;
-    // const float maxx = -minx;
-    const size_t layer_size = width * height;
-    const size_t vert_count = (1 + 1 + (width * 2 + height * 2) + layer_size * 2) * 6;
-
-    LevelWide::init(vert_count, width, height);
-
-    generateCrosshair();
-    generateCursor();
+    mkdir(SAVE_DIRECTORY, 0777);
+    if(!Replay::writeFile(TRACE_PATH, trace))
+        DEBUGPRINT("couldn't write %s\n", TRACE_PATH);
+}
 
-    generateFloorLayers(layer_size);
-    generateWalls();
+void MineSweeper::writeProfile()
+{
+    mkdir(SAVE_DIRECTORY, 0777);
+    if(!Profile::writeCsvFile(PROFILE_PATH))
+        DEBUGPRINT("couldn't write %s\n", PROFILE_PATH);
 }
 
-void MineSweeper::update(u32 kDown, u32 kHeld, touchPosition touch)  
+void MineSweeper::update(u32 kDown, u32 kHeld, touchPosition touch)
 {
-    if(in_controls)
+    const Frame frame = {kDown, kHeld, touch.px, touch.py, worker.done()};
+    if(preparing == Preparing::Level && frame.worker_done)
     {
-        if(kDown & KEY_UP)
-        {
-            switch(editing_control_type)
-            {
-                case EditingControls::ABXY:
-                {
-                    editing_control_type = EditingControls::Sensitivity;
-                }
-                break;
-                case EditingControls::DPAD:
-                {
-                    editing_control_type = EditingControls::ABXY;
-                }
-                break;
-                case EditingControls::YAxis:
-                {
-                    editing_control_type = EditingControls::DPAD;
-                }
-                break;
-                case EditingControls::Sensitivity:
-                {
-                    editing_control_type = EditingControls::YAxis;
-                }
-                break;
-            }
-        }
-        else if(kDown & KEY_DOWN)
-        {
-            switch(editing_control_type)
-            {
-                case EditingControls::ABXY:
-                {
-                    editing_control_type = EditingControls::DPAD;
-                }
-                break;
-                case EditingControls::DPAD:
-                {
-                    editing_control_type = EditingControls::YAxis;
-                }
-                break;
-                case EditingControls::YAxis:
-                {
-                    editing_control_type = EditingControls::Sensitivity;
-                }
-                break;
-                case EditingControls::Sensitivity:
-                {
-                    editing_control_type = EditingControls::ABXY;
-                }
-                break;
-            }
-        }
-        else if(kDown & KEY_LEFT)
-        {
-            switch(editing_control_type)
-            {
-                case EditingControls::ABXY:
-                {
-                    abxy_look = !abxy_look;
-                }
-                break;
-                case EditingControls::DPAD:
-                {
-                    dpad_look = !dpad_look;
-                }
-                break;
-                case EditingControls::YAxis:
-                {
-                    y_axis_inverted = !y_axis_inverted;
-                }
-                break;
-                case EditingControls::Sensitivity:
-                {
-                    rotate_speed_factor -= 0.125f;
-                    if(rotate_speed_factor < 0.0f)
-                    {
-                        rotate_speed_factor = 0.0f;
-                    }
-                }
-                break;
-            }
-        }
-        else if(kDown & KEY_RIGHT)
-        {
-            switch(editing_control_type)
-            {
-                case EditingControls::ABXY:
-                {
-                    abxy_look = !abxy_look;
-                }
-                break;
-                case EditingControls::DPAD:
-                {
-                    dpad_look = !dpad_look;
-                }
-                break;
-                case EditingControls::YAxis:
-                {
-                    y_axis_inverted = !y_axis_inverted;
-                }
-                break;
-                case EditingControls::Sensitivity:
-                {
-                    rotate_speed_factor += 0.125f;
-                    if(rotate_speed_factor > 3.0f)
-                    {
-                        rotate_speed_factor = 3.0f;
-                    }
-                }
-                break;
-            }
-        }
+        finishPreparing();
+        gfxSet3D(true); // Enable stereoscopic 3D when in level
+        Replay::begin(trace, *this);
     }
-    else if(playing)
-    {
-        if((kDown | kHeld) & getLookLeftKeys())
-        {
-            lookLeft(ROTATE_SPEED);
-        }
-        else if((kDown | kHeld) & getLookRightKeys())
-        {
-            lookRight(ROTATE_SPEED);
-        }
-        else if((kDown | kHeld) & getLookUpKeys())
-        {
-            lookUp(ROTATE_SPEED);
-        }
-        else if((kDown | kHeld) & getLookDownKeys())
-        {
-            lookDown(ROTATE_SPEED);
-        }
-
-        if((kDown | kHeld) & getMoveForwardKeys()) // move forward
-        {
-            goForward(MOVEMENT_SPEED);
-        }
-        else if((kDown | kHeld) & getMoveLeftKeys()) // move left
-        {
-            goLeft(MOVEMENT_SPEED);
-        }
-        else if((kDown | kHeld) & getMoveRightKeys()) // move right
-        {
-            goRight(MOVEMENT_SPEED);
-        }
-        else if((kDown | kHeld) & getMoveBackwardsKeys()) // move backwards
-        {
-            goBackwards(MOVEMENT_SPEED);
-        }
 
-        if(dead || win)
-        {
-            should_update_cursor = false;
-            if((end_time + 500ULL) <= osGetTime() && kDown & (KEY_L | KEY_R))
-            {
-                gfxSet3D(false); // Disable stereoscopic 3D when in menu
-                LevelWide::exit();
-                playing = false;
-            }
-        }
-        else if(looking_at_floor)
-        {
-            if(kDown & KEY_L) // place a fLag
-            {
-                if(generated)
-                {
-                    placeFlag();
-                    floor_changed = true;
-                }
-            }
-            else if(kDown & KEY_R) // Reveal a square
-            {
-                if(!generated)
-                {
-                    generateBombs();
-                    generated = true;
-                }
-                
-                const int pos = XY_TO_IDX(looking_at_x, looking_at_y, this);
-                if(visible[pos] != 'f')
-                {
-                    reveal();
-                    floor_changed = true;
-                }
-            }
-        }
-
-        if(should_update_cursor)
+    // the level and the controls settings are the rules' own, see Play
+    if(playing || in_controls || (kDown & KEY_SELECT))
+    {
+        const bool was_playing = playing;
+        const bool was_generated = generated;
+        Play::update(frame);
+        if(was_playing)
+            Replay::record(trace, frame, *this);
+        if(generated && !was_generated)
+            DEBUGPRINT("seed: %016llx\n", board.seed);
+        if(window_moved)
         {
-            updateCursorLookingAt();
-            should_update_cursor = false;
+            LevelWide::move(window);
+            window_moved = false;
         }
-
-        if(looking_at_floor)
+        if(was_playing && !playing)
         {
-            framectr++;
-            if(framectr % 30 == 0)
+            gfxSet3D(false); // Disable stereoscopic 3D when in menu
+            LevelWide::exit();
+            writeTrace();
+            no_guess = menu_no_guess;
+            if(endless)
             {
-                framectr = 0;
-                cursor_frame += cursor_frame_dir;
-                if(cursor_frame == 2)
-                {
-                    cursor_frame_dir = -1;
-                }
-                else if(cursor_frame == 0)
-                {
-                    cursor_frame_dir = 1;
-                }
-                should_update_cursor_verts = true;
+                width = menu_width;
+                height = menu_height;
             }
         }
-
-        if(should_update_cursor_verts)
-        {
-            updateCursorUVAndPos(LevelWide::get_cursor_verts());
-            should_update_cursor_verts = false;
-        }
-
-        if(floor_changed)
-        {
-            updateFloor();
-            floor_changed = false;
-        }
+    }
+    else if(preparing == Preparing::Level)
+    {
+        // the menu waits for the level
     }
     else
     {
@@ -1040,42 +528,64 @@ void MineSweeper::update(u32 kDown, u32 kHeld, touchPosition touch)
         {
             if(selected_editing == Editing::Ok)
             {
-                gfxSet3D(true); // Enable stereoscopic 3D when in level
-                playing = true;
-                floor_changed = false;
-                looking_at_floor = false;
-                should_update_cursor = false;
-                should_update_cursor_verts = false;
-                generated = false;
-                cursor_frame = 0;
-                cursor_frame_dir = 1;
-                framectr = 0;
-                flags_count = 0;
-                dead = false;
-                win = false;
-                angleX = 0.0f;
-                angleY = 0.0f;
-                positionX = 0.0f;
-                positionZ = 0.0f;
-                bombs = bombpercent * width * height / 100;
-                generateVertices();
+                // the last level's board goes first, so that the memory it held counts as free
+                board = Board();
+                endless_board = Endless();
+                dirty_squares = std::vector<int>();
+                trace = Replay::Trace();
+                if(!levelFits())
+                {
+                    too_big = true;
+                    DEBUGPRINT("%dx%d doesn't fit in memory\n", width, height);
+                }
+                else
+                {
+                    menu_width = width;
+                    menu_height = height;
+                    menu_no_guess = no_guess;
+                    setUpLevel();
+                    if(endless)
+                        DEBUGPRINT("endless seed: %016llx\n", endless_board.seed);
+                    if(!prepareLevel())
+                    {
+                        too_big = true;
+                        width = menu_width;
+                        height = menu_height;
+                        DEBUGPRINT("%dx%d doesn't fit in linear memory\n", width, height);
+                    }
+                }
             }
             else selected_editing = Editing::Ok;
         }
+        else if(kDown & (KEY_L | KEY_R))
+        {
+            // endless levels have no size to edit
+            too_big = false;
+            endless = !endless;
+            if(endless && (selected_editing == Editing::Width || selected_editing == Editing::Height))
+                selected_editing = Editing::Bombs;
+        }
         else if(kDown & KEY_X)
         {
-            selected_editing = Editing::Width;
+            if(!endless) selected_editing = Editing::Width;
         }
         else if(kDown & KEY_Y)
         {
-            selected_editing = Editing::Height;
+            if(!endless) selected_editing = Editing::Height;
         }
         else if(kDown & KEY_B)
         {
+            // B again on the bombs switches boards without guessing on and off, endless levels can't have them
+            if(selected_editing == Editing::Bombs && !endless)
+            {
+                too_big = false;
+                no_guess = !no_guess;
+            }
             selected_editing = Editing::Bombs;
         }
         else if(kDown & KEY_UP)
         {
+            too_big = false;
             switch(selected_editing)
             {
                 case Editing::Width:
@@ -1099,6 +609,7 @@ void MineSweeper::update(u32 kDown, u32 kHeld, touchPosition touch)
         }
         else if(kDown & KEY_DOWN)
         {
+            too_big = false;
             switch(selected_editing)
             {
                 case Editing::Width:
@@ -1122,16 +633,17 @@ void MineSweeper::update(u32 kDown, u32 kHeld, touchPosition touch)
         }
         else if(kDown & KEY_LEFT)
         {
+            too_big = false;
             switch(selected_editing)
             {
                 case Editing::Width:
                 {
-                    if(width <= (MAX_SZ - 10)) width += 10;
+                    width = sizeStep(width, 1);
                 }
                 break;
                 case Editing::Height:
                 {
-                    if(height <= (MAX_SZ - 10)) height += 10;
+                    height = sizeStep(height, 1);
                 }
                 break;
                 case Editing::Bombs:
@@ -1145,16 +657,17 @@ void MineSweeper::update(u32 kDown, u32 kHeld, touchPosition touch)
         }
         else if(kDown & KEY_RIGHT)
         {
+            too_big = false;
             switch(selected_editing)
             {
                 case Editing::Width:
                 {
-                    if(width >= (MIN_SZ + 10)) width -= 10;
+                    width = sizeStep(width, -1);
                 }
                 break;
                 case Editing::Height:
                 {
-                    if(height >= (MIN_SZ + 10)) height -= 10;
+                    height = sizeStep(height, -1);
                 }
                 break;
                 case Editing::Bombs:
@@ -3,25 +3,26 @@
 #include "common.h"
 
 #include "verts.h"
+#include "play.h"
+#include "replay.h"
 
 #include <citro2d.h>
 #include <tex3ds.h>
 
-typedef struct {
-    short x, y;
-} Coord;
-
-#define ROTATE_SPEED (rotate_speed_factor * ROTATE_SPEED_BASE)
-
-struct MineSweeper {
+// The level edition menu, and what a level needs the 3DS for: memory for its geometry, drawing it, and keeping it on the SD card
+struct MineSweeper : Play {
     static constexpr short MIN_SZ = 10;
-    static constexpr short MAX_SZ = 99;
+    // past the size of a window (see Mesh::window), only the part of the board around the player has geometry
+    static constexpr short MAX_SZ = 1000;
     static constexpr int MIN_BOMBS_PERCENT = 10;
     static constexpr int MAX_BOMBS_PERCENT = 40;
-
-    static constexpr float ROTATE_SPEED_BASE = 0.75f;
-    static constexpr float ROTATE_SPEED_BASE_FACTOR = 1.0f;
-    static constexpr float MOVEMENT_SPEED = 0.125f/2.75f;
+    // the game in progress when the program was left, see save and resume
+    static constexpr const char* SAVE_DIRECTORY = "sdmc:/3ds/MineSweeper3D";
+    static constexpr const char* SAVE_PATH = "sdmc:/3ds/MineSweeper3D/save.bin";
+    // the frames of the last level played, see Replay
+    static constexpr const char* TRACE_PATH = "sdmc:/3ds/MineSweeper3D/last.trace";
+    // the timings of the last frames, see Profile and writeProfile
+    static constexpr const char* PROFILE_PATH = "sdmc:/3ds/MineSweeper3D/frames.csv";
 
     enum class Editing {
         Width,
@@ -30,47 +31,13 @@ struct MineSweeper {
         Ok,
     };
 
-    enum class EditingControls {
-        ABXY,
-        DPAD,
-        YAxis,
-        Sensitivity,
-    };
-    std::vector<char> internal, visible;
-    std::vector<signed char> around;
-
-    static constexpr size_t cursor_idx = 0, cursor_vert_count = 6;
-    size_t floor_idx;
-
-    short looking_at_x, looking_at_y;
-    int cursor_frame, cursor_frame_dir;
-    int framectr;
-
-    short width, height, bombpercent;
-    int bombs;
-    int flags_count;
-
+    short menu_width, menu_height; // what the level edition had, while an endless level uses width and height
+    bool menu_no_guess; // the same, while a level whose board needs guessing after all has no_guess cleared (see Play::generateBombs)
     Editing selected_editing;
-    float angleX, angleY;
-    float positionX, positionZ;
-    float rotate_speed_factor;
-
-    bool playing;
-    bool dead;
-    bool win;
-    bool looking_at_floor;
-    bool should_update_cursor;
-    bool should_update_cursor_verts;
-    bool floor_changed;
-    bool generated;
-    bool in_controls;
-
-    EditingControls editing_control_type;
-    bool abxy_look;
-    bool dpad_look;
-    bool y_axis_inverted;
-
-    u64 end_time;
+    bool too_big; // the last level asked for doesn't fit in memory, until the size changes
+    Replay::Trace trace;
+    bool show_profile; // over the bottom screen, see renderProfile
+    C2D_TextBuf profile_text;
 
     C2D_Image hidden_image,
               open_image,
@@ -102,121 +69,37 @@ struct MineSweeper {
     C2D_Image cursor_images[3];
     C2D_ImageTint back_tint,
                   front_tint,
-                  selected_tint;
-
-    float get_terrain_min_y()
-    {
-        return height/-2.0f;
-    }
-    float get_terrain_min_x()
-    {
-        return width/-2.0f;
-    }
+                  selected_tint,
+                  refused_tint,
+                  no_guess_tint;
 
     MineSweeper(C2D_SpriteSheet sheet);
-    u32 getKeysForFlag(bool flag, u32 abxy, u32 dpad)
-    {
-        u32 keys = 0;
-        if(abxy_look == flag)
-            keys |= abxy;
-        if(dpad_look == flag)
-            keys |= dpad;
-        return keys;
-    }
-
-    u32 getLookUpKeys()
-    {
-        return getKeysForFlag(true, KEY_X | KEY_CSTICK_UP, KEY_UP);
-    }
-    u32 getLookDownKeys()
-    {
-        return getKeysForFlag(true, KEY_B | KEY_CSTICK_DOWN, KEY_DOWN);
-    }
-    u32 getLookLeftKeys()
-    {
-        return getKeysForFlag(true, KEY_Y | KEY_CSTICK_LEFT, KEY_LEFT);
-    }
-    u32 getLookRightKeys()
-    {
-        return getKeysForFlag(true, KEY_A | KEY_CSTICK_RIGHT, KEY_RIGHT);
-    }
+    ~MineSweeper();
 
-    u32 getMoveForwardKeys()
-    {
-        return getKeysForFlag(false, KEY_X | KEY_CSTICK_UP, KEY_UP);
-    }
-    u32 getMoveBackwardsKeys()
-    {
-        return getKeysForFlag(false, KEY_B | KEY_CSTICK_DOWN, KEY_DOWN);
-    }
-    u32 getMoveLeftKeys()
-    {
-        return getKeysForFlag(false, KEY_Y | KEY_CSTICK_LEFT, KEY_LEFT);
-    }
-    u32 getMoveRightKeys()
-    {
-        return getKeysForFlag(false, KEY_A | KEY_CSTICK_RIGHT, KEY_RIGHT);
-    }
-
-    void generateBombs();
-    void checkAround(Coord point);
-    void reveal();
-    void placeFlag();
+    bool prepareLevel();
+    bool levelFits();
 
-    void generateCrosshair();
-    void generateCursor();
-    void generateFloorLayers(size_t layer_size);
-    void generateWalls();
-    void generateVertices();
+    // Writes the game being played to SAVE_PATH, or removes it when there's none (in the menu, or the game is over).
+    // Waits for the worker first, so it can be called at any time
+    void save();
+    // Picks up the game of SAVE_PATH where it was saved, false if there's none that can be played
+    bool resume();
+    // the trace of the level being played, or of the last one, to TRACE_PATH
+    void writeTrace();
+    // the frames Profile has kept, to PROFILE_PATH
+    void writeProfile();
 
-    void renderTerrain(float iod)
+    // camera is shared by both eyes
+    void renderTerrain(const Camera::Basis& camera, float iod)
     {
         ThreeD::bind();
-        ThreeD::draw(positionX, positionZ, angleX, angleY, looking_at_floor, iod);
+        ThreeD::draw(floor_mesh, positionX, positionZ, camera, looking_at_floor, iod);
     }
     void renderGui();
     void renderLogo();
+    void renderProfile();
 
-    void updateFloor();
-    void updateCursorUVAndPos(Vertex* store_in);
-    void updateCursorLookingAt();
+    void setupFloorTiles();
 
-    void lookDir(float x, float y);
-    void advance(float angle, float delta);
-
-    void goForward(float v)
-    {
-        advance(angleX, v);
-    }
-    void goBackwards(float v)
-    {
-        advance(angleX, -v);
-    }
-    void goLeft(float v)
-    {
-        advance(angleX - 90, v);
-    }
-    void goRight(float v)
-    {
-        advance(angleX - 90, -v);
-    }
-
-    void lookLeft(float v)
-    {
-        lookDir(-v, 0.0f);
-    }
-    void lookRight(float v)
-    {
-        lookDir(v, 0.0f);
-    }
-    void lookUp(float v)
-    {
-        lookDir(0.0f, v);
-    }
-    void lookDown(float v)
-    {
-        lookDir(0.0f, -v);
-    }
-    
     void update(u32 kDown, u32 kHeld, touchPosition touch);
 };
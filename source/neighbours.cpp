@@ -0,0 +1,142 @@
+#include "neighbours.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+    constexpr int VECTOR_SIZE = 16;
+
+    // four bits to four bytes of 0 or 1, lowest bit in the first byte (both the 3DS and the hosts are little endian)
+    constexpr uint32_t spread_nibble[16] = {
+        0x00000000, 0x00000001, 0x00000100, 0x00000101,
+        0x00010000, 0x00010001, 0x00010100, 0x00010101,
+        0x01000000, 0x01000001, 0x01000100, 0x01000101,
+        0x01010000, 0x01010001, 0x01010100, 0x01010101,
+    };
+
+    // a zero column on each side, rounded up so that every row is made of whole vectors
+    int paddedStride(int width)
+    {
+        return (width + 2 + VECTOR_SIZE - 1) & ~(VECTOR_SIZE - 1);
+    }
+
+    // dst[i] = a[i] + b[i] + c[i], for n bytes (a multiple of VECTOR_SIZE)
+    void add3Scalar(uint8_t* dst, const uint8_t* a, const uint8_t* b, const uint8_t* c, int n)
+    {
+        for(int i = 0; i < n; i += 4)
+        {
+            uint32_t wa, wb, wc;
+            memcpy(&wa, a + i, 4);
+            memcpy(&wb, b + i, 4);
+            memcpy(&wc, c + i, 4);
+            const uint32_t sum = wa + wb + wc;
+            memcpy(dst + i, &sum, 4);
+        }
+    }
+
+    void add3Vector(uint8_t* dst, const uint8_t* a, const uint8_t* b, const uint8_t* c, int n)
+    {
+#if defined(__SSE2__)
+        for(int i = 0; i < n; i += VECTOR_SIZE)
+        {
+            const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            const __m128i vc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_add_epi8(_mm_add_epi8(va, vb), vc));
+        }
+#elif defined(__ARM_NEON)
+        for(int i = 0; i < n; i += VECTOR_SIZE)
+        {
+            vst1q_u8(dst + i, vaddq_u8(vaddq_u8(vld1q_u8(a + i), vld1q_u8(b + i)), vld1q_u8(c + i)));
+        }
+#else
+        add3Scalar(dst, a, b, c, n);
+#endif
+    }
+
+    // Packs n counts into nibbles, starting at square first (which can be odd when the width is)
+    void packRow(const uint8_t* row, int n, uint8_t* counts, int first)
+    {
+        int i = 0;
+        if(first % 2)
+        {
+            counts[first / 2] = (counts[first / 2] & 0x0F) | (row[0] << 4);
+            i = 1;
+        }
+        // four counts at a time: folding each byte's high neighbour onto it leaves two packed bytes
+        for(; i + 3 < n; i += 4)
+        {
+            uint32_t word;
+            memcpy(&word, row + i, 4);
+            word |= word >> 4;
+            counts[(first + i) / 2] = uint8_t(word);
+            counts[(first + i) / 2 + 1] = uint8_t(word >> 16);
+        }
+        for(; i + 1 < n; i += 2)
+        {
+            counts[(first + i) / 2] = row[i] | (row[i + 1] << 4);
+        }
+        if(i < n)
+        {
+            counts[(first + i) / 2] = row[i];
+        }
+    }
+}
+
+size_t Neighbours::scratchSize(int width, int height)
+{
+    const int stride = paddedStride(width);
+    const int words = (width * height + 31) / 32;
+    // the plane as bytes, the bomb grid with a zero border, then the vertical sums of a row, then the full sums of a row;
+    // the last two get an extra vector so that reading one or two bytes past a row stays inside
+    return size_t(words) * 32 + size_t(height + 2) * stride + 2 * (stride + VECTOR_SIZE);
+}
+
+void Neighbours::count(const uint32_t* bits, int width, int height, uint8_t* counts, std::vector<uint8_t>& scratch, Kernel kernel)
+{
+    const int stride = paddedStride(width);
+    const int words = (width * height + 31) / 32;
+    const size_t flat_size = size_t(words) * 32;
+    const size_t grid_size = size_t(height + 2) * stride;
+    scratch.resize(scratchSize(width, height));
+    uint8_t* flat = scratch.data();
+    uint8_t* grid = flat + flat_size;
+    uint8_t* column_sums = grid + grid_size;
+    uint8_t* box_sums = column_sums + stride + VECTOR_SIZE;
+    memset(column_sums + stride, 0, VECTOR_SIZE);
+
+    for(int w = 0; w < words; w++)
+    {
+        const uint32_t word = bits[w];
+        for(int nibble = 0; nibble < 8; nibble++)
+        {
+            memcpy(flat + w * 32 + nibble * 4, &spread_nibble[(word >> (nibble * 4)) & 0xF], 4);
+        }
+    }
+
+    // rows are packed back to back in the plane, the grid gives them their border
+    memset(grid, 0, stride);
+    memset(grid + (height + 1) * stride, 0, stride);
+    for(int y = 0; y < height; y++)
+    {
+        uint8_t* row = grid + (y + 1) * stride;
+        row[0] = 0;
+        memcpy(row + 1, flat + y * width, width);
+        memset(row + 1 + width, 0, stride - 1 - width);
+    }
+
+    const auto add3 = kernel == Kernel::Vector ? &add3Vector : &add3Scalar;
+    for(int y = 0; y < height; y++)
+    {
+        const uint8_t* above = grid + y * stride;
+        add3(column_sums, above, above + stride, above + 2 * stride, stride);
+        // column_sums[0] is the column left of the row, so box_sums[x] is the box centered on x
+        add3(box_sums, column_sums, column_sums + 1, column_sums + 2, stride);
+        packRow(box_sums, width, counts, y * width);
+    }
+}
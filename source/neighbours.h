@@ -0,0 +1,30 @@
+#pragma once
+
+// Counts the bombs around every square of a board in one pass over its bomb plane:
+// the plane is spread to one byte per square, then each row is the sum of the 3x3 box around it.
+// No byte ever goes over 9, so the sums can't carry from one square into the next and
+// whole words or vectors of squares get added at once.
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Neighbours {
+    enum class Kernel {
+        Scalar, // 4 squares per 32-bit add, the ARM11 has no NEON
+        Vector, // 16 squares per SSE2 or NEON add, same as Scalar where neither is available
+    };
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    constexpr Kernel best_kernel = Kernel::Vector;
+#else
+    constexpr Kernel best_kernel = Kernel::Scalar;
+#endif
+
+    // bytes of scratch count() needs for a width x height board
+    size_t scratchSize(int width, int height);
+    // bits is a plane of width x height squares, square (x, y) being bit (x + y * width) (see Board).
+    // Fills counts with two squares per byte, even squares in the low nibble; a bomb counts itself.
+    // scratch only avoids allocating on every call.
+    void count(const uint32_t* bits, int width, int height, uint8_t* counts, std::vector<uint8_t>& scratch, Kernel kernel = best_kernel);
+};
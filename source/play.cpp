@@ -0,0 +1,766 @@
+#include "play.h"
+#include "culling.h"
+#include "profile.h"
+#include "rng.h"
+#include "solver.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+    #define XY_TO_IDX(x, y, m) ((x) + ((y) * (m)->width))
+
+    // Every floor tile ready to be copied, and the group it's drawn in, made by the compiler
+    struct FloorTiles {
+        Mesh::QuadTemplate tiles[Play::FLOOR_TILES];
+        int groups[Play::FLOOR_TILES];
+    };
+    constexpr FloorTiles makeFloorTiles()
+    {
+        FloorTiles floor = {};
+        for(int tile = 0; tile < Play::FLOOR_TILES; tile++)
+            floor.tiles[tile] = Mesh::floorTemplate(Mesh::floorTileUVs(tile, Play::FLOOR_TILES));
+        for(int repeating = 0; repeating < Mesh::REPEATING; repeating++)
+            floor.groups[Play::FLOOR_REPEATING[repeating]] = 1 + repeating;
+        return floor;
+    }
+    constexpr FloorTiles floor_tiles = makeFloorTiles();
+
+    // FNV-1a
+    struct Hash {
+        uint32_t value = 2166136261u;
+
+        void add(const void* data, size_t size)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            for(size_t i = 0; i < size; i++)
+                value = (value ^ bytes[i]) * 16777619u;
+        }
+        template<typename T>
+        void add(T field)
+        {
+            add(&field, sizeof(field));
+        }
+    };
+}
+
+Play::Play()
+:
+origin_x(0), origin_y(0),
+vertices(nullptr), window(0, 0), window_moved(false),
+looking_at_x(0), looking_at_y(0), cursor_frame(0), cursor_frame_dir(1), framectr(0),
+width(0), height(0), bombpercent(0), bombs(0),
+angleX(0.0f), angleY(0.0f), positionX(0.0f), positionZ(0.0f), rotate_speed_factor(ROTATE_SPEED_BASE_FACTOR),
+playing(false), dead(false), win(false), looking_at_floor(false), should_update_cursor(false), should_update_cursor_verts(false), floor_changed(false),
+generated(false), in_controls(false), endless(false), no_guess(false),
+editing_control_type(EditingControls::ABXY), abxy_look(false), dpad_look(true), y_axis_inverted(false),
+frames(0), end_frame(0), seed(0), preparing(Preparing::Nothing), first_reveal{0, 0}, first_outcome(Board::Outcome::Playing), first_guaranteed(true)
+{
+    memset(cursor_uvs, 0, sizeof(cursor_uvs));
+    memset(&crosshair_uvs, 0, sizeof(crosshair_uvs));
+    memset(&wall_uvs, 0, sizeof(wall_uvs));
+}
+
+bool Play::generateBombs(Coord first)
+{
+    const uint64_t board_seed = Rng::splitmix64(seed);
+    if(no_guess && NoGuess::generate(board, first, board_seed))
+        return true;
+    // what the generator gave up on may still need guessing: the plain board for the seed is played instead,
+    // the one a save without Save::Game::NO_GUESS comes back with
+    board.generateBombs(first, board_seed);
+    return !no_guess;
+}
+
+bool Play::isFlagged(short x, short y) const
+{
+    if(endless)
+    {
+        const Endless::Square square = endlessSquare(x, y);
+        return endless_board.isFlagged(square.x, square.y);
+    }
+    return board.isFlagged(XY_TO_IDX(x, y, this));
+}
+
+bool Play::isOpen(short x, short y) const
+{
+    if(endless)
+    {
+        const Endless::Square square = endlessSquare(x, y);
+        return endless_board.isOpen(square.x, square.y);
+    }
+    return board.isOpen(XY_TO_IDX(x, y, this));
+}
+
+Board::Outcome Play::revealAt(Coord point)
+{
+    const Board::Outcome outcome = endless ? endless_board.reveal(endlessSquare(point.x, point.y)) : board.reveal(point);
+    markRevealed();
+    return outcome;
+}
+
+Board::Outcome Play::chordAt(Coord point)
+{
+    const Board::Outcome outcome = endless ? endless_board.chord(endlessSquare(point.x, point.y)) : board.chord(point);
+    markRevealed();
+    return outcome;
+}
+
+void Play::markRevealed()
+{
+    // the rest of the board gets its tiles when the window moves over it
+    if(endless)
+    {
+        for(const Endless::Square& opened : endless_board.revealed)
+        {
+            const int square = XY_TO_IDX(opened.x - origin_x, opened.y - origin_y, this);
+            if(window.contains(square))
+                dirty_squares.push_back(square);
+        }
+    }
+    else
+    {
+        for(const int square : board.revealed)
+        {
+            if(window.contains(square))
+                dirty_squares.push_back(square);
+        }
+    }
+}
+
+void Play::ended(Board::Outcome outcome)
+{
+    if(outcome == Board::Outcome::Lost)
+    {
+        should_update_cursor = false;
+        should_update_cursor_verts = false;
+        looking_at_floor = false;
+        dead = true;
+        end_frame = frames;
+    }
+    else if(outcome == Board::Outcome::Won)
+    {
+        should_update_cursor = false;
+        should_update_cursor_verts = false;
+        looking_at_floor = false;
+        win = true;
+        end_frame = frames;
+    }
+}
+
+void Play::reveal()
+{
+    const Coord point = {looking_at_x, looking_at_y};
+    ended(isOpen(point.x, point.y) ? chordAt(point) : revealAt(point));
+}
+
+void Play::placeFlag()
+{
+    if(endless)
+        endless_board.placeFlag(endlessSquare(looking_at_x, looking_at_y));
+    else
+        board.placeFlag({looking_at_x, looking_at_y});
+    dirty_squares.push_back(XY_TO_IDX(looking_at_x, looking_at_y, this));
+}
+
+void Play::lookDir(float x, float y)
+{
+    angleX += x;
+    angleY += y_axis_inverted ? -y : y;
+    if(angleY < -90.0f)
+    {
+        angleY = -90.0f;
+    }
+    else if(angleY > 90.0f)
+    {
+        angleY = 90.0f;
+    }
+
+    looking_at_floor = false;
+    should_update_cursor = false;
+    if(angleY < 0.0f)
+    {
+        should_update_cursor = true;
+    }
+}
+void Play::advance(float dir_x, float dir_z, float delta)
+{
+    const float x = positionX + dir_x * delta;
+    const float z = positionZ + dir_z * delta;
+
+    const float mX = get_terrain_min_x();
+    const float mY = get_terrain_min_y();
+    constexpr float proximity = 0.5f;
+    if(x <= (mX + proximity) || x > (-mX - proximity) || z <= (mY + proximity) || z > (-mY - proximity)) return;
+    positionX = x;
+    positionZ = z;
+    if(endless && (fabsf(positionX) > ENDLESS_RECENTRE || fabsf(positionZ) > ENDLESS_RECENTRE))
+        recentre();
+    else if(preparing == Preparing::Nothing && !Mesh::covers(window, get_board_x(), get_board_y(), Culling::WINDOW_REACH))
+        moveWindow();
+
+    looking_at_floor = false;
+    should_update_cursor = false;
+    if(angleY < 0.0f)
+    {
+        should_update_cursor = true;
+    }
+}
+
+int Play::floorTileOf(int square) const
+{
+    if(endless)
+    {
+        const Endless::Square at = endlessSquare(square % width, square / width);
+        if(!endless_board.isOpen(at.x, at.y))
+            return endless_board.isFlagged(at.x, at.y) ? FLOOR_FLAGGED : FLOOR_HIDDEN;
+        else if(endless_board.isMine(at.x, at.y))
+            return FLOOR_EXPLODED;
+        else if(endless_board.count(at.x, at.y) == 0)
+            return FLOOR_OPEN;
+        else
+            return FLOOR_NUMBERS + endless_board.count(at.x, at.y) - 1;
+    }
+    else if(!board.isOpen(square))
+        return board.isFlagged(square) ? FLOOR_FLAGGED : FLOOR_HIDDEN;
+    else if(board.isMine(square))
+        return FLOOR_EXPLODED;
+    else if(board.count(square) == 0)
+        return FLOOR_OPEN;
+    else
+        return FLOOR_NUMBERS + board.count(square) - 1;
+}
+
+void Play::updateFloor()
+{
+    const Profile::Scope timed(Profile::Floor);
+    // only the chunks with squares that changed since the last update get meshed again
+    for(const int square : dirty_squares)
+        floor_mesh.set(square, floorTileOf(square));
+    floor_mesh.update(vertices, floor_tiles.tiles, floor_tiles.groups);
+    dirty_squares.clear();
+}
+
+void Play::updateCursorUVAndPos()
+{
+    Mesh::cursor(vertices, window, looking_at_x, looking_at_y, cursor_uvs[cursor_frame]);
+}
+
+void Play::updateCursorLookingAt(const Camera::Basis& looking)
+{
+    const Profile::Scope timed(Profile::Cursor);
+    const float miny = get_terrain_min_y();
+    const float minx = get_terrain_min_x();
+    // where the line of sight from the camera, at height 0, meets the floor, at height -1
+    const float dir_x = looking.cos_x * looking.cos_y;
+    const float dir_y = looking.sin_y;
+    const float dir_z = looking.sin_x * looking.cos_y;
+    if(dir_y != 0.0f)
+    {
+        float dist = -1.0f / dir_y;
+        if(dist <= 3.16f)
+        {
+            const float end_x = positionX + dir_x * dist;
+            const float end_z = positionZ + dir_z * dist;
+            int x = width - int(end_x - minx) - 1;
+            int y = height - int(end_z - miny) - 1;
+            int total = x + y * width;
+
+            if(x < 0 || y < 0 || total < 0 || x >= width || y >= height) return;
+
+            looking_at_floor = true;
+            if(x == looking_at_x && y == looking_at_y) return;
+
+            framectr = 0;
+            cursor_frame = 0;
+            cursor_frame_dir = 1;
+            looking_at_x = x;
+            looking_at_y = y;
+            should_update_cursor_verts = true;
+        }
+    }
+}
+
+void Play::generateCrosshair()
+{
+    Mesh::crosshair(vertices, window, crosshair_uvs);
+}
+
+void Play::generateCursor()
+{
+    updateCursorUVAndPos();
+}
+
+void Play::generateFloor()
+{
+    floor_mesh.reset(window);
+    for(int y = window.y0; y < window.y0 + window.height; y++)
+    {
+        for(int x = window.x0; x < window.x0 + window.width; x++)
+        {
+            const int square = XY_TO_IDX(x, y, this);
+            floor_mesh.set(square, floorTileOf(square));
+        }
+    }
+    floor_mesh.update(vertices, floor_tiles.tiles, floor_tiles.groups);
+}
+
+void Play::generateWalls()
+{
+    Mesh::walls(vertices, window, wall_uvs);
+}
+
+void Play::generateVertices()
+{
+    // prepare already has the buffer
+    materializeWindow();
+
+    generateCrosshair();
+    generateCursor();
+
+    generateFloor();
+    generateWalls();
+}
+
+void Play::startLevel()
+{
+    floor_changed = false;
+    looking_at_floor = false;
+    should_update_cursor = false;
+    should_update_cursor_verts = false;
+    generated = false;
+    cursor_frame = 0;
+    cursor_frame_dir = 1;
+    framectr = 0;
+    dead = false;
+    win = false;
+}
+
+void Play::setUpLevel()
+{
+    startLevel();
+    angleX = 0.0f;
+    angleY = 0.0f;
+    positionX = 0.0f;
+    positionZ = 0.0f;
+    if(endless)
+    {
+        // the player starts on the spawn of the endless board, where there are never bombs around:
+        // there's nothing to generate on the first reveal
+        width = height = ENDLESS_SZ;
+        origin_x = Endless::SPAWN_X - width / 2;
+        origin_y = Endless::SPAWN_Y - height / 2;
+        bombs = 0;
+        generated = true;
+        endless_board.reset(bombpercent, Rng::splitmix64(seed), Mesh::WINDOW_SIZE);
+    }
+    else
+    {
+        bombs = bombpercent * width * height / 100;
+        board.reset(width, height, bombs);
+    }
+}
+
+void Play::prepare(Vertex* level_vertices, const Mesh::Layout& level_window)
+{
+    vertices = level_vertices;
+    window = level_window;
+    preparing = Preparing::Level;
+    worker.start([this]() {
+        const Profile::Scope timed(Profile::Generation);
+        generateVertices();
+    });
+}
+
+void Play::finishPreparing()
+{
+    if(preparing == Preparing::Level)
+    {
+        dirty_squares.reserve(window.width * window.height);
+        playing = true;
+    }
+    else if(preparing == Preparing::Bombs)
+    {
+        generated = true;
+        // the board isn't one without guessing, which the level then says (see MineSweeper::renderGui)
+        if(!first_guaranteed)
+            no_guess = false;
+        ended(first_outcome);
+        // the chunks the first reveal changed are meshed again here, ThreeD draws them in the meantime
+        updateFloor();
+        // the window stayed put while the job had the board
+        if(!Mesh::covers(window, get_board_x(), get_board_y(), Culling::WINDOW_REACH))
+            moveWindow();
+    }
+    preparing = Preparing::Nothing;
+}
+
+void Play::moveWindow()
+{
+    window = Mesh::window(width, height, get_board_x(), get_board_y());
+    window_moved = true;
+    materializeWindow();
+    // generateFloor rewrites every square of the new window
+    dirty_squares.clear();
+
+    generateCrosshair();
+    generateCursor();
+
+    generateFloor();
+    generateWalls();
+}
+
+void Play::materializeWindow()
+{
+    if(!endless)
+        return;
+
+    // the openings this carries on with are drawn by generateFloor
+    const Endless::Square first = endlessSquare(window.x0, window.y0);
+    endless_board.materialize(first.x, first.y, first.x + window.width, first.y + window.height);
+}
+
+void Play::recentre()
+{
+    // whole squares, so that the squares of the level stay on the squares of the endless board
+    const int dx = int(positionX);
+    const int dz = int(positionZ);
+    positionX -= dx;
+    positionZ -= dz;
+    origin_x -= dx;
+    origin_y -= dz;
+    looking_at_x += dx;
+    looking_at_y += dz;
+    moveWindow();
+}
+
+Save::Game Play::saved() const
+{
+    Save::Game game;
+    // a job placing the bombs that was waited for counts as done, finishPreparing may not have picked it up yet
+    const bool placed = generated || preparing == Preparing::Bombs;
+    const bool guaranteed = no_guess && (preparing != Preparing::Bombs || first_guaranteed);
+    game.what = (endless ? Save::Game::ENDLESS : 0) | (placed ? Save::Game::GENERATED : 0) | (guaranteed && !endless ? Save::Game::NO_GUESS : 0);
+    game.bomb_percent = uint8_t(bombpercent);
+    game.width = width;
+    game.height = height;
+    game.seed = endless ? endless_board.seed : board.seed;
+    game.first = first_reveal;
+    game.origin_x = origin_x;
+    game.origin_y = origin_y;
+    game.angle_x = angleX;
+    game.angle_y = angleY;
+    game.position_x = positionX;
+    game.position_z = positionZ;
+    return game;
+}
+
+void Play::restore(const Save::Game& game)
+{
+    startLevel();
+    endless = game.what & Save::Game::ENDLESS;
+    no_guess = game.what & Save::Game::NO_GUESS;
+    generated = endless || (game.what & Save::Game::GENERATED);
+    bombpercent = game.bomb_percent;
+    width = game.width;
+    height = game.height;
+    bombs = endless ? 0 : board.bombs;
+    first_reveal = game.first;
+    origin_x = game.origin_x;
+    origin_y = game.origin_y;
+    angleX = game.angle_x;
+    angleY = game.angle_y;
+    positionX = game.position_x;
+    positionZ = game.position_z;
+}
+
+void Play::update(const Frame& frame)
+{
+    frames++;
+    if(frame.down & Keys::SELECT)
+        in_controls = !in_controls;
+    // the worker is waited for even when done, so that a replay where it isn't yet gets to the same place
+    if(preparing == Preparing::Bombs && frame.worker_done)
+    {
+        worker.wait();
+        finishPreparing();
+    }
+
+    if(in_controls)
+        updateControls(frame);
+    else if(playing)
+        updatePlaying(frame);
+}
+
+void Play::updateControls(const Frame& frame)
+{
+    const uint32_t kDown = frame.down;
+    if(kDown & Keys::UP)
+    {
+        switch(editing_control_type)
+        {
+            case EditingControls::ABXY:
+            {
+                editing_control_type = EditingControls::Sensitivity;
+            }
+            break;
+            case EditingControls::DPAD:
+            {
+                editing_control_type = EditingControls::ABXY;
+            }
+            break;
+            case EditingControls::YAxis:
+            {
+                editing_control_type = EditingControls::DPAD;
+            }
+            break;
+            case EditingControls::Sensitivity:
+            {
+                editing_control_type = EditingControls::YAxis;
+            }
+            break;
+        }
+    }
+    else if(kDown & Keys::DOWN)
+    {
+        switch(editing_control_type)
+        {
+            case EditingControls::ABXY:
+            {
+                editing_control_type = EditingControls::DPAD;
+            }
+            break;
+            case EditingControls::DPAD:
+            {
+                editing_control_type = EditingControls::YAxis;
+            }
+            break;
+            case EditingControls::YAxis:
+            {
+                editing_control_type = EditingControls::Sensitivity;
+            }
+            break;
+            case EditingControls::Sensitivity:
+            {
+                editing_control_type = EditingControls::ABXY;
+            }
+            break;
+        }
+    }
+    else if(kDown & Keys::LEFT)
+    {
+        switch(editing_control_type)
+        {
+            case EditingControls::ABXY:
+            {
+                abxy_look = !abxy_look;
+            }
+            break;
+            case EditingControls::DPAD:
+            {
+                dpad_look = !dpad_look;
+            }
+            break;
+            case EditingControls::YAxis:
+            {
+                y_axis_inverted = !y_axis_inverted;
+            }
+            break;
+            case EditingControls::Sensitivity:
+            {
+                rotate_speed_factor -= 0.125f;
+                if(rotate_speed_factor < 0.0f)
+                {
+                    rotate_speed_factor = 0.0f;
+                }
+            }
+            break;
+        }
+    }
+    else if(kDown & Keys::RIGHT)
+    {
+        switch(editing_control_type)
+        {
+            case EditingControls::ABXY:
+            {
+                abxy_look = !abxy_look;
+            }
+            break;
+            case EditingControls::DPAD:
+            {
+                dpad_look = !dpad_look;
+            }
+            break;
+            case EditingControls::YAxis:
+            {
+                y_axis_inverted = !y_axis_inverted;
+            }
+            break;
+            case EditingControls::Sensitivity:
+            {
+                rotate_speed_factor += 0.125f;
+                if(rotate_speed_factor > 3.0f)
+                {
+                    rotate_speed_factor = 3.0f;
+                }
+            }
+            break;
+        }
+    }
+}
+
+void Play::updatePlaying(const Frame& frame)
+{
+    const uint32_t kDown = frame.down;
+    const uint32_t kHeld = frame.held;
+    if((kDown | kHeld) & getLookLeftKeys())
+    {
+        lookLeft(rotateSpeed());
+    }
+    else if((kDown | kHeld) & getLookRightKeys())
+    {
+        lookRight(rotateSpeed());
+    }
+    else if((kDown | kHeld) & getLookUpKeys())
+    {
+        lookUp(rotateSpeed());
+    }
+    else if((kDown | kHeld) & getLookDownKeys())
+    {
+        lookDown(rotateSpeed());
+    }
+
+    const Camera::Basis looking = camera();
+    if((kDown | kHeld) & getMoveForwardKeys()) // move forward
+    {
+        goForward(looking, MOVEMENT_SPEED);
+    }
+    else if((kDown | kHeld) & getMoveLeftKeys()) // move left
+    {
+        goLeft(looking, MOVEMENT_SPEED);
+    }
+    else if((kDown | kHeld) & getMoveRightKeys()) // move right
+    {
+        goRight(looking, MOVEMENT_SPEED);
+    }
+    else if((kDown | kHeld) & getMoveBackwardsKeys()) // move backwards
+    {
+        goBackwards(looking, MOVEMENT_SPEED);
+    }
+
+    if(dead || win)
+    {
+        should_update_cursor = false;
+        if(frames - end_frame >= END_FRAMES && kDown & (Keys::L | Keys::R))
+            playing = false;
+    }
+    else if(looking_at_floor)
+    {
+        if(kDown & Keys::L) // place a fLag
+        {
+            if(generated)
+            {
+                placeFlag();
+                floor_changed = true;
+            }
+        }
+        else if(kDown & Keys::R) // Reveal a square
+        {
+            if(!generated)
+            {
+                // nothing can be flagged yet, and the first reveal is safe: the job has the whole first move
+                if(preparing == Preparing::Nothing)
+                {
+                    preparing = Preparing::Bombs;
+                    first_reveal = {looking_at_x, looking_at_y};
+                    worker.start([this]() {
+                        const Profile::Scope timed(Profile::Generation);
+                        first_guaranteed = generateBombs(first_reveal);
+                        first_outcome = revealAt(first_reveal);
+                    });
+                }
+            }
+            else if(!isFlagged(looking_at_x, looking_at_y))
+            {
+                reveal();
+                floor_changed = true;
+            }
+        }
+    }
+
+    if(should_update_cursor)
+    {
+        updateCursorLookingAt(looking);
+        should_update_cursor = false;
+    }
+
+    if(looking_at_floor)
+    {
+        framectr++;
+        if(framectr % 30 == 0)
+        {
+            framectr = 0;
+            cursor_frame += cursor_frame_dir;
+            if(cursor_frame == 2)
+            {
+                cursor_frame_dir = -1;
+            }
+            else if(cursor_frame == 0)
+            {
+                cursor_frame_dir = 1;
+            }
+            should_update_cursor_verts = true;
+        }
+    }
+
+    if(should_update_cursor_verts)
+    {
+        updateCursorUVAndPos();
+        should_update_cursor_verts = false;
+    }
+
+    if(floor_changed)
+    {
+        updateFloor();
+        floor_changed = false;
+    }
+}
+
+uint32_t Play::hash() const
+{
+    // the planes of the board only change along with its counters, and they're too big to go through every frame.
+    // The board belongs to the worker while it's preparing
+    Hash hash;
+    hash.add(playing);
+    hash.add(dead);
+    hash.add(win);
+    hash.add(generated);
+    hash.add(no_guess);
+    hash.add(in_controls);
+    hash.add(looking_at_floor);
+    hash.add(preparing);
+    hash.add(editing_control_type);
+    hash.add(abxy_look);
+    hash.add(dpad_look);
+    hash.add(y_axis_inverted);
+    hash.add(rotate_speed_factor);
+    hash.add(angleX);
+    hash.add(angleY);
+    hash.add(positionX);
+    hash.add(positionZ);
+    hash.add(looking_at_x);
+    hash.add(looking_at_y);
+    hash.add(cursor_frame);
+    hash.add(origin_x);
+    hash.add(origin_y);
+    hash.add(window.x0);
+    hash.add(window.y0);
+    if(preparing == Preparing::Nothing)
+    {
+        hash.add(board.flags_count);
+        hash.add(board.hidden_safe);
+        hash.add(endless_board.flags_count);
+        hash.add(endless_board.opened);
+    }
+    return hash.value;
+}
@@ -0,0 +1,292 @@
+#pragma once
+
+// The rules of a level being played, one frame at a time
+
+#include "board.h"
+#include "camera.h"
+#include "endless.h"
+#include "mesh.h"
+#include "save.h"
+#include "worker.h"
+
+#include <vector>
+#include <cstdint>
+
+// The buttons the way hidKeysDown and hidKeysHeld give them (see KEY_* in libctru)
+namespace Keys {
+    constexpr uint32_t A = 1u << 0, B = 1u << 1, SELECT = 1u << 2, START = 1u << 3;
+    constexpr uint32_t DRIGHT = 1u << 4, DLEFT = 1u << 5, DUP = 1u << 6, DDOWN = 1u << 7;
+    constexpr uint32_t R = 1u << 8, L = 1u << 9, X = 1u << 10, Y = 1u << 11;
+    constexpr uint32_t CSTICK_RIGHT = 1u << 24, CSTICK_LEFT = 1u << 25, CSTICK_UP = 1u << 26, CSTICK_DOWN = 1u << 27;
+    constexpr uint32_t CPAD_RIGHT = 1u << 28, CPAD_LEFT = 1u << 29, CPAD_UP = 1u << 30, CPAD_DOWN = 1u << 31;
+    // the D-Pad or the Circle Pad
+    constexpr uint32_t UP = DUP | CPAD_UP, DOWN = DDOWN | CPAD_DOWN, LEFT = DLEFT | CPAD_LEFT, RIGHT = DRIGHT | CPAD_RIGHT;
+};
+
+// A level, from its geometry being made to the player leaving it, and the controls settings.
+// Everything a frame depends on comes in its Frame, so that the same frames from the same start always play out the same
+// (see Replay). The geometry is written into vertices, drawing it is left to whoever gave them (see MineSweeper)
+struct Play {
+    // An endless level is played on a ENDLESS_SZ x ENDLESS_SZ stretch of the endless board, the squares around origin_x, origin_y.
+    // The stretch moves with the player once they're ENDLESS_RECENTRE squares away from its centre (see recentre),
+    // so that positions stay small and its edges never come in sight
+    static constexpr short ENDLESS_SZ = 4096;
+    static constexpr float ENDLESS_RECENTRE = 1024.0f;
+
+    static constexpr float ROTATE_SPEED_BASE = 0.75f;
+    static constexpr float ROTATE_SPEED_BASE_FACTOR = 1.0f;
+    static constexpr float MOVEMENT_SPEED = 0.125f/2.75f;
+    // how long the end of a level stays up before L or R leave it, half a second at 60 frames a second
+    static constexpr int END_FRAMES = 30;
+
+    // What a frame gets from outside the rules: the buttons, the touch screen, and whether the worker was done
+    struct Frame {
+        uint32_t down, held;
+        uint16_t touch_x, touch_y;
+        bool worker_done;
+    };
+
+    enum class EditingControls {
+        ABXY,
+        DPAD,
+        YAxis,
+        Sensitivity,
+    };
+    Board board;
+    Endless endless_board;
+    int origin_x, origin_y;
+
+    // squares of the window whose floor tiles need rewriting on the next updateFloor()
+    std::vector<int> dirty_squares;
+    // the floor of the window as it's drawn, its hidden and open patches merged
+    Mesh::Floor floor_mesh;
+    // What a floor square can look like, each tile being a base sprite with another one drawn over it (see MineSweeper::setupFloorTiles),
+    // at the place of its number in the floor's texture (see Mesh::floorTileUVs)
+    static constexpr int FLOOR_HIDDEN = 0, FLOOR_FLAGGED = 1, FLOOR_EXPLODED = 2, FLOOR_OPEN = 3;
+    static constexpr int FLOOR_NUMBERS = 4; // then 1 to 8
+    static constexpr int FLOOR_TILES = FLOOR_NUMBERS + 8;
+    // the tiles that get a texture of their own, in the order of their groups (see Mesh::Floor).
+    // Hidden squares last: a flag only changes their patches, and those of no group after them
+    static constexpr int FLOOR_REPEATING[Mesh::REPEATING] = {FLOOR_OPEN, FLOOR_HIDDEN};
+    Mesh::QuadUVs cursor_uvs[3], crosshair_uvs, wall_uvs;
+
+    // The geometry of the window of the board around the player (see prepare)
+    Vertex* vertices;
+    Mesh::Layout window;
+    bool window_moved; // since whoever draws it last looked
+
+    short looking_at_x, looking_at_y;
+    int cursor_frame, cursor_frame_dir;
+    int framectr;
+
+    short width, height, bombpercent;
+    int bombs;
+
+    float angleX, angleY;
+    float positionX, positionZ;
+    float rotate_speed_factor;
+
+    bool playing;
+    bool dead;
+    bool win;
+    bool looking_at_floor;
+    bool should_update_cursor;
+    bool should_update_cursor_verts;
+    bool floor_changed;
+    bool generated;
+    bool in_controls;
+    bool endless;
+    bool no_guess; // boards that can be solved from the first click without guessing (see NoGuess::generate)
+
+    EditingControls editing_control_type;
+    bool abxy_look;
+    bool dpad_look;
+    bool y_axis_inverted;
+
+    int frames; // played through update
+    int end_frame;
+    uint64_t seed; // every level's board seed is drawn from this one
+
+    // Making the geometry of a level and its first reveal happen on the worker: the main loop keeps drawing,
+    // and only picks up the result once it's done (see finishPreparing).
+    // Declared after everything a job touches, so that the job is waited for before any of it goes away
+    enum class Preparing {
+        Nothing,
+        Level, // generateVertices, the menu stays up
+        Bombs, // generateBombs and the first reveal, the player can look and move around. Its floor tiles come after
+    };
+    Worker worker;
+    Preparing preparing;
+    Coord first_reveal; // the bombs are placed around it, kept for saved
+    Board::Outcome first_outcome;
+    bool first_guaranteed; // what generateBombs gave, no_guess is cleared once the job is done when it's not
+
+    Play();
+
+    float get_terrain_min_y() const
+    {
+        return height/-2.0f;
+    }
+    float get_terrain_min_x() const
+    {
+        return width/-2.0f;
+    }
+    // where the player stands on the board, in squares
+    float get_board_x() const
+    {
+        return width/2.0f - positionX;
+    }
+    float get_board_y() const
+    {
+        return height/2.0f - positionZ;
+    }
+    float rotateSpeed() const
+    {
+        return rotate_speed_factor * ROTATE_SPEED_BASE;
+    }
+    // the trig of angleX and angleY, for a frame once the player is done turning
+    Camera::Basis camera() const
+    {
+        return Camera::basis(angleX, angleY);
+    }
+
+    uint32_t getKeysForFlag(bool flag, uint32_t abxy, uint32_t dpad) const
+    {
+        uint32_t keys = 0;
+        if(abxy_look == flag)
+            keys |= abxy;
+        if(dpad_look == flag)
+            keys |= dpad;
+        return keys;
+    }
+
+    uint32_t getLookUpKeys() const
+    {
+        return getKeysForFlag(true, Keys::X | Keys::CSTICK_UP, Keys::UP);
+    }
+    uint32_t getLookDownKeys() const
+    {
+        return getKeysForFlag(true, Keys::B | Keys::CSTICK_DOWN, Keys::DOWN);
+    }
+    uint32_t getLookLeftKeys() const
+    {
+        return getKeysForFlag(true, Keys::Y | Keys::CSTICK_LEFT, Keys::LEFT);
+    }
+    uint32_t getLookRightKeys() const
+    {
+        return getKeysForFlag(true, Keys::A | Keys::CSTICK_RIGHT, Keys::RIGHT);
+    }
+
+    uint32_t getMoveForwardKeys() const
+    {
+        return getKeysForFlag(false, Keys::X | Keys::CSTICK_UP, Keys::UP);
+    }
+    uint32_t getMoveBackwardsKeys() const
+    {
+        return getKeysForFlag(false, Keys::B | Keys::CSTICK_DOWN, Keys::DOWN);
+    }
+    uint32_t getMoveLeftKeys() const
+    {
+        return getKeysForFlag(false, Keys::Y | Keys::CSTICK_LEFT, Keys::LEFT);
+    }
+    uint32_t getMoveRightKeys() const
+    {
+        return getKeysForFlag(false, Keys::A | Keys::CSTICK_RIGHT, Keys::RIGHT);
+    }
+
+    // square (x, y) of the endless board under square (x, y) of the level
+    Endless::Square endlessSquare(int x, int y) const
+    {
+        return {x + origin_x, y + origin_y};
+    }
+    bool isFlagged(short x, short y) const;
+    bool isOpen(short x, short y) const;
+
+    // false when the board was to be one without guessing and NoGuess::generate gave up, it's then a plain one
+    bool generateBombs(Coord first);
+    // reveals point without touching anything the main loop does, what changed in the window goes in dirty_squares
+    Board::Outcome revealAt(Coord point);
+    // the same for a chord around point (see Board::chord), all of its squares in one go
+    Board::Outcome chordAt(Coord point);
+    // what the last reveal or chord opened in the window, to dirty_squares
+    void markRevealed();
+    void ended(Board::Outcome outcome);
+    // the square looked at, or the ones around it when it's already open
+    void reveal();
+    void placeFlag();
+
+    // Forgets how the last level ended, what's left to set up is the board and where the player stands
+    void startLevel();
+    // Starts a level the way the level edition has it: width and height or endless, bombpercent and no_guess,
+    // its board seed drawn from seed. The player stands in the middle, on the spawn of the endless board for an endless level
+    void setUpLevel();
+    // Starts making the geometry of window on the worker, into vertices which have room for all of it
+    void prepare(Vertex* level_vertices, const Mesh::Layout& level_window);
+
+    void generateCrosshair();
+    void generateCursor();
+    void generateFloor();
+    void generateWalls();
+    void generateVertices();
+    void finishPreparing();
+    void moveWindow();
+    void materializeWindow();
+    void recentre();
+
+    int floorTileOf(int square) const;
+    void updateFloor();
+    void updateCursorUVAndPos();
+    void updateCursorLookingAt(const Camera::Basis& looking);
+
+    void lookDir(float x, float y);
+    // by delta along (dir_x, dir_z)
+    void advance(float dir_x, float dir_z, float delta);
+
+    void goForward(const Camera::Basis& looking, float v)
+    {
+        advance(looking.cos_x, looking.sin_x, v);
+    }
+    void goBackwards(const Camera::Basis& looking, float v)
+    {
+        advance(looking.cos_x, looking.sin_x, -v);
+    }
+    // a quarter turn left of forward: cos(angleX - 90) and sin(angleX - 90)
+    void goLeft(const Camera::Basis& looking, float v)
+    {
+        advance(looking.sin_x, -looking.cos_x, v);
+    }
+    void goRight(const Camera::Basis& looking, float v)
+    {
+        advance(looking.sin_x, -looking.cos_x, -v);
+    }
+
+    void lookLeft(float v)
+    {
+        lookDir(-v, 0.0f);
+    }
+    void lookRight(float v)
+    {
+        lookDir(v, 0.0f);
+    }
+    void lookUp(float v)
+    {
+        lookDir(0.0f, v);
+    }
+    void lookDown(float v)
+    {
+        lookDir(0.0f, -v);
+    }
+
+    // The level as a save, with board or endless_board, and back: restore takes a game Save::read just gave board
+    // or endless_board, the geometry is then still to be prepared. The worker has to be done, saved can come between
+    // it and finishPreparing
+    Save::Game saved() const;
+    void restore(const Save::Game& game);
+
+    // SELECT switches the controls settings on and off, else the frame goes to them or to the level being played
+    void update(const Frame& frame);
+    void updateControls(const Frame& frame);
+    void updatePlaying(const Frame& frame);
+    // A digest of what a frame can change: two plays given the same frames from the same start have the same one after each
+    uint32_t hash() const;
+};
@@ -0,0 +1,136 @@
+#include "profile.h"
+#include "bytes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+#ifdef _3DS
+#include <3ds.h>
+#else
+#include <chrono>
+#endif
+
+namespace {
+    // ticks of the frame being timed, and of the frames kept, FRAMES of them going round from next.
+    // 32 bits hold 16 seconds of ticks on the 3DS, and 4 seconds of nanoseconds anywhere else
+    std::atomic<uint32_t> current[Profile::PHASES];
+    uint32_t kept[Profile::FRAMES][Profile::PHASES];
+    int next = 0;
+    int count = 0;
+
+    uint32_t saturate(Profile::Ticks ticks)
+    {
+        return ticks > UINT32_MAX ? UINT32_MAX : uint32_t(ticks);
+    }
+}
+
+const char* const Profile::names[PHASES] = {
+    "input",
+    "update",
+    "floor",
+    "cursor",
+    "generation",
+    "left eye",
+    "right eye",
+    "gui",
+};
+
+Profile::Ticks Profile::now()
+{
+    #ifdef _3DS
+    return svcGetSystemTick();
+    #else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    #endif
+}
+
+double Profile::microseconds(Ticks ticks)
+{
+    #ifdef _3DS
+    return ticks / (SYSCLOCK_ARM11 / 1000000.0);
+    #else
+    return ticks / 1000.0;
+    #endif
+}
+
+void Profile::add(Phase phase, Ticks ticks)
+{
+    // a phase that takes longer than 32 bits can hold gets stuck at the most they can
+    uint32_t was = current[phase].load(std::memory_order_relaxed);
+    while(!current[phase].compare_exchange_weak(was, saturate(Ticks(was) + ticks), std::memory_order_relaxed))
+        ;
+}
+
+void Profile::endFrame()
+{
+    for(int phase = 0; phase < PHASES; phase++)
+        kept[next][phase] = current[phase].exchange(0, std::memory_order_relaxed);
+    next = (next + 1) % FRAMES;
+    count = count < FRAMES ? count + 1 : FRAMES;
+}
+
+void Profile::reset()
+{
+    for(std::atomic<uint32_t>& ticks : current)
+        ticks.store(0, std::memory_order_relaxed);
+    next = 0;
+    count = 0;
+}
+
+int Profile::frames()
+{
+    return count;
+}
+
+Profile::Summary Profile::summarize(Phase phase)
+{
+    Summary summary = {0.0, 0.0, 0.0};
+    if(count == 0)
+        return summary;
+
+    uint32_t sorted[FRAMES];
+    uint64_t total = 0;
+    for(int frame = 0; frame < count; frame++)
+    {
+        sorted[frame] = kept[frame][phase];
+        total += sorted[frame];
+    }
+    // the 99th percentile is the frame that 99% of the others are at most as long as
+    const int p99 = (count * 99 + 99) / 100 - 1;
+    std::nth_element(sorted, sorted + p99, sorted + count);
+    summary.p99 = microseconds(sorted[p99]);
+    summary.min = microseconds(*std::min_element(sorted, sorted + count));
+    summary.avg = microseconds(total) / count;
+    return summary;
+}
+
+void Profile::writeCsv(std::vector<uint8_t>& out)
+{
+    char cell[32];
+    for(int phase = 0; phase < PHASES; phase++)
+    {
+        const int length = snprintf(cell, sizeof(cell), phase ? ",%s" : "%s", names[phase]);
+        out.insert(out.end(), cell, cell + length);
+    }
+    out.push_back('\n');
+
+    for(int frame = 0; frame < count; frame++)
+    {
+        // the oldest is where the next one goes, once they've gone round
+        const int at = (next - count + frame + FRAMES) % FRAMES;
+        for(int phase = 0; phase < PHASES; phase++)
+        {
+            const int length = snprintf(cell, sizeof(cell), phase ? ",%.1f" : "%.1f", microseconds(kept[at][phase]));
+            out.insert(out.end(), cell, cell + length);
+        }
+        out.push_back('\n');
+    }
+}
+
+bool Profile::writeCsvFile(const char* path)
+{
+    std::vector<uint8_t> data;
+    writeCsv(data);
+    return Bytes::writeFile(path, data);
+}
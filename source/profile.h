@@ -0,0 +1,63 @@
+#pragma once
+
+// How long each part of a frame takes, for the last FRAMES frames. Code for both sides like Worker:
+// the system tick on the 3DS, std::chrono anywhere else, so that the same timers run in the bench (see bench/)
+
+#include <vector>
+#include <cstdint>
+
+namespace Profile {
+    // Parts of a frame, timed by a Scope around them. Some are inside others: Floor and Cursor happen during Update,
+    // and Generation on the worker, counted in the frame it finishes in
+    enum Phase {
+        Input,
+        Update,
+        Floor, // Play::updateFloor
+        Cursor, // Play::updateCursorLookingAt
+        Generation, // a level's geometry, or its bombs and first reveal
+        LeftEye,
+        RightEye,
+        Gui,
+        PHASES,
+    };
+    extern const char* const names[PHASES];
+
+    // about 4 seconds at 60 frames a second
+    constexpr int FRAMES = 256;
+
+    using Ticks = uint64_t;
+    Ticks now();
+    double microseconds(Ticks ticks);
+
+    // Adds ticks to phase in the frame being timed. Can be called from any thread
+    void add(Phase phase, Ticks ticks);
+    // Closes the frame being timed, which goes in place of the oldest one once there are FRAMES
+    void endFrame();
+    // Forgets every frame
+    void reset();
+
+    struct Scope {
+        Phase phase;
+        Ticks start;
+
+        explicit Scope(Phase timed) : phase(timed), start(now()) { }
+        ~Scope()
+        {
+            add(phase, now() - start);
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // how many frames were closed, up to FRAMES
+    int frames();
+    // Over the frames kept, in microseconds, every frame counting even if the phase didn't happen in it
+    struct Summary {
+        double min, avg, p99;
+    };
+    Summary summarize(Phase phase);
+
+    // The frames kept as CSV, oldest first: a row of the names of the phases, then a row of microseconds per frame
+    void writeCsv(std::vector<uint8_t>& out);
+    bool writeCsvFile(const char* path);
+};
@@ -0,0 +1,531 @@
+#include "raster.h"
+#include "atlas.h"
+#include "bytes.h"
+#include "culling.h"
+
+#include <cmath>
+#include <string>
+
+namespace {
+    constexpr float DEGREES_TO_RADIANS = 3.14159265f / 180.0f;
+    // the projection ProgramWide and ThreeD set up, the stereo one converging where the screen is
+    constexpr float NEAR = 0.01f;
+    constexpr float FAR = 100.0f;
+    constexpr float SCREEN = 2.0f;
+    // smoothstep in program.v.pica: the floor falls by FALL between sqrt(FALL_START) and sqrt(FALL_START + 1/FALL_SCALE) away
+    constexpr float FALL = Culling::FLOOR_HIGH - Culling::FLOOR_LOW;
+    constexpr float FALL_START = 240.0f;
+    constexpr float FALL_SCALE = 0.000442477f;
+    // Culling leaves out the chunks entirely past LOD_DISTANCE: the floor has finished falling there, and up to where
+    // a window reaches it's further down than the floor is in front of the player where it starts falling
+    static_assert(FALL_START + 1.0f / FALL_SCALE > Culling::LOD_DISTANCE * Culling::LOD_DISTANCE - 1.0f &&
+                  FALL_START + 1.0f / FALL_SCALE < Culling::LOD_DISTANCE * Culling::LOD_DISTANCE + 1.0f,
+                  "chunks should only be left out where the floor has finished falling");
+    static_assert((FALL - Culling::FLOOR_HIGH) * (FALL - Culling::FLOOR_HIGH) * FALL_START >
+                  Culling::WINDOW_REACH * Culling::WINDOW_REACH * Culling::FLOOR_HIGH * Culling::FLOOR_HIGH,
+                  "the floor left out should be hidden by the floor nearer in");
+    // LevelWide's material under a white light: the specular part goes to the secondary colour, which the TexEnv leaves out
+    constexpr float AMBIENT = 0.125f;
+    constexpr float DIFFUSE = 0.4f;
+    // FogLut_Exp(&fog_Lut, FOG_DENSITY, FOG_GRADIENT, FOG_NEAR, Culling::FOG_END), in the colour of C3D_FogColor
+    constexpr float FOG_DENSITY = 0.05f;
+    constexpr float FOG_GRADIENT = 1.5f;
+    constexpr float FOG_NEAR = 1.0f / 50.0f;
+    constexpr float FOG_RGB[3] = {0x68, 0xB0, 0xD8};
+
+    // A vertex out of the shader: where it is in clip space and in view space, and its texture coordinates
+    struct Shaded {
+        float clip[4];
+        float view[3];
+        float uv[2];
+    };
+    constexpr int SHADED_FLOATS = sizeof(Shaded) / sizeof(float);
+
+    // a triangle clipped by the near and far planes has at most 5 corners
+    constexpr int MAX_CORNERS = 5;
+
+    void multiply(Raster::Matrix& m, const Raster::Matrix& by)
+    {
+        const Raster::Matrix a = m;
+        for(int row = 0; row < 4; row++)
+        {
+            for(int col = 0; col < 4; col++)
+            {
+                float sum = 0.0f;
+                for(int i = 0; i < 4; i++)
+                    sum += a.r[row][i] * by.r[i][col];
+                m.r[row][col] = sum;
+            }
+        }
+    }
+
+    void transform(const Raster::Matrix& m, const float in[4], float out[4])
+    {
+        for(int row = 0; row < 4; row++)
+            out[row] = m.r[row][0] * in[0] + m.r[row][1] * in[1] + m.r[row][2] * in[2] + m.r[row][3] * in[3];
+    }
+
+    // what program.v.pica does with a vertex
+    Shaded shade(const Raster::Uniforms& uniforms, const Vertex& vertex)
+    {
+        const float x = vertex.position[0] / Vertex::POSITION_SCALE;
+        const float y = vertex.position[1] / Vertex::POSITION_SCALE;
+        const float z = vertex.position[2] / Vertex::POSITION_SCALE;
+        float r0[4] = {
+            x + uniforms.cameraPos[0] - uniforms.cameraPos[3],
+            y,
+            z + uniforms.cameraPos[2] - uniforms.cameraPos[1],
+            1.0f,
+        };
+
+        // smoothstep
+        float k = (r0[0] * r0[0] + r0[2] * r0[2] - FALL_START) * FALL_SCALE;
+        k = k < 0.0f ? 0.0f : (k > 1.0f ? 1.0f : k);
+        r0[1] -= FALL * k * k * (3.0f - 2.0f * k);
+
+        Shaded out;
+        float r1[4];
+        transform(uniforms.modelView, r0, r1);
+        transform(uniforms.projection, r1, out.clip);
+        out.view[0] = r1[0];
+        out.view[1] = r1[1];
+        out.view[2] = r1[2];
+        out.uv[0] = vertex.texcoord[0] / Vertex::TEXCOORD_SCALE;
+        out.uv[1] = vertex.texcoord[1] / Vertex::TEXCOORD_SCALE;
+        return out;
+    }
+
+    Shaded lerp(const Shaded& a, const Shaded& b, float t)
+    {
+        const float* from = &a.clip[0];
+        const float* to = &b.clip[0];
+        Shaded out;
+        float* mixed = &out.clip[0];
+        for(int i = 0; i < SHADED_FLOATS; i++)
+            mixed[i] = from[i] + (to[i] - from[i]) * t;
+        return out;
+    }
+
+    // Keeps what's on the positive side of a plane of clip space, distance(v) telling how far v is in
+    template<typename Distance>
+    int clipBy(const Shaded* in, int count, Shaded* out, Distance distance)
+    {
+        int kept = 0;
+        for(int i = 0; i < count; i++)
+        {
+            const Shaded& a = in[i];
+            const Shaded& b = in[(i + 1) % count];
+            const float da = distance(a), db = distance(b);
+            if(da >= 0.0f)
+                out[kept++] = a;
+            if((da >= 0.0f) != (db >= 0.0f))
+                out[kept++] = lerp(a, b, da / (da - db));
+        }
+        return kept;
+    }
+
+    // A corner in pixels, with what's interpolated across the triangle divided by w so that it's perspective correct
+    struct Corner {
+        float x, y;
+        float depth; // see Target::depth, linear on screen
+        float inv_w;
+        float view[3];
+        float uv[2];
+    };
+
+    Corner project(const Shaded& v)
+    {
+        // the GPU's x goes up the screen and its y to the left, see perspTilt
+        const float inv_w = 1.0f / v.clip[3];
+        Corner corner;
+        corner.x = (1.0f - v.clip[1] * inv_w) * 0.5f * Raster::WIDTH;
+        corner.y = (1.0f - v.clip[0] * inv_w) * 0.5f * Raster::HEIGHT;
+        corner.depth = -v.clip[2] * inv_w;
+        corner.inv_w = inv_w;
+        for(int i = 0; i < 3; i++)
+            corner.view[i] = v.view[i] * inv_w;
+        corner.uv[0] = v.uv[0] * inv_w;
+        corner.uv[1] = v.uv[1] * inv_w;
+        return corner;
+    }
+
+    // twice the area of abc, positive when it goes clockwise on screen
+    float area(const Corner& a, const Corner& b, const Corner& c)
+    {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+
+    uint32_t sample(const Raster::Texture& texture, float u, float v)
+    {
+        int x = int(floorf(u * texture.width));
+        int y = int(floorf(v * texture.height));
+        if(texture.repeat)
+        {
+            x = (x % texture.width + texture.width) % texture.width;
+            y = (y % texture.height + texture.height) % texture.height;
+        }
+        x = x < 0 ? 0 : (x >= texture.width ? texture.width - 1 : x);
+        y = y < 0 ? 0 : (y >= texture.height ? texture.height - 1 : y);
+        return texture.texels[Atlas::texelOffset(x, y, texture.width)];
+    }
+
+    // What a draw keeps for every fragment: the normal in view space, the light, the texture
+    struct Fragments {
+        const Raster::Texture* texture;
+        float normal[3];
+        const float* light;
+    };
+
+    uint32_t shadeFragment(const Fragments& fragments, uint32_t dst, const float view[3], float u, float v, float depth)
+    {
+        const uint32_t texel = sample(*fragments.texture, u, v);
+
+        float to_light[3] = {fragments.light[0] - view[0], fragments.light[1] - view[1], fragments.light[2] - view[2]};
+        const float length = sqrtf(to_light[0] * to_light[0] + to_light[1] * to_light[1] + to_light[2] * to_light[2]);
+        float lit = AMBIENT;
+        if(length > 0.0f)
+        {
+            const float facing = (fragments.normal[0] * to_light[0] + fragments.normal[1] * to_light[1] + fragments.normal[2] * to_light[2]) / length;
+            lit += DIFFUSE * (facing > 0.0f ? facing : 0.0f);
+        }
+        lit = lit > 1.0f ? 1.0f : lit;
+
+        // the fog table goes by depth, FogLut_CalcZ turning it back into a distance the way it expects
+        const float distance = Culling::FOG_END * FOG_NEAR / (depth * (Culling::FOG_END - FOG_NEAR) + FOG_NEAR);
+        const float clear = expf(-powf(FOG_DENSITY * distance, FOG_GRADIENT));
+
+        const float alpha = (texel & 0xFF) / 255.0f;
+        uint32_t out = 0xFF;
+        for(int channel = 0; channel < 3; channel++)
+        {
+            const int shift = 24 - channel * 8;
+            const float src = ((texel >> shift) & 0xFF) * lit * clear + FOG_RGB[channel] * (1.0f - clear);
+            const float mixed = src * alpha + ((dst >> shift) & 0xFF) * (1.0f - alpha);
+            out |= uint32_t(mixed + 0.5f) << shift;
+        }
+        return out;
+    }
+
+    // Fills the pixels whose centres are in abc, which goes clockwise, with the top left rule so that shared edges are drawn once
+    void fill(Raster::Target& target, const Fragments& fragments, const Corner& a, const Corner& b, const Corner& c, Raster::Stats& stats)
+    {
+        const float twice_area = area(a, b, c);
+        if(!(twice_area > 0.0f))
+            return;
+
+        const float min_x = fminf(a.x, fminf(b.x, c.x)), max_x = fmaxf(a.x, fmaxf(b.x, c.x));
+        const float min_y = fminf(a.y, fminf(b.y, c.y)), max_y = fmaxf(a.y, fmaxf(b.y, c.y));
+        const int x0 = min_x < 0.0f ? 0 : int(min_x);
+        const int y0 = min_y < 0.0f ? 0 : int(min_y);
+        const int x1 = max_x >= Raster::WIDTH ? Raster::WIDTH - 1 : int(max_x);
+        const int y1 = max_y >= Raster::HEIGHT ? Raster::HEIGHT - 1 : int(max_y);
+
+        const Corner* corners[3] = {&a, &b, &c};
+        // edge i goes from corner i + 1 to corner i + 2, and is 0 on the corner across: that weighs corner i
+        bool top_left[3];
+        for(int i = 0; i < 3; i++)
+        {
+            const Corner& from = *corners[(i + 1) % 3];
+            const Corner& to = *corners[(i + 2) % 3];
+            top_left[i] = to.y < from.y || (to.y == from.y && to.x > from.x);
+        }
+
+        for(int y = y0; y <= y1; y++)
+        {
+            const float py = y + 0.5f;
+            for(int x = x0; x <= x1; x++)
+            {
+                const float px = x + 0.5f;
+                float weights[3];
+                bool inside = true;
+                for(int i = 0; i < 3 && inside; i++)
+                {
+                    const Corner& from = *corners[(i + 1) % 3];
+                    const Corner& to = *corners[(i + 2) % 3];
+                    weights[i] = (to.x - from.x) * (py - from.y) - (to.y - from.y) * (px - from.x);
+                    inside = weights[i] > 0.0f || (weights[i] == 0.0f && top_left[i]);
+                }
+                if(!inside)
+                    continue;
+                for(float& weight : weights)
+                    weight /= twice_area;
+
+                const float depth = weights[0] * a.depth + weights[1] * b.depth + weights[2] * c.depth;
+                const int pixel = x + y * Raster::WIDTH;
+                // GPU_GREATER, the nearest is kept
+                if(!(depth > target.depth[pixel]))
+                    continue;
+
+                const float w = 1.0f / (weights[0] * a.inv_w + weights[1] * b.inv_w + weights[2] * c.inv_w);
+                float view[3];
+                for(int i = 0; i < 3; i++)
+                    view[i] = (weights[0] * a.view[i] + weights[1] * b.view[i] + weights[2] * c.view[i]) * w;
+                const float u = (weights[0] * a.uv[0] + weights[1] * b.uv[0] + weights[2] * c.uv[0]) * w;
+                const float v = (weights[0] * a.uv[1] + weights[1] * b.uv[1] + weights[2] * c.uv[1]) * w;
+
+                target.color[pixel] = shadeFragment(fragments, target.color[pixel], view, u, v, depth);
+                target.depth[pixel] = depth;
+                stats.pixels++;
+            }
+        }
+    }
+
+    // Whether all of a triangle is outside the same side of the screen
+    bool outOfSight(const Shaded& a, const Shaded& b, const Shaded& c)
+    {
+        const Shaded* corners[3] = {&a, &b, &c};
+        for(int axis = 0; axis < 2; axis++)
+        {
+            int above = 0, below = 0;
+            for(const Shaded* corner : corners)
+            {
+                above += corner->clip[axis] > corner->clip[3];
+                below += corner->clip[axis] < -corner->clip[3];
+            }
+            if(above == 3 || below == 3)
+                return true;
+        }
+        return false;
+    }
+
+    void drawTriangle(Raster::Target& target, const Fragments& fragments, const Shaded& a, const Shaded& b, const Shaded& c, Raster::Stats& stats)
+    {
+        stats.submitted++;
+        if(outOfSight(a, b, c))
+        {
+            stats.culled++;
+            return;
+        }
+
+        // the near and far planes, where depth goes from 1 to 0
+        Shaded in[MAX_CORNERS] = {a, b, c};
+        Shaded out[MAX_CORNERS];
+        int count = clipBy(in, 3, out, [](const Shaded& v) { return v.clip[2] + v.clip[3]; });
+        count = clipBy(out, count, in, [](const Shaded& v) { return -v.clip[2]; });
+        if(count < 3)
+        {
+            stats.culled++;
+            return;
+        }
+
+        Corner corners[MAX_CORNERS];
+        float winding = 0.0f;
+        for(int i = 0; i < count; i++)
+            corners[i] = project(in[i]);
+        for(int i = 1; i + 1 < count; i++)
+            winding += area(corners[0], corners[i], corners[i + 1]);
+        // GPU_CULL_FRONT_CCW: what goes counterclockwise on screen is facing away
+        if(!(winding > 0.0f))
+        {
+            stats.culled++;
+            return;
+        }
+        for(int i = 1; i + 1 < count; i++)
+            fill(target, fragments, corners[0], corners[i], corners[i + 1], stats);
+    }
+
+    void setNormal(Raster::Uniforms& uniforms, float x, float y, float z)
+    {
+        uniforms.normal[0] = x;
+        uniforms.normal[1] = y;
+        uniforms.normal[2] = z;
+    }
+}
+
+Raster::Matrix Raster::identity()
+{
+    Matrix m = {};
+    for(int i = 0; i < 4; i++)
+        m.r[i][i] = 1.0f;
+    return m;
+}
+
+Raster::Matrix Raster::perspTilt(float fovy, float aspect, float near, float far)
+{
+    // the screen is turned a quarter: what ends up going across it is the GPU's y
+    const float fov_tan = tanf(fovy / 2.0f);
+    Matrix m = {};
+    m.r[0][1] = 1.0f / fov_tan;
+    m.r[1][0] = -1.0f / (fov_tan * aspect);
+    m.r[2][2] = near / (near - far);
+    m.r[2][3] = far * near / (near - far);
+    m.r[3][2] = -1.0f;
+    return m;
+}
+
+Raster::Matrix Raster::perspStereoTilt(float fovy, float aspect, float near, float far, float iod, float screen)
+{
+    // the eye moved by iod / 2 across, and its frustum skewed back so that what's at screen away doesn't move
+    Matrix m = perspTilt(fovy, aspect, near, far);
+    const float fov_tan_aspect = tanf(fovy / 2.0f) * aspect;
+    m.r[1][2] = iod / (2.0f * screen) / fov_tan_aspect;
+    m.r[1][3] = iod / 2.0f / fov_tan_aspect;
+    return m;
+}
+
+void Raster::rotateY(Matrix& m, float angle)
+{
+    const float c = cosf(angle), s = sinf(angle);
+    Matrix by = identity();
+    by.r[0][0] = c;
+    by.r[0][2] = s;
+    by.r[2][0] = -s;
+    by.r[2][2] = c;
+    multiply(m, by);
+}
+
+void Raster::rotate(Matrix& m, const float axis[3], float angle)
+{
+    const float length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    const float x = axis[0] / length, y = axis[1] / length, z = axis[2] / length;
+    const float c = cosf(angle), s = sinf(angle), t = 1.0f - c;
+    Matrix by = identity();
+    by.r[0][0] = t * x * x + c;
+    by.r[1][0] = t * x * y + s * z;
+    by.r[2][0] = t * x * z - s * y;
+    by.r[0][1] = t * y * x - s * z;
+    by.r[1][1] = t * y * y + c;
+    by.r[2][1] = t * y * z + s * x;
+    by.r[0][2] = t * z * x + s * y;
+    by.r[1][2] = t * z * y - s * x;
+    by.r[2][2] = t * z * z + c;
+    multiply(m, by);
+}
+
+Raster::Target::Target() : color(WIDTH * HEIGHT), depth(WIDTH * HEIGHT)
+{
+    clear(0);
+}
+
+void Raster::Target::clear(uint32_t rgba)
+{
+    for(uint32_t& pixel : color)
+        pixel = rgba;
+    for(float& pixel : depth)
+        pixel = 0.0f;
+}
+
+void Raster::drawQuads(Target& target, const Uniforms& uniforms, const Texture& texture, const Vertex* vertices, int first, int count, Stats& stats)
+{
+    // the shader turns the normal with modelView and normalizes it
+    Fragments fragments;
+    fragments.texture = &texture;
+    fragments.light = uniforms.light;
+    float length = 0.0f;
+    for(int row = 0; row < 3; row++)
+    {
+        fragments.normal[row] = uniforms.modelView.r[row][0] * uniforms.normal[0] + uniforms.modelView.r[row][1] * uniforms.normal[1] +
+                                uniforms.modelView.r[row][2] * uniforms.normal[2];
+        length += fragments.normal[row] * fragments.normal[row];
+    }
+    length = sqrtf(length);
+    for(float& axis : fragments.normal)
+        axis /= length;
+
+    for(int quad = first; quad < first + count; quad++)
+    {
+        Shaded corners[Mesh::QUAD_VERTICES];
+        for(int corner = 0; corner < Mesh::QUAD_VERTICES; corner++)
+            corners[corner] = shade(uniforms, vertices[quad * Mesh::QUAD_VERTICES + corner]);
+        for(int index = 0; index < Mesh::QUAD_INDICES; index += 3)
+        {
+            drawTriangle(target, fragments, corners[Mesh::quad_indices[index]], corners[Mesh::quad_indices[index + 1]],
+                         corners[Mesh::quad_indices[index + 2]], stats);
+        }
+    }
+}
+
+Raster::Uniforms Raster::levelUniforms(const Mesh::Layout& layout, float posX, float posZ, const Camera::Basis& camera, float iod)
+{
+    Uniforms uniforms;
+    if(iod == 0.0f)
+        uniforms.projection = perspTilt(Culling::FOV_Y_DEGREES * DEGREES_TO_RADIANS, Culling::ASPECT_RATIO, NEAR, FAR);
+    else
+        uniforms.projection = perspStereoTilt(Culling::FOV_Y_DEGREES * DEGREES_TO_RADIANS, Culling::ASPECT_RATIO, NEAR, FAR, iod, SCREEN);
+
+    Camera::modelView(camera, uniforms.modelView.r);
+
+    uniforms.cameraPos[0] = posX + layout.centreX();
+    uniforms.cameraPos[1] = 0.0f;
+    uniforms.cameraPos[2] = posZ + layout.centreZ();
+    uniforms.cameraPos[3] = 0.0f;
+    setNormal(uniforms, 0.0f, 1.0f, 0.0f);
+    uniforms.light[0] = posX;
+    uniforms.light[1] = 0.0f;
+    uniforms.light[2] = posZ;
+    return uniforms;
+}
+
+Raster::Uniforms Raster::crosshairUniforms()
+{
+    Uniforms uniforms;
+    uniforms.projection = perspTilt(Culling::FOV_Y_DEGREES * DEGREES_TO_RADIANS, Culling::ASPECT_RATIO, NEAR, FAR);
+    uniforms.modelView = identity();
+    for(float& axis : uniforms.cameraPos)
+        axis = 0.0f;
+    setNormal(uniforms, 0.0f, 0.0f, 1.0f);
+    for(float& axis : uniforms.light)
+        axis = 0.0f;
+    return uniforms;
+}
+
+void Raster::draw(Target& target, const Mesh::Layout& layout, const Vertex* vertices, const Mesh::Floor& floor,
+                  const Texture& sprites, const Texture floor_textures[Mesh::FLOOR_GROUPS], float posX, float posZ, const Camera::Basis& camera,
+                  bool looking_at_floor, float iod, Stats& stats)
+{
+    Uniforms uniforms = levelUniforms(layout, posX, posZ, camera, iod);
+
+    // {top, bottom, left, right}
+    const int wall_firsts[4] = {
+        layout.topWalls(),
+        layout.bottomWalls(),
+        layout.leftWalls(),
+        layout.rightWalls(),
+    };
+    const int wall_counts[4] = {
+        layout.hasTopWalls() ? layout.width : 0,
+        layout.hasBottomWalls() ? layout.width : 0,
+        layout.hasLeftWalls() ? layout.height : 0,
+        layout.hasRightWalls() ? layout.height : 0,
+    };
+    constexpr float wall_normals[4][2] = {
+        { 0.0f, +1.0f},
+        { 0.0f, -1.0f},
+        {+1.0f,  0.0f},
+        {-1.0f,  0.0f},
+    };
+    for(int side = 0; side < 4; side++)
+    {
+        setNormal(uniforms, wall_normals[side][0], 0.0f, wall_normals[side][1]);
+        drawQuads(target, uniforms, sprites, vertices, wall_firsts[side], wall_counts[side], stats);
+    }
+
+    setNormal(uniforms, 0.0f, 1.0f, 0.0f);
+    const Culling::View view = Culling::makeView(layout, posX, posZ, camera, iod);
+    std::vector<Culling::Range> ranges;
+    for(int group = 0; group < Mesh::FLOOR_GROUPS; group++)
+    {
+        Culling::visibleRanges(view, floor.groups[group], ranges);
+        for(const Culling::Range& range : ranges)
+            drawQuads(target, uniforms, floor_textures[group], vertices, range.first, range.count, stats);
+    }
+    if(looking_at_floor)
+        drawQuads(target, uniforms, sprites, vertices, layout.cursor(), 1, stats);
+
+    drawQuads(target, crosshairUniforms(), sprites, vertices, layout.crosshair(), 1, stats);
+}
+
+bool Raster::writeImage(const char* path, const Target& target)
+{
+    std::vector<uint8_t> data;
+    const std::string header = "P6\n" + std::to_string(WIDTH) + " " + std::to_string(HEIGHT) + "\n255\n";
+    data.assign(header.begin(), header.end());
+    data.reserve(data.size() + WIDTH * HEIGHT * 3);
+    for(const uint32_t pixel : target.color)
+    {
+        data.push_back(uint8_t(pixel >> 24));
+        data.push_back(uint8_t(pixel >> 16));
+        data.push_back(uint8_t(pixel >> 8));
+    }
+    return Bytes::writeFile(path, data);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+// A software stand-in for drawing a level, the way ThreeD::draw puts it on screen
+
+#include "camera.h"
+#include "mesh.h"
+
+#include <vector>
+#include <cstdint>
+
+// ThreeD::draw done on the CPU: the same vertices, matrices and cameraPos go through what program.v.pica does to them,
+// the floor dropping away in the distance included (see smoothstep), then get rasterized the way the GPU is set up to:
+// faces turned away culled, depth tested, textured and modulated by the light, fogged and alpha blended.
+// Where geometry lands and how much of it there is are exact, the light and the fog are close to the GPU's
+namespace Raster {
+    // the top screen, the way it's looked at rather than the way the GPU renders it (turned a quarter)
+    constexpr int WIDTH = 400;
+    constexpr int HEIGHT = 240;
+
+    // Rows of a 4x4 matrix applied to column vectors, like C3D_Mtx
+    struct Matrix {
+        float r[4][4];
+    };
+    Matrix identity();
+    // what citro3d's functions of the same names make, for a right handed view
+    Matrix perspTilt(float fovy, float aspect, float near, float far);
+    Matrix perspStereoTilt(float fovy, float aspect, float near, float far, float iod, float screen);
+    // m times a rotation, which is what citro3d does with bRightSide. ThreeD::draw no longer goes through them (see Camera::modelView)
+    void rotateY(Matrix& m, float angle);
+    void rotate(Matrix& m, const float axis[3], float angle);
+
+    // The uniforms of program.v.pica and the rest of what a draw sets up
+    struct Uniforms {
+        Matrix projection, modelView;
+        float cameraPos[4];
+        float normal[3]; // the fixed attribute, see ThreeD::setNormal
+        float light[3]; // in view space, see C3D_LightPosition
+    };
+
+    // A texture as the GPU has it, see Atlas: clamped to its edges, or wrapping round like the patches of the floor have theirs
+    struct Texture {
+        const uint32_t* texels;
+        int width, height;
+        bool repeat;
+    };
+
+    // What a frame draws into: RGBA8 with the alpha in the low byte like textures, but in plain rows from the top left,
+    // and the depth of every pixel, 1 at the near plane and 0 at the far one (see C3D_DepthMap)
+    struct Target {
+        std::vector<uint32_t> color;
+        std::vector<float> depth;
+
+        Target();
+        // what C3D_RenderTargetClear does at the start of every frame
+        void clear(uint32_t rgba);
+    };
+
+    struct Stats {
+        long submitted; // triangles given to the GPU
+        long culled; // of those, the ones turned away or entirely out of sight
+        long pixels; // fragments that passed the depth test: past WIDTH * HEIGHT, the rest is overdraw
+    };
+
+    // What ThreeD::draw sets up for the level with the same arguments, and then for the crosshair
+    Uniforms levelUniforms(const Mesh::Layout& layout, float posX, float posZ, const Camera::Basis& camera, float iod);
+    Uniforms crosshairUniforms();
+
+    // quads [first, first + count) of vertices, as ThreeD::drawQuads submits them
+    void drawQuads(Target& target, const Uniforms& uniforms, const Texture& texture, const Vertex* vertices, int first, int count, Stats& stats);
+
+    // Everything ThreeD::draw draws with the same arguments, the walls, the chunks of each group of the floor Culling lets through,
+    // the cursor and the crosshair, on top of what target already holds.
+    // sprites and floor_textures, one for each group of the floor, are the textures ProgramWide binds
+    void draw(Target& target, const Mesh::Layout& layout, const Vertex* vertices, const Mesh::Floor& floor,
+              const Texture& sprites, const Texture floor_textures[Mesh::FLOOR_GROUPS], float posX, float posZ, const Camera::Basis& camera,
+              bool looking_at_floor, float iod, Stats& stats);
+
+    // target as a binary PPM, the alpha left out
+    bool writeImage(const char* path, const Target& target);
+};
@@ -0,0 +1,157 @@
+#include "replay.h"
+#include "bytes.h"
+
+namespace {
+    constexpr uint8_t MAGIC[4] = {'M', 'S', '3', 'R'};
+
+    bool same(const Play::Frame& a, const Play::Frame& b)
+    {
+        return a.down == b.down && a.held == b.held && a.touch_x == b.touch_x && a.touch_y == b.touch_y && a.worker_done == b.worker_done;
+    }
+}
+
+size_t Replay::memorySize()
+{
+    return MAX_RUNS * sizeof(Run) + MAX_FRAMES * sizeof(uint32_t);
+}
+
+void Replay::begin(Trace& trace, const Play& play)
+{
+    trace.seed = play.seed;
+    trace.abxy_look = play.abxy_look;
+    trace.dpad_look = play.dpad_look;
+    trace.y_axis_inverted = play.y_axis_inverted;
+    trace.in_controls = play.in_controls;
+    trace.editing_control_type = play.editing_control_type;
+    trace.rotate_speed_factor = play.rotate_speed_factor;
+    trace.start.clear();
+    Save::write(play.saved(), play.board, play.endless_board, trace.start);
+    trace.runs.clear();
+    trace.runs.reserve(MAX_RUNS);
+    trace.hashes.clear();
+    trace.hashes.reserve(MAX_FRAMES);
+}
+
+void Replay::record(Trace& trace, const Play::Frame& frame, const Play& play)
+{
+    if(trace.frames() == MAX_FRAMES)
+        return;
+    if(!trace.runs.empty() && same(trace.runs.back().frame, frame))
+        trace.runs.back().count++;
+    else if(int(trace.runs.size()) < MAX_RUNS)
+        trace.runs.push_back({frame, 1});
+    else
+        return;
+    trace.hashes.push_back(play.hash());
+}
+
+void Replay::write(const Trace& trace, std::vector<uint8_t>& out)
+{
+    Bytes::Writer writer = {out};
+    for(const uint8_t byte : MAGIC)
+        writer.u8(byte);
+    writer.u8(VERSION);
+    writer.u64(trace.seed);
+    writer.u8(uint8_t(trace.abxy_look | (trace.dpad_look << 1) | (trace.y_axis_inverted << 2) | (trace.in_controls << 3)));
+    writer.u8(uint8_t(trace.editing_control_type));
+    writer.f32(trace.rotate_speed_factor);
+    writer.u32(uint32_t(trace.start.size()));
+    for(const uint8_t byte : trace.start)
+        writer.u8(byte);
+
+    writer.u32(uint32_t(trace.runs.size()));
+    for(const Run& run : trace.runs)
+    {
+        writer.leb(run.count);
+        writer.u32(run.frame.down);
+        writer.u32(run.frame.held);
+        writer.u16(run.frame.touch_x);
+        writer.u16(run.frame.touch_y);
+        writer.u8(run.frame.worker_done);
+    }
+    writer.u32(uint32_t(trace.hashes.size()));
+    for(const uint32_t hash : trace.hashes)
+        writer.u32(hash);
+}
+
+bool Replay::read(const uint8_t* data, size_t size, Trace& trace)
+{
+    Bytes::Reader reader = {data, size, 0, true};
+    for(const uint8_t byte : MAGIC)
+    {
+        if(reader.u8() != byte)
+            return false;
+    }
+    if(reader.u8() != VERSION)
+        return false;
+
+    trace.seed = reader.u64();
+    const uint8_t controls = reader.u8();
+    trace.abxy_look = controls & 1;
+    trace.dpad_look = controls & 2;
+    trace.y_axis_inverted = controls & 4;
+    trace.in_controls = controls & 8;
+    const uint8_t editing = reader.u8();
+    trace.editing_control_type = Play::EditingControls(editing);
+    trace.rotate_speed_factor = reader.f32();
+    const uint32_t start_size = reader.u32();
+    if(!reader.ok || controls > 15 || editing > uint8_t(Play::EditingControls::Sensitivity) || start_size > size - reader.at)
+        return false;
+    trace.start.assign(data + reader.at, data + reader.at + start_size);
+    reader.at += start_size;
+
+    // a run takes at least 14 bytes
+    const uint32_t runs = reader.u32();
+    if(!reader.ok || runs > MAX_RUNS || runs > (size - reader.at) / 14)
+        return false;
+    trace.runs.resize(runs);
+    uint32_t frames = 0;
+    for(Run& run : trace.runs)
+    {
+        run.count = reader.leb();
+        run.frame.down = reader.u32();
+        run.frame.held = reader.u32();
+        run.frame.touch_x = reader.u16();
+        run.frame.touch_y = reader.u16();
+        const uint8_t worker_done = reader.u8();
+        run.frame.worker_done = worker_done;
+        if(!reader.ok || run.count == 0 || run.count > MAX_FRAMES || worker_done > 1)
+            return false;
+        frames += run.count;
+    }
+    if(reader.u32() != frames || frames > MAX_FRAMES || frames * sizeof(uint32_t) != size - reader.at)
+        return false;
+    trace.hashes.resize(frames);
+    for(uint32_t& hash : trace.hashes)
+        hash = reader.u32();
+    return reader.whole();
+}
+
+bool Replay::writeFile(const char* path, const Trace& trace)
+{
+    std::vector<uint8_t> data;
+    write(trace, data);
+    return Bytes::writeFile(path, data);
+}
+
+bool Replay::readFile(const char* path, Trace& trace)
+{
+    std::vector<uint8_t> data;
+    return Bytes::readFile(path, data) && read(data.data(), data.size(), trace);
+}
+
+bool Replay::restore(const Trace& trace, Play& play)
+{
+    Save::Game game;
+    if(!Save::read(trace.start.data(), trace.start.size(), game, play.board, play.endless_board, Mesh::WINDOW_SIZE))
+        return false;
+    play.restore(game);
+    play.seed = trace.seed;
+    play.abxy_look = trace.abxy_look;
+    play.dpad_look = trace.dpad_look;
+    play.y_axis_inverted = trace.y_axis_inverted;
+    play.in_controls = trace.in_controls;
+    play.editing_control_type = trace.editing_control_type;
+    play.rotate_speed_factor = trace.rotate_speed_factor;
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+// Recordings of levels, to play them again
+
+#include "play.h"
+
+#include <vector>
+#include <cstdint>
+
+// A trace is a level as it was when it could first be played, then every frame it got until it was left,
+// with Play::hash after each one: played again from the same start, a level goes through the same hashes.
+// All values are little-endian (see Bytes):
+//   "MS3R", version (1 byte), seed (8 bytes, see Play::seed), the controls settings (1 byte: abxy_look, dpad_look,
+//   y_axis_inverted and in_controls as bits 0 to 3, then 1 byte of editing_control_type and 4 of rotate_speed_factor),
+//   the size of the level as a save (4 bytes) and the save (see Save),
+//   the number of runs of frames (4 bytes), then for each run: how many frames in a row are the same (LEB128), down and held
+//   (4 bytes each), touch x and y (2 bytes each) and whether the worker was done (1 byte),
+//   and last the number of frames (4 bytes) and the hash after each one (4 bytes each).
+namespace Replay {
+    // Made bigger whenever the format changes, traces of other versions are refused
+    constexpr uint8_t VERSION = 1;
+    // What a trace keeps of a level, at most: buttons only change a few times a second,
+    // and 5 minutes at 60 frames a second. The frames past that aren't recorded
+    constexpr int MAX_RUNS = 4096;
+    constexpr int MAX_FRAMES = 5 * 60 * 60;
+
+    struct Run {
+        Play::Frame frame;
+        uint32_t count;
+    };
+
+    struct Trace {
+        uint64_t seed;
+        bool abxy_look, dpad_look, y_axis_inverted, in_controls;
+        Play::EditingControls editing_control_type;
+        float rotate_speed_factor;
+        std::vector<uint8_t> start; // see Save::write
+        std::vector<Run> runs;
+        std::vector<uint32_t> hashes;
+
+        int frames() const
+        {
+            return int(hashes.size());
+        }
+    };
+
+    // Heap a trace holds on to while its level is played, the start of the level left out (see Budget)
+    size_t memorySize();
+
+    // Starts trace over from play, whose level is prepared and has yet to get its first frame
+    void begin(Trace& trace, const Play& play);
+    // frame, which play was just updated with. Doesn't allocate, see MAX_FRAMES
+    void record(Trace& trace, const Play::Frame& frame, const Play& play);
+
+    void write(const Trace& trace, std::vector<uint8_t>& out);
+    // False if data isn't a whole trace of this version, trace may then hold anything
+    bool read(const uint8_t* data, size_t size, Trace& trace);
+    bool writeFile(const char* path, const Trace& trace);
+    bool readFile(const char* path, Trace& trace);
+
+    // Puts play, which hasn't played anything yet, back where trace began: its level is then still to be prepared
+    // (see Play::prepare). False if the start of trace can't be read
+    bool restore(const Trace& trace, Play& play);
+};
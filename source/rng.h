@@ -0,0 +1,67 @@
+#pragma once
+
+// Small deterministic PRNG, so that any board can be regenerated from its 64-bit seed.
+// xoshiro128** only needs 32-bit operations, which suits the ARM11, and is seeded through splitmix64.
+
+#include <cstdint>
+
+struct Rng {
+    uint32_t state[4];
+
+    static uint64_t splitmix64(uint64_t& x)
+    {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    explicit Rng(uint64_t seed)
+    {
+        const uint64_t a = splitmix64(seed);
+        const uint64_t b = splitmix64(seed);
+        state[0] = uint32_t(a);
+        state[1] = uint32_t(a >> 32);
+        state[2] = uint32_t(b);
+        state[3] = uint32_t(b >> 32);
+    }
+
+    uint32_t next()
+    {
+        const uint32_t result = rotl(state[1] * 5, 7) * 9;
+        const uint32_t t = state[1] << 9;
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+
+        state[2] ^= t;
+        state[3] = rotl(state[3], 11);
+
+        return result;
+    }
+
+    // Uniform in [0, bound), without modulo bias (Lemire's multiply and reject)
+    uint32_t below(uint32_t bound)
+    {
+        uint64_t m = uint64_t(next()) * bound;
+        uint32_t low = uint32_t(m);
+        if(low < bound)
+        {
+            const uint32_t threshold = -bound % bound;
+            while(low < threshold)
+            {
+                m = uint64_t(next()) * bound;
+                low = uint32_t(m);
+            }
+        }
+        return uint32_t(m >> 32);
+    }
+
+private:
+    static uint32_t rotl(uint32_t x, int k)
+    {
+        return (x << k) | (x >> (32 - k));
+    }
+};
@@ -0,0 +1,275 @@
+#include "save.h"
+#include "bytes.h"
+#include "solver.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    using Word = Board::Word;
+    constexpr int WORD_BITS = Board::WORD_BITS;
+    constexpr uint8_t MAGIC[4] = {'M', 'S', '3', 'D'};
+    constexpr int CHUNK_BITS = Endless::CHUNK_SIZE * Endless::CHUNK_SIZE;
+
+    enum Encoding : uint8_t {
+        Raw,
+        Runs,
+    };
+
+    // bits squares of plane, the bits past them being 0
+    void writePlane(Bytes::Writer& writer, const Word* plane, int bits)
+    {
+        // as runs first, thrown away for the raw bits if that's not shorter
+        std::vector<uint8_t>& out = writer.out;
+        const size_t start = out.size();
+        const size_t raw = size_t(bits + 7) / 8;
+        writer.u8(Runs);
+        bool value = false;
+        for(int square = 0; square < bits && out.size() - start <= raw; value = !value)
+        {
+            // the next square that isn't value, a word at a time
+            int next = square;
+            while(next < bits)
+            {
+                const Word differs = (plane[next / WORD_BITS] ^ (value ? ~Word(0) : Word(0))) >> (next % WORD_BITS);
+                if(differs)
+                {
+                    next += __builtin_ctz(differs);
+                    break;
+                }
+                next += WORD_BITS - next % WORD_BITS;
+            }
+            next = std::min(next, bits);
+            writer.leb(uint32_t(next - square));
+            square = next;
+        }
+        if(out.size() - start <= raw)
+            return;
+
+        out.resize(start);
+        writer.u8(Raw);
+        for(size_t byte = 0; byte < raw; byte++)
+            writer.u8(uint8_t(plane[byte / 4] >> ((byte % 4) * 8)));
+    }
+
+    // into plane, which has room for bits squares and is all 0
+    bool readPlane(Bytes::Reader& reader, Word* plane, int bits)
+    {
+        const uint8_t encoding = reader.u8();
+        if(encoding == Raw)
+        {
+            const int raw = (bits + 7) / 8;
+            for(int byte = 0; byte < raw; byte++)
+                plane[byte / 4] |= Word(reader.u8()) << ((byte % 4) * 8);
+            // nothing past the last square
+            const int used = bits % WORD_BITS;
+            if(used && plane[bits / WORD_BITS] >> used)
+                reader.ok = false;
+        }
+        else if(encoding == Runs)
+        {
+            bool value = false;
+            int square = 0;
+            while(square < bits && reader.ok)
+            {
+                const uint32_t run = reader.leb();
+                if(run > uint32_t(bits - square))
+                    reader.ok = false;
+                else if(value)
+                {
+                    for(int set = square; set < square + int(run); set++)
+                        plane[set / WORD_BITS] |= Word(1) << (set % WORD_BITS);
+                }
+                square += int(run);
+                value = !value;
+            }
+        }
+        else
+            reader.ok = false;
+        return reader.ok;
+    }
+
+    int popcount(const Word* plane, int words)
+    {
+        int count = 0;
+        for(int word = 0; word < words; word++)
+            count += __builtin_popcount(plane[word]);
+        return count;
+    }
+
+    // nothing open has a bomb, and nothing open has a flag: else the game was over, or it's not a save
+    bool playable(const Word* mine_bits, const Word* open_bits, const Word* flag_bits, int words)
+    {
+        for(int word = 0; word < words; word++)
+        {
+            if(open_bits[word] & (mine_bits[word] | flag_bits[word]))
+                return false;
+        }
+        return true;
+    }
+
+    struct PlayedChunk {
+        uint64_t key;
+        int cx, cy;
+        const Word* open_bits;
+        const Word* flag_bits;
+    };
+}
+
+void Save::write(const Game& game, const Board& board, const Endless& endless_board, std::vector<uint8_t>& out)
+{
+    Bytes::Writer writer = {out};
+    for(const uint8_t byte : MAGIC)
+        writer.u8(byte);
+    writer.u8(VERSION);
+    writer.u8(game.what);
+    writer.u8(game.bomb_percent);
+    writer.u16(uint16_t(game.width));
+    writer.u16(uint16_t(game.height));
+    writer.u64(game.seed);
+    writer.u16(uint16_t(game.first.x));
+    writer.u16(uint16_t(game.first.y));
+    writer.u32(uint32_t(game.origin_x));
+    writer.u32(uint32_t(game.origin_y));
+    writer.f32(game.angle_x);
+    writer.f32(game.angle_y);
+    writer.f32(game.position_x);
+    writer.f32(game.position_z);
+
+    if(!(game.what & Game::ENDLESS))
+    {
+        writePlane(writer, board.open_bits.data(), board.width * board.height);
+        writePlane(writer, board.flag_bits.data(), board.width * board.height);
+        return;
+    }
+
+    // the chunks in memory that were played on, and the ones kept after they went out of it,
+    // in the same order every time
+    std::vector<PlayedChunk> chunks;
+    for(const int chunk : endless_board.grid)
+    {
+        if(chunk < 0)
+            continue;
+        const Endless::Chunk& resident = endless_board.pool[chunk];
+        Word touched = 0;
+        for(int y = 0; y < Endless::CHUNK_SIZE; y++)
+            touched |= resident.open_bits[y] | resident.flag_bits[y];
+        if(touched)
+            chunks.push_back({Endless::keyOf(resident.cx, resident.cy), resident.cx, resident.cy, resident.open_bits, resident.flag_bits});
+    }
+    for(const auto& kept : endless_board.played)
+    {
+        const int cx = int(int32_t(uint32_t(kept.first >> 32)));
+        const int cy = int(int32_t(uint32_t(kept.first)));
+        chunks.push_back({kept.first, cx, cy, kept.second.open_bits, kept.second.flag_bits});
+    }
+    std::sort(chunks.begin(), chunks.end(), [](const PlayedChunk& a, const PlayedChunk& b) {
+        return a.key < b.key;
+    });
+
+    writer.u32(uint32_t(chunks.size()));
+    for(const PlayedChunk& chunk : chunks)
+    {
+        writer.u32(uint32_t(chunk.cx));
+        writer.u32(uint32_t(chunk.cy));
+        writePlane(writer, chunk.open_bits, CHUNK_BITS);
+        writePlane(writer, chunk.flag_bits, CHUNK_BITS);
+    }
+}
+
+bool Save::read(const uint8_t* data, size_t size, Game& game, Board& board, Endless& endless_board, int endless_size)
+{
+    Bytes::Reader reader = {data, size, 0, true};
+    for(const uint8_t byte : MAGIC)
+    {
+        if(reader.u8() != byte)
+            return false;
+    }
+    if(reader.u8() != VERSION)
+        return false;
+
+    game.what = reader.u8();
+    game.bomb_percent = reader.u8();
+    game.width = short(reader.u16());
+    game.height = short(reader.u16());
+    game.seed = reader.u64();
+    game.first.x = short(reader.u16());
+    game.first.y = short(reader.u16());
+    game.origin_x = int(int32_t(reader.u32()));
+    game.origin_y = int(int32_t(reader.u32()));
+    game.angle_x = reader.f32();
+    game.angle_y = reader.f32();
+    game.position_x = reader.f32();
+    game.position_z = reader.f32();
+    if(!reader.ok || game.bomb_percent > 100)
+        return false;
+
+    if(!(game.what & Game::ENDLESS))
+    {
+        if(game.width < 1 || game.height < 1 || game.width > MAX_SIDE || game.height > MAX_SIDE)
+            return false;
+        const bool generated = game.what & Game::GENERATED;
+        if(generated && (game.first.x < 0 || game.first.y < 0 || game.first.x >= game.width || game.first.y >= game.height))
+            return false;
+
+        // the same bombs as when it was played, see MineSweeper::generateBombs
+        board.reset(game.width, game.height, game.bomb_percent * game.width * game.height / 100);
+        if(generated && (game.what & Game::NO_GUESS))
+            NoGuess::generate(board, game.first, game.seed);
+        else if(generated)
+            board.generateBombs(game.first, game.seed);
+
+        const int bits = game.width * game.height;
+        const int words = int(board.open_bits.size());
+        if(!readPlane(reader, board.open_bits.data(), bits) || !readPlane(reader, board.flag_bits.data(), bits) || !reader.whole())
+            return false;
+        if(!playable(board.mine_bits.data(), board.open_bits.data(), board.flag_bits.data(), words))
+            return false;
+        // nothing can be played before the bombs are placed
+        const int opened = popcount(board.open_bits.data(), words);
+        board.flags_count = popcount(board.flag_bits.data(), words);
+        if(!generated && (opened || board.flags_count))
+            return false;
+        board.hidden_safe -= opened;
+        return true;
+    }
+
+    endless_board.reset(game.bomb_percent, game.seed, endless_size);
+    const uint32_t chunks = reader.u32();
+    // a chunk takes at least 10 bytes, cx, cy and two planes
+    if(!reader.ok || chunks > (size - reader.at) / 10)
+        return false;
+    for(uint32_t chunk = 0; chunk < chunks; chunk++)
+    {
+        const int cx = int(int32_t(reader.u32()));
+        const int cy = int(int32_t(reader.u32()));
+        const uint64_t key = Endless::keyOf(cx, cy);
+        if(!reader.ok || endless_board.played.count(key))
+            return false;
+
+        Endless::Played& kept = endless_board.played[key];
+        memset(&kept, 0, sizeof(kept));
+        if(!readPlane(reader, kept.open_bits, CHUNK_BITS) || !readPlane(reader, kept.flag_bits, CHUNK_BITS))
+            return false;
+        Word mine_bits[Endless::CHUNK_SIZE];
+        Endless::mines(endless_board.seed, endless_board.threshold, cx, cy, mine_bits);
+        if(!playable(mine_bits, kept.open_bits, kept.flag_bits, Endless::CHUNK_SIZE))
+            return false;
+        endless_board.opened += popcount(kept.open_bits, Endless::CHUNK_SIZE);
+        endless_board.flags_count += popcount(kept.flag_bits, Endless::CHUNK_SIZE);
+    }
+    return reader.whole();
+}
+
+bool Save::writeFile(const char* path, const Game& game, const Board& board, const Endless& endless_board)
+{
+    std::vector<uint8_t> data;
+    write(game, board, endless_board, data);
+    return Bytes::writeFile(path, data);
+}
+
+bool Save::readFile(const char* path, Game& game, Board& board, Endless& endless_board, int endless_size)
+{
+    std::vector<uint8_t> data;
+    return Bytes::readFile(path, data) && read(data.data(), data.size(), game, board, endless_board, endless_size);
+}
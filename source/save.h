@@ -0,0 +1,54 @@
+#pragma once
+
+// The save format of a game in progress
+
+#include "board.h"
+#include "endless.h"
+
+#include <vector>
+#include <cstdint>
+
+// A save is a header, then what the board has that its seed doesn't give back: the open and flag planes.
+// The bombs are made again from the seed, the same way as when the game was played.
+// All values are little-endian, whatever the machine:
+//   "MS3D", version (1 byte), what (1 byte, see Game), bomb percent (1 byte), width and height (2 bytes each),
+//   seed (8 bytes), first reveal x and y (2 bytes each), origin x and y (4 bytes each),
+//   angle x, angle y, position x, position z (4 bytes each, IEEE 754)
+// then for a board: its open plane and its flag plane,
+// and for an endless board: the number of chunks played on (4 bytes), then for each chunk cx and cy (4 bytes each),
+// its open plane and its flag plane.
+// A plane is 1 byte of encoding, then either its bits 8 to a byte (Raw),
+// or the lengths of the runs of 0s and 1s, alternating and starting with 0s, each as a LEB128 number (Runs):
+// whichever is shorter, so a plane never takes more than its bits and a byte.
+namespace Save {
+    // Made bigger whenever the format changes, saves of other versions are refused
+    constexpr uint8_t VERSION = 1;
+    // the biggest side of a board (see MineSweeper::MAX_SZ), bigger ones aren't read
+    constexpr int MAX_SIDE = 1000;
+
+    struct Game {
+        // what, a set of these
+        static constexpr uint8_t ENDLESS = 1; // an endless board, else a board of width x height
+        static constexpr uint8_t GENERATED = 2; // the bombs are placed, around first, from seed
+        static constexpr uint8_t NO_GUESS = 4; // placed by NoGuess::generate, else by Board::generateBombs
+        uint8_t what;
+        uint8_t bomb_percent;
+        short width, height;
+        uint64_t seed; // see Board::generateBombs, NoGuess::generate and Endless::reset
+        Coord first;
+        int origin_x, origin_y; // see MineSweeper::endlessSquare
+        float angle_x, angle_y, position_x, position_z;
+    };
+
+    // Appends the save of game to out, with board or endless_board depending on game.what
+    void write(const Game& game, const Board& board, const Endless& endless_board, std::vector<uint8_t>& out);
+    // Gives back game and its board as they were written: board is reset to it, or endless_board is (with room for rectangles
+    // up to endless_size squares a side, see Endless::reset), with nothing of it in memory yet.
+    // False if data isn't a whole save of this version, the game and both boards may then hold anything
+    bool read(const uint8_t* data, size_t size, Game& game, Board& board, Endless& endless_board, int endless_size);
+
+    // The same through a file, which is written next to path first and then renamed over it,
+    // so that a save cut short by a crash doesn't replace the last one. False if it couldn't be written or read
+    bool writeFile(const char* path, const Game& game, const Board& board, const Endless& endless_board);
+    bool readFile(const char* path, Game& game, Board& board, Endless& endless_board, int endless_size);
+};
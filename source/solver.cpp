@@ -0,0 +1,463 @@
+#include "solver.h"
+#include "rng.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+namespace {
+    #define XY_TO_IDX(x, y, m) ((x) + ((y) * (m)->width))
+    #define IDX_TO_X(idx, m) ((idx) % (m)->width)
+    #define IDX_TO_Y(idx, m) ((idx) / (m)->width)
+
+    // Two numbers are looked at together in a 7x7 frame around the first one, bit c + r * 7 being square (c - 3, r - 3) from it
+    constexpr int FRAME_SIZE = 7;
+
+    // every 3x3 mask with its rows 7 bits apart instead of 3, built at compile time
+    struct Spread {
+        uint32_t rows[1 << 9];
+
+        constexpr Spread() : rows()
+        {
+            for(int mask = 0; mask < (1 << 9); mask++)
+            {
+                for(int row = 0; row < 3; row++)
+                    rows[mask] |= uint32_t((mask >> (row * 3)) & 7) << (row * FRAME_SIZE);
+            }
+        }
+    };
+    constexpr Spread spread;
+
+    uint64_t toFrame(int mask, int dx, int dy)
+    {
+        return uint64_t(spread.rows[mask]) << ((dy + 2) * FRAME_SIZE + (dx + 2));
+    }
+
+    // how many boards are tried before giving up
+    constexpr int MAX_BOARDS = 16;
+}
+
+size_t Solver::memorySize(int width, int height)
+{
+    // state, in_work, in_pairs, hidden_masks and bombs_left, then work, pairs and flood_stack can each hold the whole board
+    const size_t size = size_t(width) * height;
+    return size * (3 + sizeof(uint16_t) + sizeof(int8_t)) + size * 3 * sizeof(int);
+}
+
+void Solver::start(const Board& on, Coord first)
+{
+    board = &on;
+    const int size = board->width * board->height;
+    state.assign(size, Hidden);
+    hidden_masks.resize(size);
+    bombs_left.resize(size);
+    for(int y = 0; y < board->height; y++)
+    {
+        // every neighbour on the board is hidden
+        const int rows = (y == 0 ? 0b110 : 0b111) & (y == board->height - 1 ? 0b011 : 0b111);
+        for(int x = 0; x < board->width; x++)
+        {
+            const int columns = (x == 0 ? 0b110 : 0b111) & (x == board->width - 1 ? 0b011 : 0b111);
+            int mask = 0;
+            for(int row = 0; row < 3; row++)
+            {
+                if(rows & (1 << row))
+                    mask |= columns << (row * 3);
+            }
+            const int square = XY_TO_IDX(x, y, board);
+            hidden_masks[square] = uint16_t(mask);
+            bombs_left[square] = int8_t(board->count(square));
+        }
+    }
+    in_work.assign(size, 0);
+    in_pairs.assign(size, 0);
+    work.clear();
+    work.reserve(size);
+    pairs.clear();
+    pairs.reserve(size);
+    flood_stack.clear();
+    flood_stack.reserve(size);
+
+    int mines = 0;
+    for(const Board::Word word : board->mine_bits)
+        mines += __builtin_popcount(word);
+    hidden = size;
+    hidden_safe = size - mines;
+    mines_left = mines;
+
+    open(board->index(first));
+}
+
+void Solver::touch(int square)
+{
+    // the numbers around it, itself included, have something new to go on
+    const int x = IDX_TO_X(square, board);
+    const int y = IDX_TO_Y(square, board);
+    for(int ny = std::max(y - 1, 0); ny <= std::min(y + 1, board->height - 1); ny++)
+    {
+        for(int nx = std::max(x - 1, 0); nx <= std::min(x + 1, board->width - 1); nx++)
+            look(XY_TO_IDX(nx, ny, board));
+    }
+}
+
+void Solver::look(int square)
+{
+    if(state[square] != Open || board->count(square) == 0)
+        return;
+    if(!in_work[square])
+    {
+        in_work[square] = 1;
+        work.push_back(square);
+    }
+    if(!in_pairs[square])
+    {
+        in_pairs[square] = 1;
+        pairs.push_back(square);
+    }
+}
+
+void Solver::found(int x, int y, bool mine)
+{
+    // one pass over the neighbours: they see one hidden square less, and get looked at again
+    for(int ny = std::max(y - 1, 0); ny <= std::min(y + 1, board->height - 1); ny++)
+    {
+        for(int nx = std::max(x - 1, 0); nx <= std::min(x + 1, board->width - 1); nx++)
+        {
+            const int idx = XY_TO_IDX(nx, ny, board);
+            // (x, y) is at (x - nx, y - ny) from its neighbour
+            hidden_masks[idx] &= ~(1 << ((x - nx + 1) + (y - ny + 1) * 3));
+            if(mine)
+                bombs_left[idx]--;
+            look(idx);
+        }
+    }
+}
+
+void Solver::bump(int square, int delta)
+{
+    const int x = IDX_TO_X(square, board);
+    const int y = IDX_TO_Y(square, board);
+    for(int ny = std::max(y - 1, 0); ny <= std::min(y + 1, board->height - 1); ny++)
+    {
+        for(int nx = std::max(x - 1, 0); nx <= std::min(x + 1, board->width - 1); nx++)
+            bombs_left[XY_TO_IDX(nx, ny, board)] += delta;
+    }
+    touch(square);
+}
+
+void Solver::moved(int from, int to)
+{
+    bump(from, -1);
+    bump(to, +1);
+}
+
+void Solver::open(int square)
+{
+    assert(!board->isMine(square));
+    // same as Board::checkAround
+    state[square] = Open;
+    hidden--;
+    hidden_safe--;
+    flood_stack.push_back(square);
+    while(!flood_stack.empty())
+    {
+        const int pos = flood_stack.back();
+        flood_stack.pop_back();
+        const int x = IDX_TO_X(pos, board);
+        const int y = IDX_TO_Y(pos, board);
+        found(x, y, false);
+        if(board->count(pos) != 0)
+            continue;
+
+        for(int ny = std::max(y - 1, 0); ny <= std::min(y + 1, board->height - 1); ny++)
+        {
+            for(int nx = std::max(x - 1, 0); nx <= std::min(x + 1, board->width - 1); nx++)
+            {
+                const int idx = XY_TO_IDX(nx, ny, board);
+                if(state[idx] == Hidden)
+                {
+                    state[idx] = Open;
+                    hidden--;
+                    hidden_safe--;
+                    flood_stack.push_back(idx);
+                }
+            }
+        }
+    }
+}
+
+void Solver::markMine(int square)
+{
+    assert(board->isMine(square));
+    state[square] = Mine;
+    found(IDX_TO_X(square, board), IDX_TO_Y(square, board), true);
+    hidden--;
+    mines_left--;
+}
+
+void Solver::settle(int square, uint64_t frame, bool mines)
+{
+    const int x = IDX_TO_X(square, board);
+    const int y = IDX_TO_Y(square, board);
+    while(frame)
+    {
+        const int bit = __builtin_ctzll(frame);
+        frame &= frame - 1;
+        const int idx = XY_TO_IDX(x + bit % FRAME_SIZE - 3, y + bit / FRAME_SIZE - 3, board);
+        // an opening may have got there first
+        if(state[idx] != Hidden)
+            continue;
+        if(mines)
+            markMine(idx);
+        else
+            open(idx);
+    }
+}
+
+bool Solver::single(int square)
+{
+    int left;
+    const int mask = hiddenAround(square, left);
+    if(!mask)
+        return false;
+
+    if(left == 0)
+        settle(square, toFrame(mask, 0, 0), false);
+    else if(left == __builtin_popcount(mask))
+        settle(square, toFrame(mask, 0, 0), true);
+    else
+        return false;
+    return true;
+}
+
+bool Solver::pairsOf(int square)
+{
+    int left;
+    const int mask = hiddenAround(square, left);
+    if(!mask)
+        return false;
+
+    const uint64_t frame = toFrame(mask, 0, 0);
+    const int x = IDX_TO_X(square, board);
+    const int y = IDX_TO_Y(square, board);
+    for(int dy = -2; dy <= 2; dy++)
+    {
+        for(int dx = -2; dx <= 2; dx++)
+        {
+            const int nx = x + dx, ny = y + dy;
+            if((dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= board->width || ny >= board->height)
+                continue;
+            const int other = XY_TO_IDX(nx, ny, board);
+            if(state[other] != Open || board->count(other) == 0)
+                continue;
+            int other_left;
+            const int other_mask = hiddenAround(other, other_left);
+            if(!other_mask)
+                continue;
+
+            const uint64_t other_frame = toFrame(other_mask, dx, dy);
+            const uint64_t shared = frame & other_frame;
+            if(!shared)
+                continue;
+
+            // the bombs in the shared squares are bounded by both numbers, the rest of each number's bombs go on its own squares
+            const uint64_t only = frame & ~shared, other_only = other_frame & ~shared;
+            const int shared_count = __builtin_popcountll(shared);
+            const int only_count = __builtin_popcountll(only), other_only_count = __builtin_popcountll(other_only);
+            const int most_shared = std::min(std::min(left, other_left), shared_count);
+            const int least_shared = std::max(std::max(0, left - only_count), other_left - other_only_count);
+
+            if(other_only && other_left - most_shared == other_only_count)
+                settle(square, other_only, true);
+            else if(other_only && other_left - least_shared == 0)
+                settle(square, other_only, false);
+            else if(only && left - most_shared == only_count)
+                settle(square, only, true);
+            else if(only && left - least_shared == 0)
+                settle(square, only, false);
+            else
+                continue;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Solver::global()
+{
+    if(hidden == 0 || (mines_left != 0 && mines_left != hidden))
+        return false;
+
+    const bool mines = mines_left != 0;
+    const int size = board->width * board->height;
+    for(int square = 0; square < size; square++)
+    {
+        if(state[square] != Hidden)
+            continue;
+        if(mines)
+            markMine(square);
+        else
+            open(square);
+    }
+    return true;
+}
+
+bool Solver::run()
+{
+    for(;;)
+    {
+        while(!work.empty())
+        {
+            const int square = work.back();
+            work.pop_back();
+            in_work[square] = 0;
+            single(square);
+        }
+        if(hidden_safe == 0)
+            return true;
+
+        // one pair deduction at a time, the single square rules are cheaper to follow it up with
+        bool found = false;
+        while(!pairs.empty() && !found)
+        {
+            const int square = pairs.back();
+            pairs.pop_back();
+            in_pairs[square] = 0;
+            found = pairsOf(square);
+        }
+        if(found || global())
+            continue;
+        return false;
+    }
+}
+
+int Solver::stuckOn(uint32_t from) const
+{
+    const int size = board->width * board->height;
+    for(int i = 0; i < size; i++)
+    {
+        const int square = int((from + i) % size);
+        int left;
+        if(state[square] == Open && board->count(square) != 0 && hiddenAround(square, left))
+            return square;
+    }
+    return -1;
+}
+
+bool Solver::unknown(int square) const
+{
+    // hidden, and not next to anything open: nothing the solver learnt depends on it
+    if(state[square] != Hidden)
+        return false;
+    const int x = IDX_TO_X(square, board);
+    const int y = IDX_TO_Y(square, board);
+    for(int ny = std::max(y - 1, 0); ny <= std::min(y + 1, board->height - 1); ny++)
+    {
+        for(int nx = std::max(x - 1, 0); nx <= std::min(x + 1, board->width - 1); nx++)
+        {
+            if(state[XY_TO_IDX(nx, ny, board)] == Open)
+                return false;
+        }
+    }
+    return true;
+}
+
+namespace {
+    // A square for a bomb taken away from around stuck: hidden, without a bomb and not next to stuck,
+    // best if the solver knows nothing about it. Next to an open number, it only makes that number bigger:
+    // what the solver learnt still holds, whether it can be found from scratch is checked in the end.
+    // A few random tries, then the first one along from a random square; -1 if there's none
+    int bombSpot(const Board& board, const Solver& solver, Rng& rng, int stuck)
+    {
+        const int size = board.width * board.height;
+        const auto free = [&](int square) {
+            return solver.state[square] == Solver::Hidden && !board.isMine(square) &&
+                   (abs(square % board.width - stuck % board.width) > 1 || abs(square / board.width - stuck / board.width) > 1);
+        };
+        for(int tries = 0; tries < 16; tries++)
+        {
+            const int square = int(rng.below(size));
+            if(free(square) && solver.unknown(square))
+                return square;
+        }
+        const int start = int(rng.below(size));
+        int fallback = -1;
+        for(int i = 0; i < size; i++)
+        {
+            const int square = (start + i) % size;
+            if(!free(square))
+                continue;
+            if(solver.unknown(square))
+                return square;
+            if(fallback < 0)
+                fallback = square;
+        }
+        return fallback;
+    }
+
+    // Moves every bomb around a number the solver is stuck on somewhere else:
+    // the number then has all its bombs found, and all its hidden neighbours safe
+    bool repair(Board& board, Solver& solver, Rng& rng)
+    {
+        const int size = board.width * board.height;
+        const int stuck = solver.stuckOn(rng.below(size));
+        if(stuck < 0)
+            return false;
+
+        const int x = stuck % board.width;
+        const int y = stuck / board.width;
+        for(int ny = std::max(y - 1, 0); ny <= std::min(y + 1, board.height - 1); ny++)
+        {
+            for(int nx = std::max(x - 1, 0); nx <= std::min(x + 1, board.width - 1); nx++)
+            {
+                const int from = nx + ny * board.width;
+                if(solver.state[from] != Solver::Hidden || !board.isMine(from))
+                    continue;
+
+                const int to = bombSpot(board, solver, rng, stuck);
+                if(to < 0)
+                    return false;
+
+                board.moveMine(from, to);
+                solver.moved(from, to);
+            }
+        }
+        return true;
+    }
+}
+
+bool NoGuess::generate(Board& board, Coord safe, uint64_t seed, Stats* stats)
+{
+    Stats counted = {0, 0, 0};
+    Solver solver;
+    Rng rng(seed);
+    // the first board is the one Board::generateBombs gives for this seed, in case it needs no guessing already
+    uint64_t board_seed = seed;
+    bool solved = false;
+    for(int attempt = 0; attempt < MAX_BOARDS && !solved; attempt++)
+    {
+        board.generateBombs(safe, board_seed);
+        board_seed = Rng::splitmix64(board_seed);
+        counted.boards++;
+        counted.solves++;
+        solved = solver.solve(board, safe);
+        // a bomb can end up going back and forth between two numbers the solver is stuck on,
+        // a new board is better than more repairs once there have been as many as bombs
+        for(int repairs = 0; !solved && repairs < board.bombs && repair(board, solver, rng); repairs++)
+        {
+            counted.repairs++;
+            // what was learnt before the bombs moved still holds, but may not be found the same way from scratch
+            if(solver.run())
+            {
+                counted.solves++;
+                solved = solver.solve(board, safe);
+            }
+        }
+    }
+
+    // the seed this board comes back from, through generate
+    board.seed = seed;
+    if(stats)
+        *stats = counted;
+    return solved;
+}
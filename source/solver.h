@@ -0,0 +1,95 @@
+#pragma once
+
+// Minesweeper solver and no-guess board generation
+
+#include "board.h"
+
+#include <vector>
+#include <cstdint>
+
+// Plays a board the way a player that never guesses would, from its first click:
+// it only ever looks at the counts of the squares it opened, and at how many bombs there are in total.
+// Deductions, cheapest first:
+// - a number whose bombs are all found has its other hidden neighbours safe, one whose hidden neighbours are all needed has them all bombs
+// - two numbers up to 2 squares apart bound how many bombs the hidden squares they share have,
+//   which can settle the squares only one of them sees (subset reasoning, and the 1-2-1 kind of patterns)
+// - no bombs left means every hidden square is safe, as many as hidden squares means they're all bombs
+// Every square is looked at again only when one of its neighbours changed.
+struct Solver {
+    enum State : uint8_t {
+        Hidden,
+        Open, // found safe, and opened
+        Mine, // found to be a bomb
+    };
+
+    const Board* board;
+    std::vector<uint8_t> state;
+    // for every square, its hidden neighbours as a 3x3 mask, bit (dx + 1) + (dy + 1) * 3,
+    // and how many of the bombs it counts aren't found yet; kept up to date as squares are found
+    std::vector<uint16_t> hidden_masks;
+    std::vector<int8_t> bombs_left;
+    // numbers to look at with the single square rules, and with the pair rules
+    std::vector<int> work, pairs;
+    std::vector<uint8_t> in_work, in_pairs;
+    std::vector<int> flood_stack;
+    int hidden; // squares still Hidden
+    int hidden_safe; // of which without a bomb, solved at 0
+    int mines_left; // bombs not found yet
+
+    Solver() : board(nullptr), hidden(0), hidden_safe(0), mines_left(0) { }
+
+    // Forgets everything and opens first, which has to be safe
+    void start(const Board& on, Coord first);
+    // Deduces as much as it can, true when every safe square is open
+    bool run();
+    bool solve(const Board& on, Coord first)
+    {
+        start(on, first);
+        return run();
+    }
+
+    // The bomb of square from moved to square to (see Board::moveMine): the numbers next to both are looked at again
+    void moved(int from, int to);
+    // An open number with hidden neighbours, the first one along from square from, -1 if there's none
+    int stuckOn(uint32_t from) const;
+    // Whether square is hidden and nothing open is next to it, so that nothing learnt depends on it
+    bool unknown(int square) const;
+    int hiddenAround(int square, int& left) const
+    {
+        left = bombs_left[square];
+        return hidden_masks[square];
+    }
+
+    // bytes a width x height board needs
+    static size_t memorySize(int width, int height);
+
+private:
+    void open(int square);
+    void markMine(int square);
+    void touch(int square);
+    // an open number among them goes back on both worklists
+    void look(int square);
+    // the square at (x, y) isn't hidden anymore
+    void found(int x, int y, bool mine);
+    void bump(int square, int delta);
+    // frame is a set of squares around square, see toFrame in solver.cpp
+    void settle(int square, uint64_t frame, bool mines);
+    bool single(int square);
+    bool pairsOf(int square);
+    bool global();
+};
+
+namespace NoGuess {
+    struct Stats {
+        int boards; // boards generated from scratch
+        int repairs; // bombs moved away from where the solver got stuck
+        int solves; // runs of the solver from scratch
+    };
+
+    // Gives board bombs that the solver can find without guessing from safe, starting from Board::generateBombs:
+    // where the solver gets stuck, the bombs around a number it's stuck on are moved to squares it knows nothing about,
+    // and that's done again until the solver gets through from scratch, or a new board is generated when there's no room left.
+    // The same seed always gives the same board, and is left in board.seed.
+    // False if it gave up, the board then still has every bomb but may need guessing
+    bool generate(Board& board, Coord safe, uint64_t seed, Stats* stats = nullptr);
+};
@@ -1,4 +1,8 @@
 #include "verts.h"
+#include "arena.h"
+#include "atlas.h"
+#include "budget.h"
+#include "culling.h"
 
 #include "program_shbin.h"
 
@@ -11,6 +15,12 @@ namespace ProgramWide {
     int uLoc_projection, uLoc_modelView, uLoc_cameraPos;
     C3D_Mtx constant_projection;
     C3D_Tex* sprites_tex = nullptr;
+    // shared by every batch of every level, see Mesh::BATCH_QUADS
+    u16* quad_indices = nullptr;
+    C3D_Tex floor_tex;
+    // the textures of the floor's patches, see Mesh::Floor
+    C3D_Tex repeat_texs[Mesh::REPEATING];
+    bool floor_tex_ready = false;
 
     void init(C3D_Tex* tex)
     {
@@ -24,28 +34,96 @@ namespace ProgramWide {
         uLoc_modelView    = shaderInstanceGetUniformLocation(program.vertexShader, "modelView");
         uLoc_cameraPos    = shaderInstanceGetUniformLocation(program.vertexShader, "cameraPos");
 
-        Mtx_PerspTilt(&constant_projection, C3D_AngleFromDegrees(50.0f), C3D_AspectRatioTop, 0.01f, 100.0f, false);
+        quad_indices = static_cast<u16*>(linearAlloc(sizeof(u16) * Mesh::BATCH_QUADS * Mesh::QUAD_INDICES));
+        Mesh::fillIndices(quad_indices, Mesh::BATCH_QUADS);
+
+        Mtx_PerspTilt(&constant_projection, C3D_AngleFromDegrees(Culling::FOV_Y_DEGREES), C3D_AspectRatioTop, 0.01f, 100.0f, false);
 
         // C3D_TexSetFilter(sprites_tex, GPU_LINEAR, GPU_NEAREST);
     }
 
+    void composeFloorTiles(const Tex3DS_SubTexture* const tiles[][2], int count, const int repeating[Mesh::REPEATING])
+    {
+        // the floor sprites are all 32x32, laid out the way Mesh::floorTileUVs has them
+        constexpr int TILE_SIZE = Mesh::FLOOR_TILE_TEXELS;
+        constexpr int TILES_PER_ROW = Mesh::FLOOR_ATLAS_COLUMNS;
+        constexpr int tex_width = Mesh::FLOOR_ATLAS_WIDTH;
+        const int tex_height = Mesh::floorAtlasHeight(count);
+
+        if(floor_tex_ready)
+        {
+            C3D_TexDelete(&floor_tex);
+            for(C3D_Tex& repeat_tex : repeat_texs)
+                C3D_TexDelete(&repeat_tex);
+        }
+        C3D_TexInit(&floor_tex, tex_width, tex_height, GPU_RGBA8);
+        floor_tex.param = sprites_tex->param; // sampled just like the sprite sheet
+        for(C3D_Tex& repeat_tex : repeat_texs)
+        {
+            C3D_TexInit(&repeat_tex, TILE_SIZE * Mesh::REPEAT_COPIES, TILE_SIZE * Mesh::REPEAT_COPIES, GPU_RGBA8);
+            repeat_tex.param = sprites_tex->param;
+            C3D_TexSetWrap(&repeat_tex, GPU_REPEAT, GPU_REPEAT);
+        }
+        floor_tex_ready = true;
+
+        const u32* src = static_cast<const u32*>(sprites_tex->data);
+        u32* dst = static_cast<u32*>(floor_tex.data);
+        const auto texel_x = [](const Tex3DS_SubTexture* subtex) { return int(subtex->left * sprites_tex->width + 0.5f); };
+        const auto texel_y = [](const Tex3DS_SubTexture* subtex) { return int(subtex->bottom * sprites_tex->height + 0.5f); };
+        for(int tile = 0; tile < count; tile++)
+        {
+            const int x = (tile % TILES_PER_ROW) * TILE_SIZE;
+            const int y = (tile / TILES_PER_ROW) * TILE_SIZE;
+            const Tex3DS_SubTexture* base = tiles[tile][0];
+            const Tex3DS_SubTexture* overlay = tiles[tile][1];
+            Atlas::compose(src, sprites_tex->width, texel_x(base), texel_y(base), texel_x(overlay), texel_y(overlay),
+                           dst, tex_width, x, y, TILE_SIZE);
+        }
+        C3D_TexFlush(&floor_tex);
+
+        for(int group = 0; group < Mesh::REPEATING; group++)
+        {
+            const Tex3DS_SubTexture* base = tiles[repeating[group]][0];
+            const Tex3DS_SubTexture* overlay = tiles[repeating[group]][1];
+            C3D_Tex& repeat_tex = repeat_texs[group];
+            for(int copy = 0; copy < Mesh::REPEAT_COPIES * Mesh::REPEAT_COPIES; copy++)
+            {
+                Atlas::compose(src, sprites_tex->width, texel_x(base), texel_y(base), texel_x(overlay), texel_y(overlay),
+                               static_cast<u32*>(repeat_tex.data), repeat_tex.width,
+                               copy % Mesh::REPEAT_COPIES * TILE_SIZE, copy / Mesh::REPEAT_COPIES * TILE_SIZE, TILE_SIZE);
+            }
+            C3D_TexFlush(&repeat_tex);
+        }
+    }
+
     void exit()
     {
+        if(floor_tex_ready)
+        {
+            C3D_TexDelete(&floor_tex);
+            for(C3D_Tex& repeat_tex : repeat_texs)
+                C3D_TexDelete(&repeat_tex);
+            floor_tex_ready = false;
+        }
         if(program_dvlb)
         {
             shaderProgramFree(&program);
             DVLB_Free(program_dvlb);
+            linearFree(quad_indices);
             program_dvlb = nullptr;
             sprites_tex = nullptr;
+            quad_indices = nullptr;
         }
     }
 };
 
 namespace LevelWide {
-    void* vbo_data = nullptr;
+    // the geometry of every level one after another, see reserve
+    Arena arena({&linearAlloc, &linearFree});
     Vertex* vertex_ptr = nullptr;
-    size_t vertex_count = 0;
-    int width = 0, height = 0;
+    Mesh::Layout layout(0, 0);
+    // floor chunks of a group in sight of the eye being drawn, refilled for each one on every ThreeD::draw
+    std::vector<Culling::Range> visible_ranges;
 
     C3D_FogLut fog_Lut;
 
@@ -64,26 +142,24 @@ namespace LevelWide {
     C3D_FVec lightPos = FVec4_New(0.0f, 0.0f, 0.0f, 1.0f);
 
     C3D_AttrInfo vbo_attrInfo;
-    C3D_BufInfo vbo_bufInfo;
 
-    void init(size_t count, int w, int h)
+    bool init(const Mesh::Layout& window)
     {
         // Configure attributes for use with the vertex shader
         AttrInfo_Init(&vbo_attrInfo);
-        AttrInfo_AddLoader(&vbo_attrInfo, 0, GPU_FLOAT, 3); // v0=position
-        AttrInfo_AddLoader(&vbo_attrInfo, 1, GPU_FLOAT, 2); // v1=texcoord
-        AttrInfo_AddLoader(&vbo_attrInfo, 2, GPU_FLOAT, 3); // v2=normal
+        AttrInfo_AddLoader(&vbo_attrInfo, 0, GPU_SHORT, 3); // v0=position
+        AttrInfo_AddLoader(&vbo_attrInfo, 1, GPU_SHORT, 2); // v1=texcoord
+        AttrInfo_AddFixed(&vbo_attrInfo, 2); // v2=normal, set per draw
 
         // Create and fill the VBO (vertex buffer object)
-        vertex_count = count;
-        width = w;
-        height = h;
-        vbo_data = linearAlloc(sizeof(Vertex) * count);
-        vertex_ptr = static_cast<Vertex*>(vbo_data);
-
-        // Configure buffers
-        BufInfo_Init(&vbo_bufInfo);
-        BufInfo_Add(&vbo_bufInfo, vbo_data, sizeof(Vertex), 3, 0x210);
+        // the buffers are configured per batch in ThreeD::drawQuads
+        layout = window;
+        // only goes back to linearAlloc if reserve couldn't have the biggest
+        const size_t bytes = sizeof(Vertex) * layout.quads() * Mesh::QUAD_VERTICES;
+        if(!arena.reserve(bytes))
+            return false;
+        vertex_ptr = static_cast<Vertex*>(arena.take(bytes));
+        visible_ranges.reserve(size_t(layout.chunks_x) * layout.chunks_y);
 
         C3D_LightEnvInit(&lightEnv);
         C3D_LightEnvMaterial(&lightEnv, &material);
@@ -93,45 +169,87 @@ namespace LevelWide {
 
         C3D_LightInit(&light, &lightEnv);
         C3D_LightColor(&light, 1.0f, 1.0f, 1.0f);
+        return true;
+    }
+
+    void move(const Mesh::Layout& window)
+    {
+        // every window of a board is the same size, see Mesh::window
+        assert(window.quads() == layout.quads());
+        layout = window;
     }
 
-    Vertex* get_floor_verts()
+    const Mesh::Layout& get_layout()
     {
-        return &vertex_ptr[(width * 2 + height * 2) * 6];
+        return layout;
     }
-    Vertex* get_wall_verts()
+
+    Vertex* get_vertices()
     {
         return vertex_ptr;
     }
-    Vertex* get_cursor_verts()
+
+    bool reserve()
     {
-        return &vertex_ptr[vertex_count - (2 * 6)];
+        return arena.reserve(Budget::geometry());
     }
-    Vertex* get_crosshair_verts()
+
+    size_t reserved()
     {
-        return &vertex_ptr[vertex_count - (1 * 6)];
+        return arena.capacity();
     }
 
     void exit()
     {
-        if(vbo_data)
+        if(vertex_ptr)
         {
-            linearFree(vbo_data);
-            vbo_data = nullptr;
+            DEBUGPRINT("level geometry: %zu bytes, at most %zu of %zu\n", arena.used(), arena.highWater(), arena.capacity());
+            arena.reset();
             vertex_ptr = nullptr;
         }
     }
+
+    void release()
+    {
+        exit();
+        arena.release();
+    }
 };
 
 namespace ThreeD {
+    void setNormal(float x, float y, float z)
+    {
+        C3D_FVec* normal = C3D_FixedAttribGetWritePtr(2);
+        normal->x = x;
+        normal->y = y;
+        normal->z = z;
+        normal->w = 0.0f;
+    }
+
+    // Draws quads [first, first + count) of the level, one batch at a time:
+    // each batch gets the vertex buffer rebased onto its first quad, since the indices only go up to Mesh::BATCH_QUADS quads
+    void drawQuads(int first, int count)
+    {
+        while(count > 0)
+        {
+            const int batch = count < Mesh::BATCH_QUADS ? count : Mesh::BATCH_QUADS;
+            C3D_BufInfo* bufInfo = C3D_GetBufInfo();
+            BufInfo_Init(bufInfo);
+            BufInfo_Add(bufInfo, &LevelWide::vertex_ptr[first * Mesh::QUAD_VERTICES], sizeof(Vertex), 2, 0x10);
+            C3D_DrawElements(GPU_TRIANGLES, batch * Mesh::QUAD_INDICES, C3D_UNSIGNED_SHORT, ProgramWide::quad_indices);
+
+            first += batch;
+            count -= batch;
+        }
+    }
+
     void bind()
     {
         C3D_BindProgram(&ProgramWide::program);
         C3D_SetAttrInfo(&LevelWide::vbo_attrInfo);
-        C3D_SetBufInfo(&LevelWide::vbo_bufInfo);
         C3D_LightEnvBind(&LevelWide::lightEnv);
 
-        FogLut_Exp(&LevelWide::fog_Lut, 0.05f, 1.5f, 1.0f/50.0f, 75.0f);
+        FogLut_Exp(&LevelWide::fog_Lut, 0.05f, 1.5f, 1.0f/50.0f, Culling::FOG_END);
         C3D_FogGasMode(GPU_FOG, GPU_PLAIN_DENSITY, false);
         C3D_FogColor(0xD8B068);
         C3D_FogLutBind(&LevelWide::fog_Lut);
@@ -160,35 +278,71 @@ namespace ThreeD {
         C3D_TexEnvInit(C3D_GetTexEnv(5));
     }
 
-    void draw(float posX, float posZ, float angleX, float angleY, bool looking_at_floor, float iod)
+    void draw(const Mesh::Floor& floor, float posX, float posZ, const Camera::Basis& camera, bool looking_at_floor, float iod)
     {
         C3D_Mtx projection;
         if(iod == 0.0f)
             Mtx_Copy(&projection, &ProgramWide::constant_projection);
         else
-            Mtx_PerspStereoTilt(&projection, C3D_AngleFromDegrees(50.0f), C3D_AspectRatioTop, 0.01f, 100.0f, iod, 2.0f, false);
+            Mtx_PerspStereoTilt(&projection, C3D_AngleFromDegrees(Culling::FOV_Y_DEGREES), C3D_AspectRatioTop, 0.01f, 100.0f, iod, 2.0f, false);
 
-        // Calculate the modelView matrix
+        // The modelView matrix, straight from the camera's trig rather than through Mtx_RotateY and Mtx_Rotate
+        float rows[4][4];
+        Camera::modelView(camera, rows);
         C3D_Mtx modelView;
-        Mtx_Identity(&modelView);
-        const auto angle = C3D_AngleFromDegrees(angleX - 90);
-        const auto dir = FVec3_New(cosf(angle), 0.0f, sinf(angle));
-        Mtx_RotateY(&modelView, angle, true);
-        Mtx_Rotate(&modelView, dir, C3D_AngleFromDegrees(-angleY), true);
+        for(int row = 0; row < 4; row++)
+            modelView.r[row] = FVec4_New(rows[row][0], rows[row][1], rows[row][2], rows[row][3]);
         
         // Update the uniforms
         C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, ProgramWide::uLoc_modelView,  &modelView);
         C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, ProgramWide::uLoc_projection, &projection);
-        const float w = LevelWide::width/2.0f;
-        const float h = LevelWide::height/2.0f;
-        C3D_FVUnifSet(GPU_VERTEX_SHADER, ProgramWide::uLoc_cameraPos, posX + w, w, posZ + h, w);
+        // vertices are around the centre of the window, so it moves them by where the window is on the board as well.
+        // Adding the two here keeps the numbers the shader works with small, whatever the size of the board
+        const Mesh::Layout& layout = LevelWide::layout;
+        C3D_FVUnifSet(GPU_VERTEX_SHADER, ProgramWide::uLoc_cameraPos, posX + layout.centreX(), 0.0f, posZ + layout.centreZ(), 0.0f);
 
         LevelWide::lightPos.x = posX;
         LevelWide::lightPos.z = posZ;
         C3D_LightPosition(&LevelWide::light, &LevelWide::lightPos);
 
-        const int count = LevelWide::vertex_count - ((looking_at_floor ? 0 : 6) + 6);
-        C3D_DrawArrays(GPU_TRIANGLES, 0, count); // terrain + conditionally cursor
+        // {top, bottom, left, right}
+        const int wall_firsts[4] = {
+            layout.topWalls(),
+            layout.bottomWalls(),
+            layout.leftWalls(),
+            layout.rightWalls(),
+        };
+        const int wall_counts[4] = {
+            layout.hasTopWalls() ? layout.width : 0,
+            layout.hasBottomWalls() ? layout.width : 0,
+            layout.hasLeftWalls() ? layout.height : 0,
+            layout.hasRightWalls() ? layout.height : 0,
+        };
+        constexpr float wall_normals[4][2] = {
+            { 0.0f, +1.0f},
+            { 0.0f, -1.0f},
+            {+1.0f,  0.0f},
+            {-1.0f,  0.0f},
+        };
+        for(int side = 0; side < 4; side++)
+        {
+            setNormal(wall_normals[side][0], 0.0f, wall_normals[side][1]);
+            drawQuads(wall_firsts[side], wall_counts[side]);
+        }
+
+        // only the floor chunks this eye can see, one group and its texture at a time, then the cursor
+        setNormal(0.0f, 1.0f, 0.0f);
+        const Culling::View view = Culling::makeView(layout, posX, posZ, camera, iod);
+        for(int group = 0; group < Mesh::FLOOR_GROUPS; group++)
+        {
+            Culling::visibleRanges(view, floor.groups[group], LevelWide::visible_ranges);
+            C3D_TexBind(0, group == 0 ? &ProgramWide::floor_tex : &ProgramWide::repeat_texs[group - 1]);
+            for(const Culling::Range& range : LevelWide::visible_ranges)
+                drawQuads(range.first, range.count);
+        }
+        C3D_TexBind(0, ProgramWide::sprites_tex);
+        if(looking_at_floor)
+            drawQuads(layout.cursor(), 1);
 
         Mtx_Identity(&modelView);
         C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, ProgramWide::uLoc_modelView,  &modelView);
@@ -198,6 +352,7 @@ namespace ThreeD {
         LevelWide::lightPos.z = 0.0f;
         C3D_LightPosition(&LevelWide::light, &LevelWide::lightPos);
 
-        C3D_DrawArrays(GPU_TRIANGLES, LevelWide::vertex_count - 6, 6); // crosshair
+        setNormal(0.0f, 0.0f, 1.0f);
+        drawQuads(layout.crosshair(), 1); // crosshair
     }
 };
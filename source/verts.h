@@ -1,8 +1,11 @@
 #pragma once
 
+#include "camera.h"
 #include "common.h"
+#include "mesh.h"
 
 #include <citro3d.h>
+#include <tex3ds.h>
 
 #define CLEAR_COLOR_TOP 0x68B0D8FF
 #define CLEAR_COLOR_BOT 0xFFC8AAFF
@@ -12,50 +15,37 @@
     GX_TRANSFER_IN_FORMAT(GX_TRANSFER_FMT_RGBA8) | GX_TRANSFER_OUT_FORMAT(GX_TRANSFER_FMT_RGB8) | \
     GX_TRANSFER_SCALING(GX_TRANSFER_SCALE_NO))
 
-struct Vertex {
-    float position[3];
-    float texcoord[2];
-    float norm[3];
-
-    Vertex() : position{0,0,0}, texcoord{0,0}, norm{0,0,1} { }
-    Vertex(C3D_FVec pos, float u, float v, C3D_FVec n)
-    :
-    position{pos.x, pos.y, pos.z},
-    texcoord{u, v},
-    norm{n.x, n.y, n.z}
-    {
-
-    }
-
-    float& x()
-    {
-        return position[0];
-    }
-    float& y()
-    {
-        return position[1];
-    }
-    float& z()
-    {
-        return position[2];
-    }
-};
-
 namespace ProgramWide {
     void init(C3D_Tex* tex);
+    // Draws each {base, overlay} pair of sprites into one tile of the texture the floor is drawn with,
+    // so that a square is a single quad, tile i where Mesh::floorTileUVs(i, count) says.
+    // Tiles repeating[g] also get a texture of their own for the patches of group 1 + g (see Mesh::Floor)
+    void composeFloorTiles(const Tex3DS_SubTexture* const tiles[][2], int count, const int repeating[Mesh::REPEATING]);
     void exit();
 };
 
 namespace LevelWide {
-    void init(size_t count, int w, int h);
-    Vertex* get_floor_verts();
-    Vertex* get_wall_verts();
-    Vertex* get_cursor_verts();
-    Vertex* get_crosshair_verts();
+    // Reserves linear memory for the geometry of any level at once, before anything else can break it up:
+    // every level then takes its own from there (see Arena). false if there isn't that much
+    bool reserve();
+    // bytes of linear memory held for levels, whether one is played or not
+    size_t reserved();
+    // takes the geometry of a window of the board, for the Mesh functions to fill;
+    // false if nothing was reserved and there isn't enough linear memory left for it
+    bool init(const Mesh::Layout& window);
+    // moves the geometry over to another window of the same board, to be filled again
+    void move(const Mesh::Layout& window);
+    const Mesh::Layout& get_layout();
+    Vertex* get_vertices();
+    // gives the geometry back to what's reserved
     void exit();
+    // and what's reserved back to linear memory
+    void release();
 };
 
 namespace ThreeD {
     void bind();
-    void draw(float posX, float posZ, float angleX, float angleY, bool looking_at_floor, float iod);
+    // Raster::draw does the same on the CPU, so that it can be looked at on a host: the two change together
+    // the floor is drawn the way floor has it meshed, group by group
+    void draw(const Mesh::Floor& floor, float posX, float posZ, const Camera::Basis& camera, bool looking_at_floor, float iod);
 };
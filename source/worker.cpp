@@ -0,0 +1,78 @@
+#include "worker.h"
+
+#ifdef _3DS
+#include <3ds.h>
+#else
+#include <thread>
+#endif
+
+namespace {
+    #ifdef _3DS
+    // enough for the flood fills and the solver, which keep their stacks on the heap
+    constexpr size_t STACK_SIZE = 64 * 1024;
+    // how much of the system core the application may use, in percent
+    constexpr u32 SYSCORE_LIMIT = 30;
+
+    Thread spawn(ThreadFunc entry, void* arg)
+    {
+        // below the main thread, so that it keeps its frames when both are on the same core
+        s32 priority = 0x30;
+        svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+        priority = priority < 0x3F ? priority + 1 : priority;
+
+        // the system core first, on which nothing of the game runs, then the application core
+        Thread thread = nullptr;
+        if(R_SUCCEEDED(APT_SetAppCpuTimeLimit(SYSCORE_LIMIT)))
+            thread = threadCreate(entry, arg, STACK_SIZE, priority, 1, false);
+        if(!thread)
+            thread = threadCreate(entry, arg, STACK_SIZE, priority, -2, false);
+        return thread;
+    }
+    #endif
+}
+
+Worker::Worker() : running(false), thread(nullptr) { }
+
+Worker::~Worker()
+{
+    wait();
+}
+
+void Worker::entry(void* arg)
+{
+    Worker* worker = static_cast<Worker*>(arg);
+    worker->job();
+    worker->running.store(false, std::memory_order_release);
+}
+
+void Worker::start(Job next)
+{
+    wait();
+    job = std::move(next);
+    running.store(true, std::memory_order_relaxed);
+
+    #ifdef _3DS
+    thread = spawn(&Worker::entry, this);
+    #else
+    thread = new std::thread(&Worker::entry, this);
+    #endif
+    if(!thread)
+        entry(this);
+}
+
+void Worker::wait()
+{
+    if(!thread)
+        return;
+
+    #ifdef _3DS
+    Thread handle = static_cast<Thread>(thread);
+    threadJoin(handle, U64_MAX);
+    threadFree(handle);
+    #else
+    std::thread* handle = static_cast<std::thread*>(thread);
+    handle->join();
+    delete handle;
+    #endif
+    thread = nullptr;
+}
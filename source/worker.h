@@ -0,0 +1,36 @@
+#pragma once
+
+// A thread to run one job at a time away from the main loop. One of the few files with code for both sides (see Profile too):
+// libctru threads on the 3DS, std::thread anywhere else, so that it runs in the bench (see bench/)
+
+#include <atomic>
+#include <functional>
+
+// The job owns whatever it touches until it's done: the main loop polls done() once a frame,
+// and only then reads what the job wrote.
+struct Worker {
+    using Job = std::function<void()>;
+
+    Worker();
+    ~Worker();
+    Worker(const Worker&) = delete;
+    Worker& operator=(const Worker&) = delete;
+
+    // Waits for the last job, then starts job on the worker thread.
+    // If no thread could be made, job runs right away instead, and is done on return
+    void start(Job job);
+    // The last job started is finished, or there was none
+    bool done() const
+    {
+        return !running.load(std::memory_order_acquire);
+    }
+    // Blocks until the last job started is finished
+    void wait();
+
+private:
+    Job job;
+    std::atomic<bool> running;
+    void* thread; // a libctru Thread, or a std::thread
+
+    static void entry(void* worker);
+};